@@ -3,6 +3,7 @@
 #include <intrin.h>
 
 #include "platform/common_types.h"
+#include "platform/cpu_features.h"
 #include "platform/memory.h"
 #include "platform/m256.h"
 
@@ -41,10 +42,9 @@
 #define C3 0x7DD2D17C4625FA78
 #define C4 0x6BC57DEF56CE8877
 
-#ifdef __AVX512F__
 static __m256i B1, B2, B3, B4, C;
 
-static void initAVX512FourQConstants()
+TARGET_AVX512 static void initAVX512FourQConstants()
 {
 
     B1 = _mm256_set_epi64x(B14, B13, B12, B11);
@@ -53,7 +53,6 @@ static void initAVX512FourQConstants()
     B4 = _mm256_set_epi64x(B44, B43, B42, B41);
     C = _mm256_set_epi64x(C4, C3, C2, C1);
 }
-#endif
 
 typedef unsigned long long felm_t[2]; // Datatype for representing 128-bit field elements
 typedef felm_t f2elm_t[2]; // Datatype for representing quadratic extension field elements
@@ -627,8 +626,8 @@ static void table_lookup_fixed_base(point_precomp_t P, unsigned int digit, unsig
 { // Table lookup to extract a point represented as (x+y,y-x,2t) corresponding to extended twisted Edwards coordinates (X:Y:Z:T) with Z=1
     if (sign)
     {
-        *((__m256i*)P->xy) = *((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->yx);
-        *((__m256i*)P->yx) = *((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->xy);
+        _mm256_storeu_si256((__m256i*)P->xy, _mm256_loadu_si256((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->yx));
+        _mm256_storeu_si256((__m256i*)P->yx, _mm256_loadu_si256((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->xy));
         P->t2[0][0] = ~(((point_precomp_t*)FIXED_BASE_TABLE)[digit])->t2[0][0];
         P->t2[0][1] = 0x7FFFFFFFFFFFFFFF - (((point_precomp_t*)FIXED_BASE_TABLE)[digit])->t2[0][1];
         P->t2[1][0] = ~(((point_precomp_t*)FIXED_BASE_TABLE)[digit])->t2[1][0];
@@ -636,9 +635,9 @@ static void table_lookup_fixed_base(point_precomp_t P, unsigned int digit, unsig
     }
     else
     {
-        *((__m256i*)P->xy) = *((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->xy);
-        *((__m256i*)P->yx) = *((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->yx);
-        *((__m256i*)P->t2) = *((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->t2);
+        _mm256_storeu_si256((__m256i*)P->xy, _mm256_loadu_si256((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->xy));
+        _mm256_storeu_si256((__m256i*)P->yx, _mm256_loadu_si256((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->yx));
+        _mm256_storeu_si256((__m256i*)P->t2, _mm256_loadu_si256((__m256i*)((point_precomp_t*)FIXED_BASE_TABLE)[digit]->t2));
     }
 }
 
@@ -675,8 +674,8 @@ static void Montgomery_multiply_mod_order(const unsigned long long* ma, const un
 
     if (mb[0] == 1 && !mb[1] && !mb[2] && !mb[3])
     {
-        *((__m256i*) & P[0]) = *((__m256i*)ma);
-        *((__m256i*) & P[4]) = _mm256_setzero_si256();
+        _mm256_storeu_si256((__m256i*)&P[0], _mm256_loadu_si256((__m256i*)ma));
+        _mm256_storeu_si256((__m256i*)&P[4], _mm256_setzero_si256());
     }
     else
     {
@@ -706,21 +705,23 @@ static void Montgomery_multiply_mod_order(const unsigned long long* ma, const un
     }
 }
 
-static void eccnorm(point_extproj_t P, point_t Q)
-{ // Normalize a projective point (X1:Y1:Z1), including full reduction
+static void fpinv1271(felm_t a)
+{ // Field inversion, a = a^-1 = a^(p-2) mod p
+    felm_t t;
+
+    fpexp1251(a, t);
+    fpsqr1271(t, t);
+    fpsqr1271(t, t);
+    fpmul1271(a, t, a);
+}
 
-    // Z1 = Z1^-1
-    f2elm_t t1;
-    fpsqr1271(P->z[0], t1[0]);
-    fpsqr1271(P->z[1], t1[1]);
-    fpadd1271(t1[0], t1[1], t1[0]);
-    fpexp1251(t1[0], t1[1]);
-    fpsqr1271(t1[1], t1[1]);
-    fpsqr1271(t1[1], t1[1]);
-    fpmul1271(t1[0], t1[1], t1[0]);
+static void eccnorm_inverted(point_extproj_t P, felm_t normInverse, point_t Q)
+{ // Normalize a projective point (X1:Y1:Z1) given normInverse = (Z1[0]^2 + Z1[1]^2)^-1, including full reduction
+
+    // Z1 = Z1^-1 = conj(Z1) * normInverse
     fpneg1271(P->z[1]);
-    fpmul1271(P->z[0], t1[0], P->z[0]);
-    fpmul1271(P->z[1], t1[0], P->z[1]);
+    fpmul1271(P->z[0], normInverse, P->z[0]);
+    fpmul1271(P->z[1], normInverse, P->z[1]);
 
     fp2mul1271(P->x, P->z, Q->x);          // X1 = X1/Z1
     fp2mul1271(P->y, P->z, Q->y);          // Y1 = Y1/Z1
@@ -730,6 +731,17 @@ static void eccnorm(point_extproj_t P, point_t Q)
     mod1271(Q->y[1]);
 }
 
+static void eccnorm(point_extproj_t P, point_t Q)
+{ // Normalize a projective point (X1:Y1:Z1), including full reduction
+    felm_t t0, t1;
+
+    fpsqr1271(P->z[0], t0);
+    fpsqr1271(P->z[1], t1);
+    fpadd1271(t0, t1, t0);
+    fpinv1271(t0);
+    eccnorm_inverted(P, t0, Q);
+}
+
 static void R1_to_R2(point_extproj_t P, point_extproj_precomp_t Q)
 { // Conversion from representation (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT), where T = Ta*Tb
     fp2add1271(P->ta, P->ta, Q->t2);                  // T = 2*Ta
@@ -745,14 +757,14 @@ static void R1_to_R3(point_extproj_t P, point_extproj_precomp_t Q)
     fp2add1271(P->x, P->y, Q->xy);         // XQ = (X1+Y1) 
     fp2sub1271(P->y, P->x, Q->yx);         // YQ = (Y1-X1) 
     fp2mul1271(P->ta, P->tb, Q->t2);       // TQ = T1
-    *((__m256i*) & Q->z2) = *((__m256i*) & P->z);              // ZQ = Z1 
+    _mm256_storeu_si256((__m256i*)&Q->z2, _mm256_loadu_si256((__m256i*)&P->z));              // ZQ = Z1 
 }
 
 static void R2_to_R4(point_extproj_precomp_t P, point_extproj_t Q)
 { // Conversion from representation (X+Y,Y-X,2Z,2dT) to (2X,2Y,2Z,2dT) 
     fp2sub1271(P->xy, P->yx, Q->x);        // XQ = 2*X1
     fp2add1271(P->xy, P->yx, Q->y);        // YQ = 2*Y1
-    *((__m256i*) & Q->z) = *((__m256i*) & P->z2);              // ZQ = 2*Z1
+    _mm256_storeu_si256((__m256i*)&Q->z, _mm256_loadu_si256((__m256i*)&P->z2));              // ZQ = 2*Z1
 }
 
 static void eccdouble(point_extproj_t P)
@@ -800,10 +812,10 @@ static void eccadd(point_extproj_precomp_t Q, point_extproj_t P)
 
 static void point_setup(point_t P, point_extproj_t Q)
 { // Point conversion to representation (X,Y,Z,Ta,Tb)
-    *((__m256i*) & Q->x) = *((__m256i*) & P->x);
-    *((__m256i*) & Q->y) = *((__m256i*) & P->y);
-    *((__m256i*) & Q->ta) = *((__m256i*) & Q->x);  // Ta = X1
-    *((__m256i*) & Q->tb) = *((__m256i*) & Q->y);  // Tb = Y1
+    _mm256_storeu_si256((__m256i*)&Q->x, _mm256_loadu_si256((__m256i*)&P->x));
+    _mm256_storeu_si256((__m256i*)&Q->y, _mm256_loadu_si256((__m256i*)&P->y));
+    _mm256_storeu_si256((__m256i*)&Q->ta, _mm256_loadu_si256((__m256i*)&Q->x));  // Ta = X1
+    _mm256_storeu_si256((__m256i*)&Q->tb, _mm256_loadu_si256((__m256i*)&Q->y));  // Tb = Y1
     Q->z[0][0] = 1; Q->z[0][1] = 0; Q->z[1][0] = 0; Q->z[1][1] = 0; // Z1 = 1
 }
 
@@ -911,8 +923,8 @@ static void ecc_mul_fixed(unsigned long long* k, point_t Q)
     fp2div1271(R->x);                                               // XQ = x1
     fp2div1271(R->y);                                               // YQ = y1 
     R->z[0][0] = 1; R->z[0][1] = 0; R->z[1][0] = 0; R->z[1][1] = 0; // ZQ = 1
-    *((__m256i*) & R->ta) = *((__m256i*) & R->x);     // TaQ = x1
-    *((__m256i*) & R->tb) = *((__m256i*) & R->y);     // TbQ = y1
+    _mm256_storeu_si256((__m256i*)&R->ta, _mm256_loadu_si256((__m256i*)&R->x));     // TaQ = x1
+    _mm256_storeu_si256((__m256i*)&R->tb, _mm256_loadu_si256((__m256i*)&R->y));     // TbQ = y1
 
     table_lookup_fixed_base(S, 48 + (((((digits[239] << 1) + digits[189]) << 1) + digits[139]) << 1) + digits[89], digits[39]);
     eccmadd(S, R);
@@ -1156,18 +1168,18 @@ static void ecc_phi(point_extproj_t P)
 
 static void eccneg_extproj_precomp(point_extproj_precomp_t P, point_extproj_precomp_t Q)
 { // Point negation
-    *((__m256i*) & Q->t2) = *((__m256i*) & P->t2);
-    *((__m256i*) & Q->yx) = *((__m256i*) & P->xy);
-    *((__m256i*) & Q->xy) = *((__m256i*) & P->yx);
-    *((__m256i*) & Q->z2) = *((__m256i*) & P->z2);
+    _mm256_storeu_si256((__m256i*)&Q->t2, _mm256_loadu_si256((__m256i*)&P->t2));
+    _mm256_storeu_si256((__m256i*)&Q->yx, _mm256_loadu_si256((__m256i*)&P->xy));
+    _mm256_storeu_si256((__m256i*)&Q->xy, _mm256_loadu_si256((__m256i*)&P->yx));
+    _mm256_storeu_si256((__m256i*)&Q->z2, _mm256_loadu_si256((__m256i*)&P->z2));
     fp2neg1271(Q->t2);
 }
 
 static void eccneg_precomp(point_precomp_t P, point_precomp_t Q)
 { // Point negation
-    *((__m256i*) & Q->t2) = *((__m256i*) & P->t2);
-    *((__m256i*) & Q->yx) = *((__m256i*) & P->xy);
-    *((__m256i*) & Q->xy) = *((__m256i*) & P->yx);
+    _mm256_storeu_si256((__m256i*)&Q->t2, _mm256_loadu_si256((__m256i*)&P->t2));
+    _mm256_storeu_si256((__m256i*)&Q->yx, _mm256_loadu_si256((__m256i*)&P->xy));
+    _mm256_storeu_si256((__m256i*)&Q->xy, _mm256_loadu_si256((__m256i*)&P->yx));
     fp2neg1271(Q->t2);
 }
 
@@ -1197,20 +1209,27 @@ static unsigned long long mul_truncate(unsigned long long* s, unsigned long long
     return _addcarry_u64(0, t15, _umul128(s[2], C[1], &high21), &t0) + t16 + high21 + s[1] * C[3] + s[2] * C[2] + s[3] * C[1];
 }
 
-static void decompose(unsigned long long* k, unsigned long long* scalars)
+TARGET_AVX512 static void decompose_AVX512(unsigned long long* k, unsigned long long* scalars)
 { // Scalar decomposition for the variable-base scalar multiplication
     const unsigned long long a1 = mul_truncate(k, (unsigned long long*)ell1);
     const unsigned long long a2 = mul_truncate(k, (unsigned long long*)ell2);
     const unsigned long long a3 = mul_truncate(k, (unsigned long long*)ell3);
     const unsigned long long a4 = mul_truncate(k, (unsigned long long*)ell4);
 
-#ifdef __AVX512F__
-    * ((__m256i*)scalars) = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mullo_epi64(_mm256_set1_epi64x(a1), B1), _mm256_mullo_epi64(_mm256_set1_epi64x(a2), B2)), _mm256_mullo_epi64(_mm256_set1_epi64x(a3), B3)), _mm256_mullo_epi64(_mm256_set1_epi64x(a4), B4)), C);
+    _mm256_storeu_si256((__m256i*)scalars, _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mullo_epi64(_mm256_set1_epi64x(a1), B1), _mm256_mullo_epi64(_mm256_set1_epi64x(a2), B2)), _mm256_mullo_epi64(_mm256_set1_epi64x(a3), B3)), _mm256_mullo_epi64(_mm256_set1_epi64x(a4), B4)), C));
     if (!((scalars[0] += k[0]) & 1))
     {
-        *((__m256i*)scalars) = _mm256_sub_epi64(*((__m256i*)scalars), B4);
+        _mm256_storeu_si256((__m256i*)scalars, _mm256_sub_epi64(_mm256_loadu_si256((__m256i*)scalars), B4));
     }
-#else
+}
+
+static void decompose_Generic(unsigned long long* k, unsigned long long* scalars)
+{ // Scalar decomposition for the variable-base scalar multiplication
+    const unsigned long long a1 = mul_truncate(k, (unsigned long long*)ell1);
+    const unsigned long long a2 = mul_truncate(k, (unsigned long long*)ell2);
+    const unsigned long long a3 = mul_truncate(k, (unsigned long long*)ell3);
+    const unsigned long long a4 = mul_truncate(k, (unsigned long long*)ell4);
+
     scalars[0] = a1 * B11 + a2 * B21 + a3 * B31 + a4 * B41 + C1 + k[0];
     scalars[1] = a1 * B12 + a2 * B22 + a3 * B32 + a4 * B42 + C2;
     scalars[2] = a1 * B13 + a2 * B23 + a3 * B33 + a4 * B43 + C3;
@@ -1222,9 +1241,10 @@ static void decompose(unsigned long long* k, unsigned long long* scalars)
         scalars[2] -= B43;
         scalars[3] -= B44;
     }
-#endif
 }
 
+static void (*decompose)(unsigned long long* k, unsigned long long* scalars) = decompose_Generic;
+
 static void wNAF_recode(unsigned long long scalar, unsigned int w, char* digits)
 { // Computes wNAF recoding of a scalar, where digits are in set {0,+-1,+-3,...,+-(2^(w-1)-1)}
     const int val1 = (int)(1 << (w - 1)) - 1;                           // 2^(w-1) - 1
@@ -1288,16 +1308,9 @@ static void ecc_precomp_double(point_extproj_t P, point_extproj_precomp_t* Table
     R1_to_R2(Q, Table[3]);                  // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
 }
 
-static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
-{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
-  // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
-  // The function uses wNAF with interleaving.
-    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
-    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
-    point_precomp_t V;
-    point_extproj_t Q1, Q2, Q3, Q4, T;
-    point_extproj_precomp_t U, Q_table1[4], Q_table2[4], Q_table3[4], Q_table4[4];
-    unsigned long long k_scalars[4], l_scalars[4];
+static bool ecc_precomp_double_tables(point_t Q, point_extproj_precomp_t Tables[4][4])
+{ // Validation of Q and generation of the tables of Q, Phi(Q), Psi(Q) and Phi(Psi(Q)) used by ecc_mul_double_tables()
+    point_extproj_t Q1, Q2, Q3, Q4;
 
     point_setup(Q, Q1);                                             // Convert to representation (X,Y,1,Ta,Tb)
 
@@ -1307,25 +1320,47 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     }
 
     // Computing endomorphisms over point Q
-    *((__m256i*) & Q2->x) = *((__m256i*) & Q1->x);
-    *((__m256i*) & Q2->y) = *((__m256i*) & Q1->y);
-    *((__m256i*) & Q2->z) = *((__m256i*) & Q1->z);
-    *((__m256i*) & Q2->ta) = *((__m256i*) & Q1->ta);
-    *((__m256i*) & Q2->tb) = *((__m256i*) & Q1->tb);
+    _mm256_storeu_si256((__m256i*)&Q2->x, _mm256_loadu_si256((__m256i*)&Q1->x));
+    _mm256_storeu_si256((__m256i*)&Q2->y, _mm256_loadu_si256((__m256i*)&Q1->y));
+    _mm256_storeu_si256((__m256i*)&Q2->z, _mm256_loadu_si256((__m256i*)&Q1->z));
+    _mm256_storeu_si256((__m256i*)&Q2->ta, _mm256_loadu_si256((__m256i*)&Q1->ta));
+    _mm256_storeu_si256((__m256i*)&Q2->tb, _mm256_loadu_si256((__m256i*)&Q1->tb));
     ecc_phi(Q2);
-    *((__m256i*) & Q3->x) = *((__m256i*) & Q1->x);
-    *((__m256i*) & Q3->y) = *((__m256i*) & Q1->y);
-    *((__m256i*) & Q3->z) = *((__m256i*) & Q1->z);
-    *((__m256i*) & Q3->ta) = *((__m256i*) & Q1->ta);
-    *((__m256i*) & Q3->tb) = *((__m256i*) & Q1->tb);
+    _mm256_storeu_si256((__m256i*)&Q3->x, _mm256_loadu_si256((__m256i*)&Q1->x));
+    _mm256_storeu_si256((__m256i*)&Q3->y, _mm256_loadu_si256((__m256i*)&Q1->y));
+    _mm256_storeu_si256((__m256i*)&Q3->z, _mm256_loadu_si256((__m256i*)&Q1->z));
+    _mm256_storeu_si256((__m256i*)&Q3->ta, _mm256_loadu_si256((__m256i*)&Q1->ta));
+    _mm256_storeu_si256((__m256i*)&Q3->tb, _mm256_loadu_si256((__m256i*)&Q1->tb));
     ecc_psi(Q3);
-    *((__m256i*) & Q4->x) = *((__m256i*) & Q2->x);
-    *((__m256i*) & Q4->y) = *((__m256i*) & Q2->y);
-    *((__m256i*) & Q4->z) = *((__m256i*) & Q2->z);
-    *((__m256i*) & Q4->ta) = *((__m256i*) & Q2->ta);
-    *((__m256i*) & Q4->tb) = *((__m256i*) & Q2->tb);
+    _mm256_storeu_si256((__m256i*)&Q4->x, _mm256_loadu_si256((__m256i*)&Q2->x));
+    _mm256_storeu_si256((__m256i*)&Q4->y, _mm256_loadu_si256((__m256i*)&Q2->y));
+    _mm256_storeu_si256((__m256i*)&Q4->z, _mm256_loadu_si256((__m256i*)&Q2->z));
+    _mm256_storeu_si256((__m256i*)&Q4->ta, _mm256_loadu_si256((__m256i*)&Q2->ta));
+    _mm256_storeu_si256((__m256i*)&Q4->tb, _mm256_loadu_si256((__m256i*)&Q2->tb));
     ecc_psi(Q4);
 
+    ecc_precomp_double(Q1, Tables[0]);
+    ecc_precomp_double(Q2, Tables[1]);
+    ecc_precomp_double(Q3, Tables[2]);
+    ecc_precomp_double(Q4, Tables[3]);
+
+    return true;
+}
+
+static void ecc_mul_double_tables(unsigned long long* k, unsigned long long* l, point_extproj_precomp_t Tables[4][4], point_extproj_t T)
+{ // Double scalar multiplication T = k*G + l*Q, where the G is the generator and Tables are generated from Q by ecc_precomp_double_tables()
+  // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
+  // The function uses wNAF with interleaving, T is left in projective representation.
+    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
+    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
+    point_precomp_t V;
+    point_extproj_precomp_t U;
+    point_extproj_precomp_t* Q_table1 = Tables[0];
+    point_extproj_precomp_t* Q_table2 = Tables[1];
+    point_extproj_precomp_t* Q_table3 = Tables[2];
+    point_extproj_precomp_t* Q_table4 = Tables[3];
+    unsigned long long k_scalars[4], l_scalars[4];
+
     decompose((unsigned long long*)k, k_scalars);                   // Scalar decomposition
     decompose((unsigned long long*)l, l_scalars);
     wNAF_recode(k_scalars[0], 8, digits_k1);                        // Scalar recoding
@@ -1336,10 +1371,6 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     wNAF_recode(l_scalars[1], 4, digits_l2);
     wNAF_recode(l_scalars[2], 4, digits_l3);
     wNAF_recode(l_scalars[3], 4, digits_l4);
-    ecc_precomp_double(Q1, Q_table1);
-    ecc_precomp_double(Q2, Q_table2);
-    ecc_precomp_double(Q3, Q_table3);
-    ecc_precomp_double(Q4, Q_table4);
 
     T->x[0][0] = 0; T->x[0][1] = 0; T->x[1][0] = 0; T->x[1][1] = 0; // Initialize T as the neutral point (0:1:1)
     T->y[0][0] = 1; T->y[0][1] = 0; T->y[1][0] = 0; T->y[1][1] = 0;
@@ -1429,23 +1460,445 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
             eccmadd(((point_precomp_t*)&DOUBLE_SCALAR_TABLE)[3 * 64 + ((digits_k4[i]) >> 1)], T);
         }
     }
+}
+
+static bool ecc_mul_double_extproj(unsigned long long* k, unsigned long long* l, point_t Q, point_extproj_t T)
+{ // Double scalar multiplication T = k*G + l*Q, where the G is the generator, T is left in projective representation
+    point_extproj_precomp_t Tables[4][4];
+
+    if (!ecc_precomp_double_tables(Q, Tables))
+    {
+        return false;
+    }
+    ecc_mul_double_tables(k, l, Tables, T);
+
+    return true;
+}
 
+static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
+{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
+    point_extproj_t T;
+
+    if (!ecc_mul_double_extproj(k, l, Q, T))
+    {
+        return false;
+    }
     eccnorm(T, Q);
 
     return true;
 }
 
+// 8-way FourQ arithmetic with AVX-512 IFMA: every 64-bit lane of the vectors belongs to another point, so that the double scalar
+// multiplications of 8 signatures run in lockstep. Elements of GF(p) are kept in three 43-bit limbs (2^129 = 4 mod p). Limbs are
+// below 2^44 after carry propagation and below 2^48 in the operands of multiplications, which keeps the 52-bit products of
+// vpmadd52luq/vpmadd52huq exact and their sums below 2^64.
+#define FP_8X_LIMB_MASK 0x7FFFFFFFFFFULL
+
+typedef __m512i felm_8x_t[3];
+typedef felm_8x_t f2elm_8x_t[2];
+
+typedef struct
+{ // 8 points in extended coordinates, see point_extproj
+    f2elm_8x_t x;
+    f2elm_8x_t y;
+    f2elm_8x_t z;
+    f2elm_8x_t ta;
+    f2elm_8x_t tb;
+} point_extproj_8x;
+typedef point_extproj_8x point_extproj_8x_t[1];
+
+typedef struct
+{ // 8 points in extended coordinates for precomputed points, see point_extproj_precomp
+    f2elm_8x_t xy;
+    f2elm_8x_t yx;
+    f2elm_8x_t z2;
+    f2elm_8x_t t2;
+} point_extproj_precomp_8x;
+typedef point_extproj_precomp_8x point_extproj_precomp_8x_t[1];
+
+TARGET_AVX512_IFMA static void fpcarry1271_8x(felm_8x_t a)
+{ // Carry propagation, limbs of a are below 2^44 afterwards
+    const __m512i mask = _mm512_set1_epi64(FP_8X_LIMB_MASK);
+
+    a[1] = _mm512_add_epi64(a[1], _mm512_srli_epi64(a[0], 43));
+    a[0] = _mm512_and_si512(a[0], mask);
+    a[2] = _mm512_add_epi64(a[2], _mm512_srli_epi64(a[1], 43));
+    a[1] = _mm512_and_si512(a[1], mask);
+    a[0] = _mm512_add_epi64(a[0], _mm512_slli_epi64(_mm512_srli_epi64(a[2], 43), 2));
+    a[2] = _mm512_and_si512(a[2], mask);
+}
+
+TARGET_AVX512_IFMA static void fpadd1271_8x(felm_8x_t a, felm_8x_t b, felm_8x_t c)
+{ // Field addition, c = a+b mod (2^127-1)
+    c[0] = _mm512_add_epi64(a[0], b[0]);
+    c[1] = _mm512_add_epi64(a[1], b[1]);
+    c[2] = _mm512_add_epi64(a[2], b[2]);
+    fpcarry1271_8x(c);
+}
+
+TARGET_AVX512_IFMA static void fpsub1271_8x(felm_8x_t a, felm_8x_t b, felm_8x_t c)
+{ // Field subtraction, c = a-b mod (2^127-1), computed as a+32p-b with 32p = (2^46-32, 2^46-8, 2^46-8) so that no limb gets negative
+    c[0] = _mm512_sub_epi64(_mm512_add_epi64(a[0], _mm512_set1_epi64(0x3FFFFFFFFFE0)), b[0]);
+    c[1] = _mm512_sub_epi64(_mm512_add_epi64(a[1], _mm512_set1_epi64(0x3FFFFFFFFFF8)), b[1]);
+    c[2] = _mm512_sub_epi64(_mm512_add_epi64(a[2], _mm512_set1_epi64(0x3FFFFFFFFFF8)), b[2]);
+    fpcarry1271_8x(c);
+}
+
+TARGET_AVX512_IFMA static void fpaddlazy1271_8x(felm_8x_t a, felm_8x_t b, felm_8x_t c)
+{ // Field addition without carry propagation, limbs of c are below 2^46 if the limbs of a and b are below 2^45
+  // c may only be multiplied or subtracted from another element
+    c[0] = _mm512_add_epi64(a[0], b[0]);
+    c[1] = _mm512_add_epi64(a[1], b[1]);
+    c[2] = _mm512_add_epi64(a[2], b[2]);
+}
+
+TARGET_AVX512_IFMA static void fpsublazy1271_8x(felm_8x_t a, felm_8x_t b, felm_8x_t c)
+{ // Field subtraction without carry propagation, limbs of c are below 2^47 if a is below 2^46 and b below 2^45
+  // c may only be multiplied or subtracted from
+    c[0] = _mm512_sub_epi64(_mm512_add_epi64(a[0], _mm512_set1_epi64(0x3FFFFFFFFFE0)), b[0]);
+    c[1] = _mm512_sub_epi64(_mm512_add_epi64(a[1], _mm512_set1_epi64(0x3FFFFFFFFFF8)), b[1]);
+    c[2] = _mm512_sub_epi64(_mm512_add_epi64(a[2], _mm512_set1_epi64(0x3FFFFFFFFFF8)), b[2]);
+}
+
+TARGET_AVX512_IFMA static void fpneg1271_8x(felm_8x_t a)
+{ // Field negation, a = -a mod (2^127-1)
+    a[0] = _mm512_sub_epi64(_mm512_set1_epi64(0x3FFFFFFFFFE0), a[0]);
+    a[1] = _mm512_sub_epi64(_mm512_set1_epi64(0x3FFFFFFFFFF8), a[1]);
+    a[2] = _mm512_sub_epi64(_mm512_set1_epi64(0x3FFFFFFFFFF8), a[2]);
+    fpcarry1271_8x(a);
+}
+
+TARGET_AVX512_IFMA static void fpmul1271_8x(felm_8x_t a, felm_8x_t b, felm_8x_t c)
+{ // Field multiplication, c = a*b mod (2^127-1)
+  // The products of limbs i+j >= 3 wrap around with the factor 4, the high halves of the products land 52 bits = 43+9 bits above their low halves
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i a1x4 = _mm512_slli_epi64(a[1], 2);
+    const __m512i a2x4 = _mm512_slli_epi64(a[2], 2);
+
+    __m512i lo0 = _mm512_madd52lo_epu64(zero, a[0], b[0]);
+    lo0 = _mm512_madd52lo_epu64(lo0, a1x4, b[2]);
+    lo0 = _mm512_madd52lo_epu64(lo0, a2x4, b[1]);
+    __m512i lo1 = _mm512_madd52lo_epu64(zero, a[0], b[1]);
+    lo1 = _mm512_madd52lo_epu64(lo1, a[1], b[0]);
+    lo1 = _mm512_madd52lo_epu64(lo1, a2x4, b[2]);
+    __m512i lo2 = _mm512_madd52lo_epu64(zero, a[0], b[2]);
+    lo2 = _mm512_madd52lo_epu64(lo2, a[1], b[1]);
+    lo2 = _mm512_madd52lo_epu64(lo2, a[2], b[0]);
+
+    __m512i hi0 = _mm512_madd52hi_epu64(zero, a[0], b[2]); // Lands at limb 3, i.e. 4 * 2^9 above limb 0
+    hi0 = _mm512_madd52hi_epu64(hi0, a[1], b[1]);
+    hi0 = _mm512_madd52hi_epu64(hi0, a[2], b[0]);
+    __m512i hi1 = _mm512_madd52hi_epu64(zero, a[0], b[0]);
+    hi1 = _mm512_madd52hi_epu64(hi1, a1x4, b[2]);
+    hi1 = _mm512_madd52hi_epu64(hi1, a2x4, b[1]);
+    __m512i hi2 = _mm512_madd52hi_epu64(zero, a[0], b[1]);
+    hi2 = _mm512_madd52hi_epu64(hi2, a[1], b[0]);
+    hi2 = _mm512_madd52hi_epu64(hi2, a2x4, b[2]);
+
+    c[0] = _mm512_add_epi64(lo0, _mm512_slli_epi64(hi0, 11));
+    c[1] = _mm512_add_epi64(lo1, _mm512_slli_epi64(hi1, 9));
+    c[2] = _mm512_add_epi64(lo2, _mm512_slli_epi64(hi2, 9));
+    fpcarry1271_8x(c);
+}
+
+TARGET_AVX512_IFMA static void fp2neg1271_8x(f2elm_8x_t a)
+{ // GF(p^2) negation, a = -a in GF((2^127-1)^2)
+    fpneg1271_8x(a[0]);
+    fpneg1271_8x(a[1]);
+}
+
+TARGET_AVX512_IFMA static void fp2sqr1271_8x(f2elm_8x_t a, f2elm_8x_t c)
+{ // GF(p^2) squaring, c = a^2 in GF((2^127-1)^2)
+    felm_8x_t t1, t2, t3;
+
+    fpaddlazy1271_8x(a[0], a[1], t1);       // t1 = a0+a1
+    fpsublazy1271_8x(a[0], a[1], t2);       // t2 = a0-a1
+    fpmul1271_8x(a[0], a[1], t3);           // t3 = a0*a1
+    fpmul1271_8x(t1, t2, c[0]);             // c0 = (a0+a1)(a0-a1)
+    fpadd1271_8x(t3, t3, c[1]);             // c1 = 2a0*a1
+}
+
+TARGET_AVX512_IFMA static void fp2mul1271_8x(f2elm_8x_t a, f2elm_8x_t b, f2elm_8x_t c)
+{ // GF(p^2) multiplication, c = a*b in GF((2^127-1)^2)
+    felm_8x_t t1, t2, t3, t4;
+
+    fpmul1271_8x(a[0], b[0], t1);          // t1 = a0*b0
+    fpmul1271_8x(a[1], b[1], t2);          // t2 = a1*b1
+    fpaddlazy1271_8x(a[0], a[1], t3);      // t3 = a0+a1
+    fpaddlazy1271_8x(b[0], b[1], t4);      // t4 = b0+b1
+    fpsub1271_8x(t1, t2, c[0]);            // c[0] = a0*b0 - a1*b1
+    fpmul1271_8x(t3, t4, t3);              // t3 = (a0+a1)*(b0+b1)
+    fpsublazy1271_8x(t3, t1, t3);          // t3 = (a0+a1)*(b0+b1) - a0*b0
+    fpsub1271_8x(t3, t2, c[1]);            // c[1] = (a0+a1)*(b0+b1) - a0*b0 - a1*b1
+}
+
+TARGET_AVX512_IFMA static void fp2add1271_8x(f2elm_8x_t a, f2elm_8x_t b, f2elm_8x_t c)
+{ // GF(p^2) addition, c = a+b in GF((2^127-1)^2)
+    fpadd1271_8x(a[0], b[0], c[0]);
+    fpadd1271_8x(a[1], b[1], c[1]);
+}
+
+TARGET_AVX512_IFMA static void fp2sub1271_8x(f2elm_8x_t a, f2elm_8x_t b, f2elm_8x_t c)
+{ // GF(p^2) subtraction, c = a-b in GF((2^127-1)^2)
+    fpsub1271_8x(a[0], b[0], c[0]);
+    fpsub1271_8x(a[1], b[1], c[1]);
+}
+
+TARGET_AVX512_IFMA static void fp2addlazy1271_8x(f2elm_8x_t a, f2elm_8x_t b, f2elm_8x_t c)
+{ // GF(p^2) addition without carry propagation, see fpaddlazy1271_8x()
+    fpaddlazy1271_8x(a[0], b[0], c[0]);
+    fpaddlazy1271_8x(a[1], b[1], c[1]);
+}
+
+TARGET_AVX512_IFMA static void fp2sublazy1271_8x(f2elm_8x_t a, f2elm_8x_t b, f2elm_8x_t c)
+{ // GF(p^2) subtraction without carry propagation, see fpsublazy1271_8x()
+    fpsublazy1271_8x(a[0], b[0], c[0]);
+    fpsublazy1271_8x(a[1], b[1], c[1]);
+}
+
+TARGET_AVX512_IFMA static void fp2addsub1271_8x(f2elm_8x_t a, f2elm_8x_t b, f2elm_8x_t c)
+{ // GF(p^2) addition followed by subtraction, c = 2a-b in GF((2^127-1)^2) without carry propagation
+    fp2addlazy1271_8x(a, a, a);
+    fp2sublazy1271_8x(a, b, c);
+}
+
+TARGET_AVX512_IFMA static void fp2copy1271_8x(__mmask8 mask, f2elm_8x_t a, f2elm_8x_t c)
+{ // c = a in the lanes selected by mask
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        for (unsigned int j = 0; j < 3; j++)
+        {
+            c[i][j] = _mm512_mask_mov_epi64(c[i][j], mask, a[i][j]);
+        }
+    }
+}
+
+TARGET_AVX512_IFMA static void fp2set1271_8x(unsigned long long value, f2elm_8x_t c)
+{ // c = value in all lanes, value < 2^43
+    c[0][0] = _mm512_set1_epi64(value);
+    c[0][1] = _mm512_setzero_si512();
+    c[0][2] = _mm512_setzero_si512();
+    c[1][0] = _mm512_setzero_si512();
+    c[1][1] = _mm512_setzero_si512();
+    c[1][2] = _mm512_setzero_si512();
+}
+
+TARGET_AVX512_IFMA static void fp2load1271_8x(__m512i addresses, f2elm_8x_t c)
+{ // Gathers the f2elm_t stored at the addresses of the lanes
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        const __m512i a0 = _mm512_i64gather_epi64(addresses, (const void*)(i * sizeof(felm_t)), 1);
+        const __m512i a1 = _mm512_i64gather_epi64(addresses, (const void*)(i * sizeof(felm_t) + 8), 1);
+        c[i][0] = _mm512_and_si512(a0, _mm512_set1_epi64(FP_8X_LIMB_MASK));
+        c[i][1] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(a0, 43), _mm512_slli_epi64(a1, 21)), _mm512_set1_epi64(FP_8X_LIMB_MASK));
+        c[i][2] = _mm512_srli_epi64(a1, 22);
+    }
+}
+
+TARGET_AVX512_IFMA static void fp2store1271_8x(f2elm_8x_t a, unsigned int numberOfLanes, f2elm_t* c)
+{ // Conversion of the first numberOfLanes lanes of a to f2elm_t, c[lane] is partially reduced (below 2^127)
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        unsigned long long limbs[3][8];
+        _mm512_storeu_si512(limbs[0], a[i][0]);
+        _mm512_storeu_si512(limbs[1], a[i][1]);
+        _mm512_storeu_si512(limbs[2], a[i][2]);
+        for (unsigned int lane = 0; lane < numberOfLanes; lane++)
+        {
+            unsigned long long low, high;
+            const unsigned char carry = _addcarry_u64(_addcarry_u64(0, limbs[0][lane], limbs[1][lane] << 43, &low), limbs[1][lane] >> 21, limbs[2][lane] << 22, &high);
+            const unsigned long long top = ((limbs[2][lane] >> 42) + carry) * 2 + (high >> 63); // 2^128 = 2 and 2^127 = 1 mod p
+            _addcarry_u64(_addcarry_u64(0, low, top, &c[lane][i][0]), high & 0x7FFFFFFFFFFFFFFF, 0, &c[lane][i][1]);
+            mod1271(c[lane][i]);
+        }
+    }
+}
+
+TARGET_AVX512_IFMA static void eccdouble_8x(point_extproj_8x_t P)
+{ // Point doubling 2P
+    f2elm_8x_t t1, t2;
+
+  // Ta and Tb are only multiplied later, so they and the operands of multiplications skip the carry propagation
+    fp2sqr1271_8x(P->x, t1);                  // t1 = X1^2
+    fp2sqr1271_8x(P->y, t2);                  // t2 = Y1^2
+    fp2addlazy1271_8x(P->x, P->y, P->x);      // t3 = X1+Y1
+    fp2addlazy1271_8x(t1, t2, P->tb);         // Tbfinal = X1^2+Y1^2
+    fp2sub1271_8x(t2, t1, t1);                // t1 = Y1^2-X1^2
+    fp2sqr1271_8x(P->x, P->ta);               // Ta = (X1+Y1)^2
+    fp2sqr1271_8x(P->z, t2);                  // t2 = Z1^2
+    fp2sublazy1271_8x(P->ta, P->tb, P->ta);   // Tafinal = 2X1*Y1 = (X1+Y1)^2-(X1^2+Y1^2)
+    fp2addsub1271_8x(t2, t1, t2);             // t2 = 2Z1^2-(Y1^2-X1^2)
+    fp2mul1271_8x(t1, P->tb, P->y);           // Yfinal = (X1^2+Y1^2)(Y1^2-X1^2)
+    fp2mul1271_8x(t2, P->ta, P->x);           // Xfinal = 2X1*Y1*[2Z1^2-(Y1^2-X1^2)]
+    fp2mul1271_8x(t1, t2, P->z);              // Zfinal = (Y1^2-X1^2)[2Z1^2-(Y1^2-X1^2)]
+}
+
+TARGET_AVX512_IFMA static void eccadd_8x(point_extproj_precomp_8x_t Q, point_extproj_8x_t P)
+{ // Complete point addition P = P+Q or P = P+P, see R1_to_R3() and eccadd_core()
+    f2elm_8x_t t1, t2, xy, yx;
+
+    fp2addlazy1271_8x(P->x, P->y, xy);        // XY = X1+Y1
+    fp2sublazy1271_8x(P->y, P->x, yx);        // YX = Y1-X1
+    fp2mul1271_8x(P->ta, P->tb, t2);          // t2 = T1
+    fp2mul1271_8x(Q->t2, t2, t2);             // t2 = 2dT1*T2
+    fp2mul1271_8x(Q->z2, P->z, t1);           // t1 = 2Z1*Z2
+    fp2mul1271_8x(Q->xy, xy, P->x);           // X = (X1+Y1)(X2+Y2)
+    fp2mul1271_8x(Q->yx, yx, P->y);           // Y = (Y1-X1)(Y2-X2)
+    fp2sublazy1271_8x(t1, t2, xy);            // xy = theta
+    fp2addlazy1271_8x(t1, t2, t1);            // t1 = alpha
+    fp2sublazy1271_8x(P->x, P->y, P->tb);     // Tbfinal = beta
+    fp2addlazy1271_8x(P->x, P->y, P->ta);     // Tafinal = omega
+    fp2mul1271_8x(P->tb, xy, P->x);           // Xfinal = beta*theta
+    fp2mul1271_8x(t1, xy, P->z);              // Zfinal = theta*alpha
+    fp2mul1271_8x(P->ta, t1, P->y);           // Yfinal = alpha*omega
+}
+
+TARGET_AVX512_IFMA static void table_lookup_8x(__m512i addresses, __mmask8 affine, __mmask8 negative, __mmask8 neutral, point_extproj_precomp_8x_t P)
+{ // Gathers the point_extproj_precomp_t stored at the addresses of the lanes, or the point_precomp_t with Z = 1 in the affine lanes
+  // The entries are negated in the negative lanes and replaced by the neutral point (1,1,2,0) in the neutral lanes
+    f2elm_8x_t t;
+
+    fp2load1271_8x(addresses, P->xy);
+    fp2load1271_8x(_mm512_add_epi64(addresses, _mm512_set1_epi64(sizeof(f2elm_t))), P->yx);
+    fp2load1271_8x(_mm512_add_epi64(addresses, _mm512_set1_epi64(2 * sizeof(f2elm_t))), P->z2);
+    fp2load1271_8x(_mm512_mask_add_epi64(_mm512_add_epi64(addresses, _mm512_set1_epi64(3 * sizeof(f2elm_t))), affine, addresses, _mm512_set1_epi64(2 * sizeof(f2elm_t))), P->t2);
+    fp2set1271_8x(2, t);
+    fp2copy1271_8x(affine, t, P->z2);
+
+    // Negation swaps X+Y and Y-X and negates 2dT
+    fp2copy1271_8x(0xFF, P->xy, t);
+    fp2copy1271_8x(negative, P->yx, P->xy);
+    fp2copy1271_8x(negative, t, P->yx);
+    fp2copy1271_8x(0xFF, P->t2, t);
+    fp2neg1271_8x(t);
+    fp2copy1271_8x(negative, t, P->t2);
+
+    fp2set1271_8x(1, t);
+    fp2copy1271_8x(neutral, t, P->xy);
+    fp2copy1271_8x(neutral, t, P->yx);
+    fp2set1271_8x(2, t);
+    fp2copy1271_8x(neutral, t, P->z2);
+    fp2set1271_8x(0, t);
+    fp2copy1271_8x(neutral, t, P->t2);
+}
+
+TARGET_AVX512_IFMA static void ecc_mul_double_tables_8x_IFMA(unsigned long long* const* k, unsigned long long* const* l, point_extproj_precomp_t (* const* tables)[4], unsigned int numberOfLanes, point_extproj_t* T)
+{ // T[lane] = k[lane]*G + l[lane]*Q[lane] for up to 8 lanes, the same as ecc_mul_double_tables(k[lane], l[lane], tables[lane], T[lane])
+  // The lanes double in lockstep. After each doubling every lane adds the table entries of its nonzero wNAF digits one per step,
+  // lanes with fewer nonzero digits than the busiest lane add the neutral point. Unused lanes repeat lane 0.
+    char digits[8][8][65]; // Lane, then the digits of the l scalars (using the tables of Q) and of the k scalars (using DOUBLE_SCALAR_TABLE)
+    unsigned long long tableAddresses[8][8];
+    point_extproj_8x_t T8;
+    point_extproj_precomp_8x_t U;
+
+    for (unsigned int lane = 0; lane < 8; lane++)
+    {
+        const unsigned int source = lane < numberOfLanes ? lane : 0;
+        unsigned long long k_scalars[4], l_scalars[4];
+
+        decompose(k[source], k_scalars);
+        decompose(l[source], l_scalars);
+        for (unsigned int j = 0; j < 4; j++)
+        {
+            wNAF_recode(l_scalars[j], 4, digits[lane][j]);
+            wNAF_recode(k_scalars[j], 8, digits[lane][4 + j]);
+            tableAddresses[lane][j] = (unsigned long long)tables[source][j];
+            tableAddresses[lane][4 + j] = (unsigned long long)&((point_precomp_t*)&DOUBLE_SCALAR_TABLE)[j * 64];
+        }
+    }
+
+    fp2set1271_8x(0, T8->x);                  // Initialize T as the neutral point (0:1:1)
+    fp2set1271_8x(1, T8->y);
+    fp2set1271_8x(1, T8->z);
+    fp2set1271_8x(0, T8->ta);
+    fp2set1271_8x(0, T8->tb);
+
+    for (unsigned int i = 65; i--; )
+    {
+        eccdouble_8x(T8);
+
+        unsigned long long entryAddresses[8][8]; // Step, then lane
+        unsigned char affine[8] = { 0 }, negative[8] = { 0 }, neutral[8] = { 0 }; // Masks of the lanes
+        unsigned int numberOfSteps = 0;
+        for (unsigned int lane = 0; lane < 8; lane++)
+        {
+            unsigned int step = 0;
+            for (unsigned int j = 0; j < 8; j++)
+            {
+                const int digit = digits[lane][j][i];
+                if (digit)
+                {
+                    const unsigned int entrySize = j < 4 ? sizeof(point_extproj_precomp) : sizeof(point_precomp);
+                    entryAddresses[step][lane] = tableAddresses[lane][j] + ((digit < 0 ? -digit : digit) >> 1) * entrySize;
+                    affine[step] |= (j >= 4) << lane;
+                    negative[step] |= (digit < 0) << lane;
+                    step++;
+                }
+            }
+            for (unsigned int j = 0; j < 8; j++)
+            {
+                if (j >= step)
+                {
+                    entryAddresses[j][lane] = (unsigned long long)&DOUBLE_SCALAR_TABLE;
+                    affine[j] |= 1 << lane;
+                    neutral[j] |= 1 << lane;
+                }
+            }
+            if (step > numberOfSteps)
+            {
+                numberOfSteps = step;
+            }
+        }
+
+        for (unsigned int step = 0; step < numberOfSteps; step++)
+        {
+            table_lookup_8x(_mm512_loadu_si512(entryAddresses[step]), affine[step], negative[step], neutral[step], U);
+            eccadd_8x(U, T8);
+        }
+    }
+
+    f2elm_t coordinates[8];
+    fp2store1271_8x(T8->x, numberOfLanes, coordinates);
+    for (unsigned int lane = 0; lane < numberOfLanes; lane++) _mm256_storeu_si256((__m256i*)&T[lane]->x, _mm256_loadu_si256((__m256i*)&coordinates[lane]));
+    fp2store1271_8x(T8->y, numberOfLanes, coordinates);
+    for (unsigned int lane = 0; lane < numberOfLanes; lane++) _mm256_storeu_si256((__m256i*)&T[lane]->y, _mm256_loadu_si256((__m256i*)&coordinates[lane]));
+    fp2store1271_8x(T8->z, numberOfLanes, coordinates);
+    for (unsigned int lane = 0; lane < numberOfLanes; lane++) _mm256_storeu_si256((__m256i*)&T[lane]->z, _mm256_loadu_si256((__m256i*)&coordinates[lane]));
+    fp2store1271_8x(T8->ta, numberOfLanes, coordinates);
+    for (unsigned int lane = 0; lane < numberOfLanes; lane++) _mm256_storeu_si256((__m256i*)&T[lane]->ta, _mm256_loadu_si256((__m256i*)&coordinates[lane]));
+    fp2store1271_8x(T8->tb, numberOfLanes, coordinates);
+    for (unsigned int lane = 0; lane < numberOfLanes; lane++) _mm256_storeu_si256((__m256i*)&T[lane]->tb, _mm256_loadu_si256((__m256i*)&coordinates[lane]));
+}
+
+// NULL if the CPU lacks AVX-512 IFMA, verifyBatch() then uses ecc_mul_double_tables() for every signature
+static void (*ecc_mul_double_tables_8x)(unsigned long long* const* k, unsigned long long* const* l, point_extproj_precomp_t (* const* tables)[4], unsigned int numberOfLanes, point_extproj_t* T) = NULL;
+
+// Binds the FourQ kernels to the fastest variants the CPU supports, cpuFeatures must be set before
+static void selectFourQKernels()
+{
+    if (cpuFeatures.avx512)
+    {
+        initAVX512FourQConstants();
+        decompose = decompose_AVX512;
+    }
+    else
+    {
+        decompose = decompose_Generic;
+    }
+    ecc_mul_double_tables_8x = cpuFeatures.avx512Ifma ? ecc_mul_double_tables_8x_IFMA : NULL;
+}
+
 static void ecc_precomp(point_extproj_t P, point_extproj_precomp_t* T)
 { // Generation of the precomputation table used by the variable-base scalar multiplication ecc_mul()
     point_extproj_precomp_t Q, R, S;
     point_extproj_t PP;
 
     // Generating Q = phi(P) = (XQ+YQ,YQ-XQ,ZQ,TQ)
-    *((__m256i*) & PP->x) = *((__m256i*) & P->x);
-    *((__m256i*) & PP->y) = *((__m256i*) & P->y);
-    *((__m256i*) & PP->z) = *((__m256i*) & P->z);
-    *((__m256i*) & PP->ta) = *((__m256i*) & P->ta);
-    *((__m256i*) & PP->tb) = *((__m256i*) & P->tb);
+    _mm256_storeu_si256((__m256i*)&PP->x, _mm256_loadu_si256((__m256i*)&P->x));
+    _mm256_storeu_si256((__m256i*)&PP->y, _mm256_loadu_si256((__m256i*)&P->y));
+    _mm256_storeu_si256((__m256i*)&PP->z, _mm256_loadu_si256((__m256i*)&P->z));
+    _mm256_storeu_si256((__m256i*)&PP->ta, _mm256_loadu_si256((__m256i*)&P->ta));
+    _mm256_storeu_si256((__m256i*)&PP->tb, _mm256_loadu_si256((__m256i*)&P->tb));
     ecc_phi(PP);
     R1_to_R3(PP, Q);                       // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,Z,T) 
 
@@ -1534,10 +1987,10 @@ static bool ecc_mul(point_t P, unsigned long long* k, point_t Q)
     ecc_precomp(R, Table[1]);                                 // Precomputation
     for (unsigned int i = 0; i < 8; i++)
     {
-        *((__m256i*)Table[0][i]->xy) = *((__m256i*)Table[1][i]->yx);
-        *((__m256i*)Table[0][i]->yx) = *((__m256i*)Table[1][i]->xy);
-        *((__m256i*)Table[0][i]->t2) = *((__m256i*)Table[1][i]->t2);
-        *((__m256i*)Table[0][i]->z2) = *((__m256i*)Table[1][i]->z2);
+        _mm256_storeu_si256((__m256i*)Table[0][i]->xy, _mm256_loadu_si256((__m256i*)Table[1][i]->yx));
+        _mm256_storeu_si256((__m256i*)Table[0][i]->yx, _mm256_loadu_si256((__m256i*)Table[1][i]->xy));
+        _mm256_storeu_si256((__m256i*)Table[0][i]->t2, _mm256_loadu_si256((__m256i*)Table[1][i]->t2));
+        _mm256_storeu_si256((__m256i*)Table[0][i]->z2, _mm256_loadu_si256((__m256i*)Table[1][i]->z2));
         fp2neg1271(Table[0][i]->t2);
     }
     R2_to_R4(Table[1][scalars[1] + (scalars[2] << 1) + (scalars[3] << 2)], R);
@@ -1557,7 +2010,7 @@ static void encode(point_t P, unsigned char* Pencoded)
     const unsigned long long temp1 = (P->x[1][1] & 0x4000000000000000) << 1;
     const unsigned long long temp2 = (P->x[0][1] & 0x4000000000000000) << 1;
 
-    *((__m256i*)Pencoded) = *((__m256i*)P->y);
+    _mm256_storeu_si256((__m256i*)Pencoded, _mm256_loadu_si256((__m256i*)P->y));
     if (!P->x[0][0] && !P->x[0][1])
     {
         ((unsigned long long*)Pencoded)[3] |= temp1;
@@ -1575,7 +2028,7 @@ static bool decode(const unsigned char* Pencoded, point_t P)
     point_extproj_t R;
     unsigned int i;
 
-    *((__m256i*)P->y) = *((__m256i*)Pencoded);      // Decoding y-coordinate and sign
+    _mm256_storeu_si256((__m256i*)P->y, _mm256_loadu_si256((__m256i*)Pencoded));      // Decoding y-coordinate and sign
     P->y[1][1] &= 0x7FFFFFFFFFFFFFFF;
 
     fp2sqr1271(P->y, u);
@@ -1705,7 +2158,7 @@ static bool getPublicKeyFromIdentity(const unsigned char* identity, unsigned cha
             *((unsigned long long*) & publicKeyBuffer[i << 3]) = *((unsigned long long*) & publicKeyBuffer[i << 3]) * 26 + (identity[i * 14 + j] - 'A');
         }
     }
-    *((__m256i*)publicKey) = *((__m256i*)publicKeyBuffer);
+    _mm256_storeu_si256((__m256i*)publicKey, _mm256_loadu_si256((__m256i*)publicKeyBuffer));
 
     return true;
 }
@@ -1738,7 +2191,7 @@ static bool getSharedKey(const unsigned char* privateKey, const unsigned char* p
         return false;
     }
 
-    *((__m256i*)sharedKey) = *((__m256i*)A->y);
+    _mm256_storeu_si256((__m256i*)sharedKey, _mm256_loadu_si256((__m256i*)A->y));
 
     return true;
 }
@@ -1776,15 +2229,15 @@ static void sign(const unsigned char* subseed, const unsigned char* publicKey, c
 
     KangarooTwelve((unsigned char*)subseed, 32, k, 64);
 
-    *((__m256i*)(temp + 32)) = *((__m256i*)(k + 32));
-    *((__m256i*)(temp + 64)) = *((__m256i*)messageDigest);
+    _mm256_storeu_si256((__m256i*)(temp + 32), _mm256_loadu_si256((__m256i*)(k + 32)));
+    _mm256_storeu_si256((__m256i*)(temp + 64), _mm256_loadu_si256((__m256i*)messageDigest));
 
     KangarooTwelve(temp + 32, 32 + 32, (unsigned char*)r, 64);
 
     ecc_mul_fixed(r, R);
     encode(R, signature); // Encode lowest 32 bytes of signature
-    *((__m256i*)temp) = *((__m256i*)signature);
-    *((__m256i*)(temp + 32)) = *((__m256i*)publicKey);
+    _mm256_storeu_si256((__m256i*)temp, _mm256_loadu_si256((__m256i*)signature));
+    _mm256_storeu_si256((__m256i*)(temp + 32), _mm256_loadu_si256((__m256i*)publicKey));
 
     KangarooTwelve(temp, 32 + 64, h, 64);
     Montgomery_multiply_mod_order(r, Montgomery_Rprime, r);
@@ -1819,9 +2272,9 @@ static bool verify(const unsigned char* publicKey, const unsigned char* messageD
         return false;
     }
 
-    *((__m256i*)temp) = *((__m256i*)signature);
-    *((__m256i*)(temp + 32)) = *((__m256i*)publicKey);
-    *((__m256i*)(temp + 64)) = *((__m256i*)messageDigest);
+    _mm256_storeu_si256((__m256i*)temp, _mm256_loadu_si256((__m256i*)signature));
+    _mm256_storeu_si256((__m256i*)(temp + 32), _mm256_loadu_si256((__m256i*)publicKey));
+    _mm256_storeu_si256((__m256i*)(temp + 64), _mm256_loadu_si256((__m256i*)messageDigest));
 
     KangarooTwelve(temp, 32 + 64, h, 64);
 
@@ -1832,5 +2285,190 @@ static bool verify(const unsigned char* publicKey, const unsigned char* messageD
 
     encode(A, (unsigned char*)A);
 
-    return *((__m256i*)A) == *((__m256i*)signature);
+    return *((m256i*)A) == *((m256i*)signature);
+}
+
+struct VerificationKey
+{ // Public key decoded once together with the tables of the double scalar multiplication, see verifyWithCachedKey()
+    m256i publicKey;
+    bool valid; // false if verify() would reject any signature of publicKey (bit 128 set, not decodable or not on the curve)
+    point_extproj_precomp_t tables[4][4];
+};
+
+static void prepareVerificationKey(const unsigned char* publicKey, VerificationKey& key)
+{
+    point_t A;
+
+    key.publicKey = m256i(publicKey);
+    key.valid = !(publicKey[15] & 0x80)
+        && decode(publicKey, A)
+        && ecc_precomp_double_tables(A, key.tables);
+}
+
+static bool verifyWithCachedKey(const VerificationKey& key, const unsigned char* messageDigest, const unsigned char* signature)
+{ // Same as verify(key.publicKey, messageDigest, signature) without decoding the public key and building its tables
+    point_t A;
+    point_extproj_t T;
+    unsigned char temp[32 + 64], h[64];
+
+    if (!key.valid || (signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63])
+    {
+        return false;
+    }
+
+    _mm256_storeu_si256((__m256i*)temp, _mm256_loadu_si256((__m256i*)signature));
+    _mm256_storeu_si256((__m256i*)(temp + 32), _mm256_loadu_si256((__m256i*)key.publicKey.m256i_u8));
+    _mm256_storeu_si256((__m256i*)(temp + 64), _mm256_loadu_si256((__m256i*)messageDigest));
+
+    KangarooTwelve(temp, 32 + 64, h, 64);
+
+    ecc_mul_double_tables((unsigned long long*)(signature + 32), (unsigned long long*)h, (point_extproj_precomp_t(*)[4])key.tables, T);
+    eccnorm(T, A);
+    encode(A, (unsigned char*)A);
+
+    return *((m256i*)A) == *((m256i*)signature);
+}
+
+#define VERIFY_BATCH_SIZE 16
+#define VERIFY_LOCKSTEP_MIN_LANES 4 // A lockstep run costs about as much as 3 scalar double scalar multiplications, fewer remaining signatures go the scalar way
+
+static bool verifyBatch(const unsigned char* const* publicKeys, const unsigned char* const* messageDigests, const unsigned char* const* signatures, unsigned int n, bool* results)
+{ // SchnorrQ verification of n signatures, results[i] is the same as verify(publicKeys[i], messageDigests[i], signatures[i])
+  // The double scalar multiplications of up to VERIFY_BATCH_SIZE signatures are normalized together, sharing one field inversion
+  // Output: TRUE if all signatures are valid
+    point_extproj_t T[VERIFY_BATCH_SIZE];
+    felm_t norms[VERIFY_BATCH_SIZE], products[VERIFY_BATCH_SIZE];
+    unsigned int indices[VERIFY_BATCH_SIZE];
+    point_extproj_precomp_t laneTables[8][4][4]; // Pending lanes of ecc_mul_double_tables_8x()
+    point_extproj_precomp_t (*laneTablePointers[8])[4];
+    unsigned long long* laneK[8];
+    unsigned long long* laneL[8];
+    unsigned char laneH[8][64];
+    bool allValid = true;
+
+    for (unsigned int lane = 0; lane < 8; lane++)
+    {
+        laneTablePointers[lane] = laneTables[lane];
+        laneL[lane] = (unsigned long long*)laneH[lane];
+    }
+
+    for (unsigned int batchBegin = 0; batchBegin < n; batchBegin += VERIFY_BATCH_SIZE)
+    {
+        const unsigned int batchEnd = (n - batchBegin < VERIFY_BATCH_SIZE) ? n : batchBegin + VERIFY_BATCH_SIZE;
+        unsigned int numberOfPoints = 0, numberOfLanes = 0;
+        for (unsigned int i = batchBegin; i < batchEnd; i++)
+        {
+            const unsigned char* publicKey = publicKeys[i];
+            const unsigned char* signature = signatures[i];
+            point_t A;
+            unsigned char temp[32 + 64];
+            unsigned char* h = laneH[numberOfLanes];
+
+            results[i] = false;
+            if ((publicKey[15] & 0x80) || (signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63])
+            {
+                continue;
+            }
+            if (!decode(publicKey, A))
+            {
+                continue;
+            }
+
+            _mm256_storeu_si256((__m256i*)temp, _mm256_loadu_si256((__m256i*)signature));
+            _mm256_storeu_si256((__m256i*)(temp + 32), _mm256_loadu_si256((__m256i*)publicKey));
+            _mm256_storeu_si256((__m256i*)(temp + 64), _mm256_loadu_si256((__m256i*)messageDigests[i]));
+
+            KangarooTwelve(temp, 32 + 64, h, 64);
+
+            if (ecc_mul_double_tables_8x)
+            {
+                // Collect 8 signatures and run their double scalar multiplications in lockstep
+                if (!ecc_precomp_double_tables(A, laneTables[numberOfLanes]))
+                {
+                    continue;
+                }
+                laneK[numberOfLanes] = (unsigned long long*)(signature + 32);
+                indices[numberOfPoints + numberOfLanes++] = i;
+                if (numberOfLanes == 8)
+                {
+                    ecc_mul_double_tables_8x(laneK, laneL, laneTablePointers, 8, &T[numberOfPoints]);
+                    numberOfPoints += 8;
+                    numberOfLanes = 0;
+                }
+                continue;
+            }
+
+            if (!ecc_mul_double_extproj((unsigned long long*)(signature + 32), (unsigned long long*)h, A, T[numberOfPoints]))
+            {
+                continue;
+            }
+            indices[numberOfPoints++] = i;
+        }
+        if (numberOfLanes >= VERIFY_LOCKSTEP_MIN_LANES)
+        {
+            ecc_mul_double_tables_8x(laneK, laneL, laneTablePointers, numberOfLanes, &T[numberOfPoints]);
+        }
+        else
+        {
+            for (unsigned int lane = 0; lane < numberOfLanes; lane++)
+            {
+                ecc_mul_double_tables(laneK[lane], laneL[lane], laneTables[lane], T[numberOfPoints + lane]);
+            }
+        }
+        numberOfPoints += numberOfLanes;
+
+        for (unsigned int j = 0; j < numberOfPoints; j++)
+        {
+            felm_t t;
+            fpsqr1271(T[j]->z[0], norms[j]);
+            fpsqr1271(T[j]->z[1], t);
+            fpadd1271(norms[j], t, norms[j]);
+        }
+
+        // Montgomery's trick: products[j] = norms[0] * ... * norms[j], invert the last one and unwind
+        for (unsigned int j = 0; j < numberOfPoints; j++)
+        {
+            if (j)
+            {
+                fpmul1271(products[j - 1], norms[j], products[j]);
+            }
+            else
+            {
+                products[0][0] = norms[0][0];
+                products[0][1] = norms[0][1];
+            }
+        }
+        felm_t inverse, normInverse;
+        if (numberOfPoints)
+        {
+            inverse[0] = products[numberOfPoints - 1][0];
+            inverse[1] = products[numberOfPoints - 1][1];
+            fpinv1271(inverse);
+        }
+        for (unsigned int j = numberOfPoints; j--; )
+        {
+            if (j)
+            {
+                fpmul1271(inverse, products[j - 1], normInverse);
+                fpmul1271(inverse, norms[j], inverse);
+            }
+            else
+            {
+                normInverse[0] = inverse[0];
+                normInverse[1] = inverse[1];
+            }
+
+            point_t R;
+            eccnorm_inverted(T[j], normInverse, R);
+            encode(R, (unsigned char*)R);
+            results[indices[j]] = *((m256i*)R) == *((m256i*)signatures[indices[j]]);
+        }
+
+        for (unsigned int i = batchBegin; i < batchEnd; i++)
+        {
+            allValid &= results[i];
+        }
+    }
+
+    return allValid;
 }
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/memory.h"
+
+#include "network/common_def.h"
+
+#define IPO_REFUNDS_HASH_MAP_SIZE 2048 // Must be 2^N and at least twice the number of refunds
+
+// Bids of an IPO while they are taken in a tick. The IPO state (of type IPOType with the members publicKeys and prices) keeps
+// the bids sorted by price, highest first and among equal prices the earliest first, so a new bid replaces the last one. The
+// order book keeps them in a min-heap with the same order instead and writes the sorted arrays back once the bids of the tick
+// have been taken, so the state is the same as if every bid had been sorted into the arrays.
+struct IPOBid
+{
+    m256i publicKey;
+    long long price;
+    unsigned long long sequence; // Bids with equal prices are ordered by sequence
+};
+
+struct IPOOrderBook
+{
+    IPOBid bids[NUMBER_OF_COMPUTORS]; // The lowest bid first
+    unsigned long long nextSequence;
+    bool isOpen;
+};
+
+// Refunds of an IPO aggregated per entity in the order the entities get their first refund
+struct IPORefunds
+{
+    m256i publicKeys[NUMBER_OF_COMPUTORS];
+    long long amounts[NUMBER_OF_COMPUTORS];
+    unsigned int numberOfRefunds;
+    unsigned short refundIndices[IPO_REFUNDS_HASH_MAP_SIZE]; // Index of the refund + 1, 0 if the slot is empty
+};
+
+static_assert(IPO_REFUNDS_HASH_MAP_SIZE >= 2 * NUMBER_OF_COMPUTORS, "The refunds hash map is too small.");
+
+// Whether bid a is replaced before bid b
+static inline bool isLowerIPOBid(const IPOBid& a, const IPOBid& b)
+{
+    return a.price < b.price || (a.price == b.price && a.sequence > b.sequence);
+}
+
+static void siftDownIPOBid(IPOBid* bids, unsigned int numberOfBids, unsigned int index)
+{
+    const IPOBid bid = bids[index];
+    while (true)
+    {
+        unsigned int child = index * 2 + 1;
+        if (child >= numberOfBids)
+        {
+            break;
+        }
+        if (child + 1 < numberOfBids && isLowerIPOBid(bids[child + 1], bids[child]))
+        {
+            child++;
+        }
+        if (!isLowerIPOBid(bids[child], bid))
+        {
+            break;
+        }
+        bids[index] = bids[child];
+        index = child;
+    }
+    bids[index] = bid;
+}
+
+template <typename IPOType>
+static void openIPOOrderBook(IPOOrderBook& orderBook, const IPOType& ipo)
+{
+    for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+    {
+        orderBook.bids[i].publicKey = ipo.publicKeys[i];
+        orderBook.bids[i].price = ipo.prices[i];
+        orderBook.bids[i].sequence = i;
+    }
+    for (unsigned int i = NUMBER_OF_COMPUTORS / 2; i-- > 0; )
+    {
+        siftDownIPOBid(orderBook.bids, NUMBER_OF_COMPUTORS, i);
+    }
+    orderBook.nextSequence = NUMBER_OF_COMPUTORS;
+    orderBook.isOpen = true;
+}
+
+static inline const IPOBid& lowestIPOBid(const IPOOrderBook& orderBook)
+{
+    return orderBook.bids[0];
+}
+
+static void replaceLowestIPOBid(IPOOrderBook& orderBook, const m256i& publicKey, long long price)
+{
+    orderBook.bids[0].publicKey = publicKey;
+    orderBook.bids[0].price = price;
+    orderBook.bids[0].sequence = orderBook.nextSequence++;
+    siftDownIPOBid(orderBook.bids, NUMBER_OF_COMPUTORS, 0);
+}
+
+// Writes the sorted bids back into the IPO state
+template <typename IPOType>
+static void closeIPOOrderBook(IPOOrderBook& orderBook, IPOType& ipo)
+{
+    for (unsigned int numberOfBids = NUMBER_OF_COMPUTORS; numberOfBids-- > 0; )
+    {
+        ipo.publicKeys[numberOfBids] = orderBook.bids[0].publicKey;
+        ipo.prices[numberOfBids] = orderBook.bids[0].price;
+        orderBook.bids[0] = orderBook.bids[numberOfBids];
+        siftDownIPOBid(orderBook.bids, numberOfBids, 0);
+    }
+    orderBook.isOpen = false;
+}
+
+static void initIPORefunds(IPORefunds& refunds)
+{
+    setMem(refunds.refundIndices, sizeof(refunds.refundIndices), 0);
+    refunds.numberOfRefunds = 0;
+}
+
+static void addIPORefund(IPORefunds& refunds, const m256i& publicKey, long long amount)
+{
+    unsigned int slot = publicKey.m256i_u32[0] & (IPO_REFUNDS_HASH_MAP_SIZE - 1);
+    while (refunds.refundIndices[slot])
+    {
+        const unsigned int index = refunds.refundIndices[slot] - 1;
+        if (refunds.publicKeys[index] == publicKey)
+        {
+            refunds.amounts[index] += amount;
+
+            return;
+        }
+        slot = (slot + 1) & (IPO_REFUNDS_HASH_MAP_SIZE - 1);
+    }
+    refunds.publicKeys[refunds.numberOfRefunds] = publicKey;
+    refunds.amounts[refunds.numberOfRefunds] = amount;
+    refunds.refundIndices[slot] = ++refunds.numberOfRefunds;
+}
+
+// Empties the hash map by clearing only the slots of the refunds
+static void clearIPORefunds(IPORefunds& refunds)
+{
+    for (unsigned int i = 0; i < refunds.numberOfRefunds; i++)
+    {
+        unsigned int slot = refunds.publicKeys[i].m256i_u32[0] & (IPO_REFUNDS_HASH_MAP_SIZE - 1);
+        while (refunds.refundIndices[slot])
+        {
+            refunds.refundIndices[slot] = 0;
+            slot = (slot + 1) & (IPO_REFUNDS_HASH_MAP_SIZE - 1);
+        }
+    }
+    refunds.numberOfRefunds = 0;
+}
@@ -2,22 +2,29 @@
 
 #include <intrin.h>
 
+#include "platform/concurrency.h"
+#include "platform/cpu_features.h"
 #include "platform/memory.h"
 
 
 ////////// KangarooTwelve \\\\\\\\\\
 
+// 0 = generic and AVX-512 Keccak-p[1600,12] kernels only, 1 = also AVX2 kernels, 2 = AVX2 kernels if they measure faster at start-up
+#ifndef K12_AVX2_KERNELS
+#define K12_AVX2_KERNELS 2
+#endif
+
 #if defined(_MSC_VER)
 #define ROL64(a, offset) _rotl64(a, offset)
 #else
 #define ROL64(a, offset) ((((unsigned long long)a) << offset) ^ (((unsigned long long)a) >> (64 - offset)))
 #endif
+#define ROL64x4(a, offset) _mm256_or_si256(_mm256_slli_epi64(a, offset), _mm256_srli_epi64(a, 64 - offset))
 
-#ifdef __AVX512F__
 static __m512i zero, moveThetaPrev, moveThetaNext, rhoB, rhoG, rhoK, rhoM, rhoS, pi1B, pi1G, pi1K, pi1M, pi1S, pi2S1, pi2S2, pi2BG, pi2KM, pi2S3, padding;
 static __m512i K12RoundConst0, K12RoundConst1, K12RoundConst2, K12RoundConst3, K12RoundConst4, K12RoundConst5, K12RoundConst6, K12RoundConst7, K12RoundConst8, K12RoundConst9, K12RoundConst10, K12RoundConst11;
 
-static void initAVX512KangarooTwelveConstants()
+TARGET_AVX512 static void initAVX512KangarooTwelveConstants()
 {
     zero = _mm512_maskz_set1_epi64(0, 0);
     moveThetaPrev = _mm512_setr_epi64(4, 0, 1, 2, 3, 5, 6, 7);
@@ -53,7 +60,6 @@ static void initAVX512KangarooTwelveConstants()
     K12RoundConst11 = _mm512_maskz_set1_epi64(1, 0x8000000080008008ULL);
 }
 
-#else
 
 #define KeccakF1600RoundConstant0   0x000000008000808bULL
 #define KeccakF1600RoundConstant1   0x800000000000008bULL
@@ -67,6 +73,12 @@ static void initAVX512KangarooTwelveConstants()
 #define KeccakF1600RoundConstant9   0x8000000000008080ULL
 #define KeccakF1600RoundConstant10  0x0000000080000001ULL
 
+static const unsigned long long KeccakP1600RoundConstants12[12] = {
+    KeccakF1600RoundConstant0, KeccakF1600RoundConstant1, KeccakF1600RoundConstant2, KeccakF1600RoundConstant3,
+    KeccakF1600RoundConstant4, KeccakF1600RoundConstant5, KeccakF1600RoundConstant6, KeccakF1600RoundConstant7,
+    KeccakF1600RoundConstant8, KeccakF1600RoundConstant9, KeccakF1600RoundConstant10, 0x8000000080008008ULL
+};
+
 #define declareABCDE \
     unsigned long long Aba, Abe, Abi, Abo, Abu; \
     unsigned long long Aga, Age, Agi, Ago, Agu; \
@@ -346,7 +358,6 @@ static void initAVX512KangarooTwelveConstants()
     Asi =   Bsi ^((~Bso)&  Bsu ); \
     Aso =   Bso ^((~Bsu)&  Bsa ); \
     Asu =   Bsu ^((~Bsa)&  Bse );
-#endif
 
 #define K12_security        128
 #define K12_capacity        (2 * K12_security)
@@ -361,9 +372,8 @@ typedef struct
     unsigned char byteIOIndex;
 } KangarooTwelve_F;
 
-static void KeccakP1600_Permute_12rounds(unsigned char* state)
+TARGET_AVX512 static void KeccakP1600_Permute_12rounds_AVX512(unsigned char* state)
 {
-#ifdef __AVX512F__
     __m512i Baeiou = _mm512_maskz_loadu_epi64(0x1F, state);
     __m512i Gaeiou = _mm512_maskz_loadu_epi64(0x1F, state + 40);
     __m512i Kaeiou = _mm512_maskz_loadu_epi64(0x1F, state + 80);
@@ -652,15 +662,490 @@ static void KeccakP1600_Permute_12rounds(unsigned char* state)
     _mm512_mask_storeu_epi64(state + 80, 0x1F, Kaeiou);
     _mm512_mask_storeu_epi64(state + 120, 0x1F, Maeiou);
     _mm512_mask_storeu_epi64(state + 160, 0x1F, Saeiou);
-#else
+}
+
+static void KeccakP1600_Permute_12rounds_Generic(unsigned char* state)
+{
     declareABCDE
         unsigned long long* stateAsLanes = (unsigned long long*)state;
     copyFromState(stateAsLanes)
         rounds12
         copyToState(stateAsLanes)
-#endif
 }
 
+static void KeccakP1600_Permute_12rounds_AVX2(unsigned char* state)
+{
+    // Lanes A[x][y] (state word x + 5 * y) are kept in 7 registers: A00 holds A[0][0] in all 4 elements, A01 holds A[1..4][0],
+    // A20 holds A[0][2], A[0][4], A[0][1], A[0][3] and the other registers hold one lane of each column 1..4 in the order of the names
+    // A31 = A[1][3], A[2][1], A[3][4], A[4][2], A21 = A[1][2], A[2][4], A[3][1], A[4][3], A41 = A[1][4], A[2][3], A[3][2], A[4][1], A11 = A[1][1], A[2][2], A[3][3], A[4][4]
+    // so that theta works on whole registers and pi is folded into the permutations building the operands of chi
+    const unsigned long long* s = (const unsigned long long*)state;
+    const __m256i row1 = _mm256_loadu_si256((const __m256i*)&s[6]), row2 = _mm256_loadu_si256((const __m256i*)&s[11]), row3 = _mm256_loadu_si256((const __m256i*)&s[16]), row4 = _mm256_loadu_si256((const __m256i*)&s[21]);
+    __m256i A00 = _mm256_set1_epi64x(s[0]);
+    __m256i A01 = _mm256_loadu_si256((const __m256i*)&s[1]);
+    __m256i A20 = _mm256_setr_epi64x(s[10], s[20], s[5], s[15]);
+    __m256i A31 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(row3, row1, 0x0C), row4, 0x30), row2, 0xC0);
+    __m256i A21 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(row2, row4, 0x0C), row1, 0x30), row3, 0xC0);
+    __m256i A41 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(row4, row3, 0x0C), row2, 0x30), row1, 0xC0);
+    __m256i A11 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(row1, row2, 0x0C), row3, 0x30), row4, 0xC0);
+    const __m256i rhoLeft01 = _mm256_setr_epi64x(1, 62, 28, 27), rhoRight01 = _mm256_setr_epi64x(63, 2, 36, 37);
+    const __m256i rhoLeft20 = _mm256_setr_epi64x(3, 18, 36, 41), rhoRight20 = _mm256_setr_epi64x(61, 46, 28, 23);
+    const __m256i rhoLeft31 = _mm256_setr_epi64x(45, 6, 56, 39), rhoRight31 = _mm256_setr_epi64x(19, 58, 8, 25);
+    const __m256i rhoLeft21 = _mm256_setr_epi64x(10, 61, 55, 8), rhoRight21 = _mm256_setr_epi64x(54, 3, 9, 56);
+    const __m256i rhoLeft41 = _mm256_setr_epi64x(2, 15, 25, 20), rhoRight41 = _mm256_setr_epi64x(62, 49, 39, 44);
+    const __m256i rhoLeft11 = _mm256_setr_epi64x(44, 43, 21, 14), rhoRight11 = _mm256_setr_epi64x(20, 21, 43, 50);
+
+    for (unsigned int round = 0; round < 12; round++)
+    {
+        // Theta, C00 and D00 are broadcast to all elements
+        __m256i C14 = _mm256_xor_si256(_mm256_xor_si256(A01, A31), _mm256_xor_si256(_mm256_xor_si256(A21, A41), A11));
+        __m256i C00 = _mm256_xor_si256(A20, _mm256_permute4x64_epi64(A20, 0x4E));
+        C00 = _mm256_xor_si256(_mm256_xor_si256(C00, _mm256_shuffle_epi32(C00, 0x4E)), A00);
+        const __m256i rolC14 = _mm256_or_si256(_mm256_slli_epi64(C14, 1), _mm256_srli_epi64(C14, 63));
+        const __m256i rolC00 = _mm256_or_si256(_mm256_slli_epi64(C00, 1), _mm256_srli_epi64(C00, 63));
+        const __m256i C4123 = _mm256_permute4x64_epi64(C14, 0x93);
+        const __m256i D00 = _mm256_permute4x64_epi64(_mm256_xor_si256(C4123, rolC14), 0x00);
+        const __m256i D14 = _mm256_xor_si256(_mm256_blend_epi32(C4123, C00, 0x03), _mm256_blend_epi32(_mm256_permute4x64_epi64(rolC14, 0x39), rolC00, 0xC0));
+
+        // Rho
+        const __m256i B00 = _mm256_xor_si256(A00, D00);
+        const __m256i X01 = _mm256_xor_si256(A01, D14);
+        const __m256i B01 = _mm256_or_si256(_mm256_sllv_epi64(X01, rhoLeft01), _mm256_srlv_epi64(X01, rhoRight01));
+        const __m256i X20 = _mm256_xor_si256(A20, D00);
+        const __m256i B20 = _mm256_or_si256(_mm256_sllv_epi64(X20, rhoLeft20), _mm256_srlv_epi64(X20, rhoRight20));
+        const __m256i X31 = _mm256_xor_si256(A31, D14);
+        const __m256i B31 = _mm256_or_si256(_mm256_sllv_epi64(X31, rhoLeft31), _mm256_srlv_epi64(X31, rhoRight31));
+        const __m256i X21 = _mm256_xor_si256(A21, D14);
+        const __m256i B21 = _mm256_or_si256(_mm256_sllv_epi64(X21, rhoLeft21), _mm256_srlv_epi64(X21, rhoRight21));
+        const __m256i X41 = _mm256_xor_si256(A41, D14);
+        const __m256i B41 = _mm256_or_si256(_mm256_sllv_epi64(X41, rhoLeft41), _mm256_srlv_epi64(X41, rhoRight41));
+        const __m256i X11 = _mm256_xor_si256(A11, D14);
+        const __m256i B11 = _mm256_or_si256(_mm256_sllv_epi64(X11, rhoLeft11), _mm256_srlv_epi64(X11, rhoRight11));
+
+        // Pi and chi
+        const __m256i P01_94 = _mm256_permute4x64_epi64(B01, 0x94);
+        const __m256i P01_44 = _mm256_permute4x64_epi64(B01, 0x44);
+        const __m256i P01_34 = _mm256_permute4x64_epi64(B01, 0x34);
+        const __m256i P20_72 = _mm256_permute4x64_epi64(B20, 0x72);
+        const __m256i P20_9F = _mm256_permute4x64_epi64(B20, 0x9F);
+        const __m256i P20_C4 = _mm256_permute4x64_epi64(B20, 0xC4);
+        const __m256i P31_8D = _mm256_permute4x64_epi64(B31, 0x8D);
+        const __m256i P31_63 = _mm256_permute4x64_epi64(B31, 0x63);
+        const __m256i P31_E8 = _mm256_permute4x64_epi64(B31, 0xE8);
+        const __m256i P21_72 = _mm256_permute4x64_epi64(B21, 0x72);
+        const __m256i P21_9F = _mm256_permute4x64_epi64(B21, 0x9F);
+        const __m256i P21_28 = _mm256_permute4x64_epi64(B21, 0x28);
+        const __m256i P41_1B = _mm256_permute4x64_epi64(B41, 0x1B);
+        const __m256i P41_C2 = _mm256_permute4x64_epi64(B41, 0xC2);
+        const __m256i P41_F5 = _mm256_permute4x64_epi64(B41, 0xF5);
+        const __m256i P11_00 = _mm256_permute4x64_epi64(B11, 0x00);
+        const __m256i P11_55 = _mm256_permute4x64_epi64(B11, 0x55);
+        const __m256i P11_2E = _mm256_permute4x64_epi64(B11, 0x2E);
+        const __m256i P11_F9 = _mm256_permute4x64_epi64(B11, 0xF9);
+        A00 = _mm256_xor_si256(B00, _mm256_andnot_si256(P11_00, P11_55));
+        const __m256i T0 = _mm256_blend_epi32(P11_F9, B00, 0xC0);
+        const __m256i T1 = _mm256_blend_epi32(P11_2E, B00, 0x30);
+        A01 = _mm256_xor_si256(B11, _mm256_andnot_si256(T0, T1));
+        const __m256i T2 = _mm256_blend_epi32(P31_8D, P21_28, 0x0C);
+        const __m256i T3 = _mm256_blend_epi32(T2, P41_F5, 0x30);
+        const __m256i T4 = _mm256_blend_epi32(T3, P20_9F, 0xC0);
+        const __m256i T5 = _mm256_blend_epi32(P41_C2, P31_8D, 0x0C);
+        const __m256i T6 = _mm256_blend_epi32(T5, P20_C4, 0x30);
+        const __m256i T7 = _mm256_blend_epi32(T6, P21_28, 0xC0);
+        A20 = _mm256_xor_si256(B01, _mm256_andnot_si256(T4, T7));
+        const __m256i T8 = _mm256_blend_epi32(B21, P31_63, 0x0C);
+        const __m256i T9 = _mm256_blend_epi32(T8, P41_C2, 0x30);
+        const __m256i T10 = _mm256_blend_epi32(T9, P01_34, 0xC0);
+        const __m256i T11 = _mm256_blend_epi32(P41_F5, B21, 0x0C);
+        const __m256i T12 = _mm256_blend_epi32(T11, P01_94, 0x30);
+        const __m256i T13 = _mm256_blend_epi32(T12, P31_63, 0xC0);
+        A31 = _mm256_xor_si256(P20_72, _mm256_andnot_si256(T10, T13));
+        const __m256i T14 = _mm256_blend_epi32(P41_C2, P20_9F, 0x0C);
+        const __m256i T15 = _mm256_blend_epi32(T14, P21_9F, 0x30);
+        const __m256i T16 = _mm256_blend_epi32(T15, B01, 0xC0);
+        const __m256i T17 = _mm256_blend_epi32(P21_9F, P41_C2, 0x0C);
+        const __m256i T18 = _mm256_blend_epi32(T17, B01, 0x30);
+        const __m256i T19 = _mm256_blend_epi32(T18, P20_9F, 0xC0);
+        A21 = _mm256_xor_si256(P31_8D, _mm256_andnot_si256(T16, T19));
+        const __m256i T20 = _mm256_blend_epi32(P31_63, B41, 0x0C);
+        const __m256i T21 = _mm256_blend_epi32(T20, P20_9F, 0x30);
+        const __m256i T22 = _mm256_blend_epi32(T21, P01_94, 0xC0);
+        const __m256i T23 = _mm256_blend_epi32(P20_9F, P31_E8, 0x0C);
+        const __m256i T24 = _mm256_blend_epi32(T23, P01_44, 0x30);
+        const __m256i T25 = _mm256_blend_epi32(T24, B41, 0xC0);
+        A41 = _mm256_xor_si256(P21_72, _mm256_andnot_si256(T22, T25));
+        const __m256i T26 = _mm256_blend_epi32(B20, P21_9F, 0x0C);
+        const __m256i T27 = _mm256_blend_epi32(T26, B31, 0x30);
+        const __m256i T28 = _mm256_blend_epi32(T27, P01_44, 0xC0);
+        const __m256i T29 = _mm256_blend_epi32(B31, B20, 0x0C);
+        const __m256i T30 = _mm256_blend_epi32(T29, P01_34, 0x30);
+        const __m256i T31 = _mm256_blend_epi32(T30, P21_9F, 0xC0);
+        A11 = _mm256_xor_si256(P41_1B, _mm256_andnot_si256(T28, T31));
+
+        // Iota
+        A00 = _mm256_xor_si256(A00, _mm256_set1_epi64x(KeccakP1600RoundConstants12[round]));
+    }
+
+    unsigned long long* d = (unsigned long long*)state;
+    d[0] = _mm256_extract_epi64(A00, 0);
+    _mm256_storeu_si256((__m256i*)&d[1], A01);
+    _mm256_storeu_si256((__m256i*)&d[6], _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(A11, A31, 0x0C), A21, 0x30), A41, 0xC0));
+    _mm256_storeu_si256((__m256i*)&d[11], _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(A21, A11, 0x0C), A41, 0x30), A31, 0xC0));
+    _mm256_storeu_si256((__m256i*)&d[16], _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(A31, A41, 0x0C), A11, 0x30), A21, 0xC0));
+    _mm256_storeu_si256((__m256i*)&d[21], _mm256_blend_epi32(_mm256_blend_epi32(_mm256_blend_epi32(A41, A21, 0x0C), A31, 0x30), A11, 0xC0));
+    d[10] = _mm256_extract_epi64(A20, 0);
+    d[20] = _mm256_extract_epi64(A20, 1);
+    d[5] = _mm256_extract_epi64(A20, 2);
+    d[15] = _mm256_extract_epi64(A20, 3);
+}
+
+static void (*KeccakP1600_Permute_12rounds)(unsigned char* state) = KeccakP1600_Permute_12rounds_Generic;
+
+// Absorbs all complete blocks at the beginning of data into state, returns the number of absorbed bytes
+TARGET_AVX512 static unsigned long long KeccakP1600_AbsorbBlocks_AVX512(unsigned char* state, const unsigned char* data, unsigned long long dataByteLen)
+{
+    __m512i Baeiou = _mm512_maskz_loadu_epi64(0x1F, state);
+    __m512i Gaeiou = _mm512_maskz_loadu_epi64(0x1F, state + 40);
+    __m512i Kaeiou = _mm512_maskz_loadu_epi64(0x1F, state + 80);
+    __m512i Maeiou = _mm512_maskz_loadu_epi64(0x1F, state + 120);
+    __m512i Saeiou = _mm512_maskz_loadu_epi64(0x1F, state + 160);
+    unsigned long long modifiedDataByteLen = dataByteLen;
+    while (modifiedDataByteLen >= K12_rateInBytes)
+    {
+        Baeiou = _mm512_xor_si512(Baeiou, _mm512_maskz_loadu_epi64(0x1F, data));
+        Gaeiou = _mm512_xor_si512(Gaeiou, _mm512_maskz_loadu_epi64(0x1F, data + 40));
+        Kaeiou = _mm512_xor_si512(Kaeiou, _mm512_maskz_loadu_epi64(0x1F, data + 80));
+        Maeiou = _mm512_xor_si512(Maeiou, _mm512_maskz_loadu_epi64(0x1F, data + 120));
+        Saeiou = _mm512_xor_si512(Saeiou, _mm512_maskz_loadu_epi64(0x01, data + 160));
+        __m512i b0, b1, b2, b3, b4, b5;
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst0);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst1);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst2);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst3);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst4);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst5);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst6);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst7);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst8);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst9);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst10);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+
+        b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
+        b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
+        b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
+        b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
+        b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
+        b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
+        b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
+        b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
+        Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst11);
+        Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
+        Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
+        Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
+        Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
+        b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
+        b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
+        b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
+        b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
+        Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
+        Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
+        Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
+        Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
+        Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
+        data += K12_rateInBytes;
+        modifiedDataByteLen -= K12_rateInBytes;
+    }
+    _mm512_mask_storeu_epi64(state, 0x1F, Baeiou);
+    _mm512_mask_storeu_epi64(state + 40, 0x1F, Gaeiou);
+    _mm512_mask_storeu_epi64(state + 80, 0x1F, Kaeiou);
+    _mm512_mask_storeu_epi64(state + 120, 0x1F, Maeiou);
+    _mm512_mask_storeu_epi64(state + 160, 0x1F, Saeiou);
+
+    return dataByteLen - modifiedDataByteLen;
+}
+
+static unsigned long long KeccakP1600_AbsorbBlocks_Generic(unsigned char* state, const unsigned char* data, unsigned long long dataByteLen)
+{
+    declareABCDE
+        unsigned long long* stateAsLanes = (unsigned long long*)state;
+    copyFromState(stateAsLanes)
+        unsigned long long modifiedDataByteLen = dataByteLen;
+    while (modifiedDataByteLen >= K12_rateInBytes)
+    {
+        Aba ^= ((unsigned long long*)data)[0];
+        Abe ^= ((unsigned long long*)data)[1];
+        Abi ^= ((unsigned long long*)data)[2];
+        Abo ^= ((unsigned long long*)data)[3];
+        Abu ^= ((unsigned long long*)data)[4];
+        Aga ^= ((unsigned long long*)data)[5];
+        Age ^= ((unsigned long long*)data)[6];
+        Agi ^= ((unsigned long long*)data)[7];
+        Ago ^= ((unsigned long long*)data)[8];
+        Agu ^= ((unsigned long long*)data)[9];
+        Aka ^= ((unsigned long long*)data)[10];
+        Ake ^= ((unsigned long long*)data)[11];
+        Aki ^= ((unsigned long long*)data)[12];
+        Ako ^= ((unsigned long long*)data)[13];
+        Aku ^= ((unsigned long long*)data)[14];
+        Ama ^= ((unsigned long long*)data)[15];
+        Ame ^= ((unsigned long long*)data)[16];
+        Ami ^= ((unsigned long long*)data)[17];
+        Amo ^= ((unsigned long long*)data)[18];
+        Amu ^= ((unsigned long long*)data)[19];
+        Asa ^= ((unsigned long long*)data)[20];
+        rounds12
+            data += K12_rateInBytes;
+        modifiedDataByteLen -= K12_rateInBytes;
+    }
+    copyToState(stateAsLanes)
+
+    return dataByteLen - modifiedDataByteLen;
+}
+
+static unsigned long long (*KeccakP1600_AbsorbBlocks)(unsigned char* state, const unsigned char* data, unsigned long long dataByteLen) = KeccakP1600_AbsorbBlocks_Generic;
+
 static void KangarooTwelve_F_Absorb(KangarooTwelve_F* instance, const unsigned char* data, unsigned long long dataByteLen)
 {
     unsigned long long i = 0;
@@ -668,340 +1153,9 @@ static void KangarooTwelve_F_Absorb(KangarooTwelve_F* instance, const unsigned c
     {
         if (!instance->byteIOIndex && dataByteLen >= i + K12_rateInBytes)
         {
-#ifdef __AVX512F__
-            __m512i Baeiou = _mm512_maskz_loadu_epi64(0x1F, instance->state);
-            __m512i Gaeiou = _mm512_maskz_loadu_epi64(0x1F, instance->state + 40);
-            __m512i Kaeiou = _mm512_maskz_loadu_epi64(0x1F, instance->state + 80);
-            __m512i Maeiou = _mm512_maskz_loadu_epi64(0x1F, instance->state + 120);
-            __m512i Saeiou = _mm512_maskz_loadu_epi64(0x1F, instance->state + 160);
-#else
-            declareABCDE
-                unsigned long long* stateAsLanes = (unsigned long long*)instance->state;
-            copyFromState(stateAsLanes)
-#endif
-                unsigned long long modifiedDataByteLen = dataByteLen - i;
-            while (modifiedDataByteLen >= K12_rateInBytes)
-            {
-#ifdef __AVX512F__
-                Baeiou = _mm512_xor_si512(Baeiou, _mm512_maskz_loadu_epi64(0x1F, data));
-                Gaeiou = _mm512_xor_si512(Gaeiou, _mm512_maskz_loadu_epi64(0x1F, data + 40));
-                Kaeiou = _mm512_xor_si512(Kaeiou, _mm512_maskz_loadu_epi64(0x1F, data + 80));
-                Maeiou = _mm512_xor_si512(Maeiou, _mm512_maskz_loadu_epi64(0x1F, data + 120));
-                Saeiou = _mm512_xor_si512(Saeiou, _mm512_maskz_loadu_epi64(0x01, data + 160));
-                __m512i b0, b1, b2, b3, b4, b5;
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst0);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst1);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst2);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst3);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst4);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst5);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst6);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst7);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst8);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst9);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst10);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-
-                b0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(Baeiou, Gaeiou, Kaeiou, 0x96), Maeiou, Saeiou, 0x96);
-                b1 = _mm512_permutexvar_epi64(moveThetaPrev, b0);
-                b0 = _mm512_rol_epi64(_mm512_permutexvar_epi64(moveThetaNext, b0), 1);
-                b2 = _mm512_permutexvar_epi64(pi1K, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Kaeiou, b0, b1, 0x96), rhoK));
-                b3 = _mm512_permutexvar_epi64(pi1M, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Maeiou, b0, b1, 0x96), rhoM));
-                b4 = _mm512_permutexvar_epi64(pi1S, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Saeiou, b0, b1, 0x96), rhoS));
-                b5 = _mm512_permutexvar_epi64(pi1G, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Gaeiou, b0, b1, 0x96), rhoG));
-                b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
-                Baeiou = _mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst11);
-                Gaeiou = _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2);
-                Kaeiou = _mm512_ternarylogic_epi64(b2, b3, b4, 0xD2);
-                Maeiou = _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2);
-                Saeiou = _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2);
-                b0 = _mm512_permutex2var_epi64(_mm512_unpacklo_epi64(Baeiou, Gaeiou), pi2S1, Saeiou);
-                b2 = _mm512_permutex2var_epi64(_mm512_unpackhi_epi64(Baeiou, Gaeiou), pi2S2, Saeiou);
-                b1 = _mm512_unpacklo_epi64(Kaeiou, Maeiou);
-                b3 = _mm512_unpackhi_epi64(Kaeiou, Maeiou);
-                Baeiou = _mm512_permutex2var_epi64(b0, pi2BG, b1);
-                Gaeiou = _mm512_permutex2var_epi64(b2, pi2BG, b3);
-                Kaeiou = _mm512_permutex2var_epi64(b0, pi2KM, b1);
-                Maeiou = _mm512_permutex2var_epi64(b2, pi2KM, b3);
-                Saeiou = _mm512_mask_blend_epi64(0x10, _mm512_permutex2var_epi64(b0, pi2S3, b1), Saeiou);
-#else
-                Aba ^= ((unsigned long long*)data)[0];
-                Abe ^= ((unsigned long long*)data)[1];
-                Abi ^= ((unsigned long long*)data)[2];
-                Abo ^= ((unsigned long long*)data)[3];
-                Abu ^= ((unsigned long long*)data)[4];
-                Aga ^= ((unsigned long long*)data)[5];
-                Age ^= ((unsigned long long*)data)[6];
-                Agi ^= ((unsigned long long*)data)[7];
-                Ago ^= ((unsigned long long*)data)[8];
-                Agu ^= ((unsigned long long*)data)[9];
-                Aka ^= ((unsigned long long*)data)[10];
-                Ake ^= ((unsigned long long*)data)[11];
-                Aki ^= ((unsigned long long*)data)[12];
-                Ako ^= ((unsigned long long*)data)[13];
-                Aku ^= ((unsigned long long*)data)[14];
-                Ama ^= ((unsigned long long*)data)[15];
-                Ame ^= ((unsigned long long*)data)[16];
-                Ami ^= ((unsigned long long*)data)[17];
-                Amo ^= ((unsigned long long*)data)[18];
-                Amu ^= ((unsigned long long*)data)[19];
-                Asa ^= ((unsigned long long*)data)[20];
-                rounds12
-#endif
-                    data += K12_rateInBytes;
-                modifiedDataByteLen -= K12_rateInBytes;
-            }
-#ifdef __AVX512F__
-            _mm512_mask_storeu_epi64(instance->state, 0x1F, Baeiou);
-            _mm512_mask_storeu_epi64(instance->state + 40, 0x1F, Gaeiou);
-            _mm512_mask_storeu_epi64(instance->state + 80, 0x1F, Kaeiou);
-            _mm512_mask_storeu_epi64(instance->state + 120, 0x1F, Maeiou);
-            _mm512_mask_storeu_epi64(instance->state + 160, 0x1F, Saeiou);
-#else
-            copyToState(stateAsLanes)
-#endif
-                i = dataByteLen - modifiedDataByteLen;
+            const unsigned long long absorbedByteLen = KeccakP1600_AbsorbBlocks(instance->state, data, dataByteLen - i);
+            data += absorbedByteLen;
+            i += absorbedByteLen;
         }
         else
         {
@@ -1090,7 +1244,250 @@ static void KangarooTwelve_F_Absorb(KangarooTwelve_F* instance, const unsigned c
     }
 }
 
-static void KangarooTwelve(const unsigned char* input, unsigned int inputByteLen, unsigned char* output, unsigned int outputByteLen)
+// Keccak-p[1600,12] on 4 independent states, lanes[i] holds lane i of the 4 states (one per 64-bit element)
+static void KeccakP1600_Permute_12rounds_4x(__m256i* lanes)
+{
+    __m256i Aba = lanes[0], Abe = lanes[1], Abi = lanes[2], Abo = lanes[3], Abu = lanes[4];
+    __m256i Aga = lanes[5], Age = lanes[6], Agi = lanes[7], Ago = lanes[8], Agu = lanes[9];
+    __m256i Aka = lanes[10], Ake = lanes[11], Aki = lanes[12], Ako = lanes[13], Aku = lanes[14];
+    __m256i Ama = lanes[15], Ame = lanes[16], Ami = lanes[17], Amo = lanes[18], Amu = lanes[19];
+    __m256i Asa = lanes[20], Ase = lanes[21], Asi = lanes[22], Aso = lanes[23], Asu = lanes[24];
+    __m256i Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du;
+    __m256i Bba, Bbe, Bbi, Bbo, Bbu;
+    __m256i Bga, Bge, Bgi, Bgo, Bgu;
+    __m256i Bka, Bke, Bki, Bko, Bku;
+    __m256i Bma, Bme, Bmi, Bmo, Bmu;
+    __m256i Bsa, Bse, Bsi, Bso, Bsu;
+
+    for (unsigned int round = 0; round < 12; round++)
+    {
+        Ca = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(Aba, Aga), _mm256_xor_si256(Aka, Ama)), Asa);
+        Ce = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(Abe, Age), _mm256_xor_si256(Ake, Ame)), Ase);
+        Ci = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(Abi, Agi), _mm256_xor_si256(Aki, Ami)), Asi);
+        Co = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(Abo, Ago), _mm256_xor_si256(Ako, Amo)), Aso);
+        Cu = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(Abu, Agu), _mm256_xor_si256(Aku, Amu)), Asu);
+        Da = _mm256_xor_si256(Cu, ROL64x4(Ce, 1));
+        De = _mm256_xor_si256(Ca, ROL64x4(Ci, 1));
+        Di = _mm256_xor_si256(Ce, ROL64x4(Co, 1));
+        Do = _mm256_xor_si256(Ci, ROL64x4(Cu, 1));
+        Du = _mm256_xor_si256(Co, ROL64x4(Ca, 1));
+
+        Bba = _mm256_xor_si256(Aba, Da);
+        Bka = ROL64x4(_mm256_xor_si256(Abe, De), 1);
+        Bsa = ROL64x4(_mm256_xor_si256(Abi, Di), 62);
+        Bga = ROL64x4(_mm256_xor_si256(Abo, Do), 28);
+        Bma = ROL64x4(_mm256_xor_si256(Abu, Du), 27);
+        Bme = ROL64x4(_mm256_xor_si256(Aga, Da), 36);
+        Bbe = ROL64x4(_mm256_xor_si256(Age, De), 44);
+        Bke = ROL64x4(_mm256_xor_si256(Agi, Di), 6);
+        Bse = ROL64x4(_mm256_xor_si256(Ago, Do), 55);
+        Bge = ROL64x4(_mm256_xor_si256(Agu, Du), 20);
+        Bgi = ROL64x4(_mm256_xor_si256(Aka, Da), 3);
+        Bmi = ROL64x4(_mm256_xor_si256(Ake, De), 10);
+        Bbi = ROL64x4(_mm256_xor_si256(Aki, Di), 43);
+        Bki = ROL64x4(_mm256_xor_si256(Ako, Do), 25);
+        Bsi = ROL64x4(_mm256_xor_si256(Aku, Du), 39);
+        Bso = ROL64x4(_mm256_xor_si256(Ama, Da), 41);
+        Bgo = ROL64x4(_mm256_xor_si256(Ame, De), 45);
+        Bmo = ROL64x4(_mm256_xor_si256(Ami, Di), 15);
+        Bbo = ROL64x4(_mm256_xor_si256(Amo, Do), 21);
+        Bko = ROL64x4(_mm256_xor_si256(Amu, Du), 8);
+        Bku = ROL64x4(_mm256_xor_si256(Asa, Da), 18);
+        Bsu = ROL64x4(_mm256_xor_si256(Ase, De), 2);
+        Bgu = ROL64x4(_mm256_xor_si256(Asi, Di), 61);
+        Bmu = ROL64x4(_mm256_xor_si256(Aso, Do), 56);
+        Bbu = ROL64x4(_mm256_xor_si256(Asu, Du), 14);
+
+        Aba = _mm256_xor_si256(Bba, _mm256_andnot_si256(Bbe, Bbi));
+        Abe = _mm256_xor_si256(Bbe, _mm256_andnot_si256(Bbi, Bbo));
+        Abi = _mm256_xor_si256(Bbi, _mm256_andnot_si256(Bbo, Bbu));
+        Abo = _mm256_xor_si256(Bbo, _mm256_andnot_si256(Bbu, Bba));
+        Abu = _mm256_xor_si256(Bbu, _mm256_andnot_si256(Bba, Bbe));
+        Aga = _mm256_xor_si256(Bga, _mm256_andnot_si256(Bge, Bgi));
+        Age = _mm256_xor_si256(Bge, _mm256_andnot_si256(Bgi, Bgo));
+        Agi = _mm256_xor_si256(Bgi, _mm256_andnot_si256(Bgo, Bgu));
+        Ago = _mm256_xor_si256(Bgo, _mm256_andnot_si256(Bgu, Bga));
+        Agu = _mm256_xor_si256(Bgu, _mm256_andnot_si256(Bga, Bge));
+        Aka = _mm256_xor_si256(Bka, _mm256_andnot_si256(Bke, Bki));
+        Ake = _mm256_xor_si256(Bke, _mm256_andnot_si256(Bki, Bko));
+        Aki = _mm256_xor_si256(Bki, _mm256_andnot_si256(Bko, Bku));
+        Ako = _mm256_xor_si256(Bko, _mm256_andnot_si256(Bku, Bka));
+        Aku = _mm256_xor_si256(Bku, _mm256_andnot_si256(Bka, Bke));
+        Ama = _mm256_xor_si256(Bma, _mm256_andnot_si256(Bme, Bmi));
+        Ame = _mm256_xor_si256(Bme, _mm256_andnot_si256(Bmi, Bmo));
+        Ami = _mm256_xor_si256(Bmi, _mm256_andnot_si256(Bmo, Bmu));
+        Amo = _mm256_xor_si256(Bmo, _mm256_andnot_si256(Bmu, Bma));
+        Amu = _mm256_xor_si256(Bmu, _mm256_andnot_si256(Bma, Bme));
+        Asa = _mm256_xor_si256(Bsa, _mm256_andnot_si256(Bse, Bsi));
+        Ase = _mm256_xor_si256(Bse, _mm256_andnot_si256(Bsi, Bso));
+        Asi = _mm256_xor_si256(Bsi, _mm256_andnot_si256(Bso, Bsu));
+        Aso = _mm256_xor_si256(Bso, _mm256_andnot_si256(Bsu, Bsa));
+        Asu = _mm256_xor_si256(Bsu, _mm256_andnot_si256(Bsa, Bse));
+        Aba = _mm256_xor_si256(Aba, _mm256_set1_epi64x(KeccakP1600RoundConstants12[round]));
+    }
+
+    lanes[0] = Aba; lanes[1] = Abe; lanes[2] = Abi; lanes[3] = Abo; lanes[4] = Abu;
+    lanes[5] = Aga; lanes[6] = Age; lanes[7] = Agi; lanes[8] = Ago; lanes[9] = Agu;
+    lanes[10] = Aka; lanes[11] = Ake; lanes[12] = Aki; lanes[13] = Ako; lanes[14] = Aku;
+    lanes[15] = Ama; lanes[16] = Ame; lanes[17] = Ami; lanes[18] = Amo; lanes[19] = Amu;
+    lanes[20] = Asa; lanes[21] = Ase; lanes[22] = Asi; lanes[23] = Aso; lanes[24] = Asu;
+}
+
+// XORs laneCount lanes at data of each of the 4 chunks starting at data into the 4 states of lanes, transposing 4 lanes at a time
+static void KeccakP1600_AddChunkLanes_4x(__m256i* lanes, const unsigned long long* data, unsigned int laneCount)
+{
+    const unsigned int chunkLanes = K12_chunkSize / 8;
+    unsigned int i = 0;
+    for (; i + 4 <= laneCount; i += 4)
+    {
+        const __m256i r0 = _mm256_loadu_si256((const __m256i*)&data[i]);
+        const __m256i r1 = _mm256_loadu_si256((const __m256i*)&data[chunkLanes + i]);
+        const __m256i r2 = _mm256_loadu_si256((const __m256i*)&data[2 * chunkLanes + i]);
+        const __m256i r3 = _mm256_loadu_si256((const __m256i*)&data[3 * chunkLanes + i]);
+        const __m256i t0 = _mm256_unpacklo_epi64(r0, r1), t1 = _mm256_unpackhi_epi64(r0, r1);
+        const __m256i t2 = _mm256_unpacklo_epi64(r2, r3), t3 = _mm256_unpackhi_epi64(r2, r3);
+        lanes[i] = _mm256_xor_si256(lanes[i], _mm256_permute2x128_si256(t0, t2, 0x20));
+        lanes[i + 1] = _mm256_xor_si256(lanes[i + 1], _mm256_permute2x128_si256(t1, t3, 0x20));
+        lanes[i + 2] = _mm256_xor_si256(lanes[i + 2], _mm256_permute2x128_si256(t0, t2, 0x31));
+        lanes[i + 3] = _mm256_xor_si256(lanes[i + 3], _mm256_permute2x128_si256(t1, t3, 0x31));
+    }
+    for (; i < laneCount; i++)
+    {
+        lanes[i] = _mm256_xor_si256(lanes[i], _mm256_setr_epi64x(data[i], data[chunkLanes + i], data[2 * chunkLanes + i], data[3 * chunkLanes + i]));
+    }
+}
+
+// Chaining values of the 4 complete chunks at input (consecutive leaves of the K12 tree), 32 bytes per chunk are written to chainingValues
+static void KangarooTwelve_Leaves_4x(const unsigned char* input, unsigned char* chainingValues)
+{
+    __m256i lanes[25];
+    for (unsigned int i = 0; i < 25; i++)
+    {
+        lanes[i] = _mm256_setzero_si256();
+    }
+    const unsigned long long* data = (const unsigned long long*)input;
+    const unsigned int rateLanes = K12_rateInBytes / 8;
+    unsigned int offset = 0;
+    for (; offset + rateLanes <= K12_chunkSize / 8; offset += rateLanes)
+    {
+        KeccakP1600_AddChunkLanes_4x(lanes, data + offset, rateLanes);
+        KeccakP1600_Permute_12rounds_4x(lanes);
+    }
+    KeccakP1600_AddChunkLanes_4x(lanes, data + offset, K12_chunkSize / 8 - offset);
+    lanes[K12_chunkSize / 8 - offset] = _mm256_xor_si256(lanes[K12_chunkSize / 8 - offset], _mm256_set1_epi64x(K12_suffixLeaf));
+    lanes[rateLanes - 1] = _mm256_xor_si256(lanes[rateLanes - 1], _mm256_set1_epi64x(0x8000000000000000ULL));
+    KeccakP1600_Permute_12rounds_4x(lanes);
+
+    const __m256i t0 = _mm256_unpacklo_epi64(lanes[0], lanes[1]), t1 = _mm256_unpackhi_epi64(lanes[0], lanes[1]);
+    const __m256i t2 = _mm256_unpacklo_epi64(lanes[2], lanes[3]), t3 = _mm256_unpackhi_epi64(lanes[2], lanes[3]);
+    _mm256_storeu_si256((__m256i*)chainingValues, _mm256_permute2x128_si256(t0, t2, 0x20));
+    _mm256_storeu_si256((__m256i*)(chainingValues + K12_capacityInBytes), _mm256_permute2x128_si256(t1, t3, 0x20));
+    _mm256_storeu_si256((__m256i*)(chainingValues + 2 * K12_capacityInBytes), _mm256_permute2x128_si256(t0, t2, 0x31));
+    _mm256_storeu_si256((__m256i*)(chainingValues + 3 * K12_capacityInBytes), _mm256_permute2x128_si256(t1, t3, 0x31));
+}
+
+// Set if 4 leaves hashed side by side are faster than 4 leaves hashed one after the other
+static void (*KangarooTwelve_Leaves4x)(const unsigned char* input, unsigned char* chainingValues) = NULL;
+
+// Chaining value of the complete chunk at input
+static void KangarooTwelve_Leaf(const unsigned char* input, unsigned char* chainingValue)
+{
+    unsigned char state[200];
+    setMem(state, sizeof(state), 0);
+    const unsigned long long absorbedByteLen = KeccakP1600_AbsorbBlocks(state, input, K12_chunkSize);
+    for (unsigned int i = 0; i < K12_chunkSize - absorbedByteLen; i++)
+    {
+        state[i] ^= input[absorbedByteLen + i];
+    }
+    state[K12_chunkSize - absorbedByteLen] ^= K12_suffixLeaf;
+    state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(state);
+    copyMem(chainingValue, state, K12_capacityInBytes);
+}
+
+#define K12_PARALLEL_WINDOW 256 // Leaves published at once by KangarooTwelveParallel()
+#define K12_PARALLEL_LEAF_GROUP 4 // Leaves taken at once by a processor
+
+// Leaves of the window of a KangarooTwelveParallel() call, only one call publishes leaves at a time (kangarooTwelveJobLock).
+// The window is reconfigured only while it is inactive and no helper is registered.
+static struct
+{
+    const unsigned char* volatile input;
+    volatile long long numberOfLeaves;
+    volatile long long nextLeaf;
+    volatile long long numberOfHashedLeaves;
+    volatile long long numberOfHelpers;
+    volatile char active;
+    unsigned char chainingValues[K12_PARALLEL_WINDOW * K12_capacityInBytes];
+} kangarooTwelveJob;
+static volatile char kangarooTwelveJobLock = 0;
+
+static void hashKangarooTwelveJobLeaves()
+{
+    while (true)
+    {
+        const long long firstLeaf = _InterlockedExchangeAdd64(&kangarooTwelveJob.nextLeaf, K12_PARALLEL_LEAF_GROUP);
+        if (firstLeaf >= kangarooTwelveJob.numberOfLeaves)
+        {
+            break;
+        }
+        const long long endLeaf = firstLeaf + K12_PARALLEL_LEAF_GROUP < kangarooTwelveJob.numberOfLeaves ? firstLeaf + K12_PARALLEL_LEAF_GROUP : kangarooTwelveJob.numberOfLeaves;
+        long long leaf = firstLeaf;
+        if (KangarooTwelve_Leaves4x)
+        {
+            for (; leaf + 4 <= endLeaf; leaf += 4)
+            {
+                KangarooTwelve_Leaves4x(kangarooTwelveJob.input + leaf * K12_chunkSize, kangarooTwelveJob.chainingValues + leaf * K12_capacityInBytes);
+            }
+        }
+        for (; leaf < endLeaf; leaf++)
+        {
+            KangarooTwelve_Leaf(kangarooTwelveJob.input + leaf * K12_chunkSize, kangarooTwelveJob.chainingValues + leaf * K12_capacityInBytes);
+        }
+        _InterlockedExchangeAdd64(&kangarooTwelveJob.numberOfHashedLeaves, endLeaf - firstLeaf);
+    }
+}
+
+// To be called by idle processors, returns false if no KangarooTwelveParallel() call has leaves to hash
+static bool helpKangarooTwelveParallel()
+{
+    if (!kangarooTwelveJob.active)
+    {
+        return false;
+    }
+    _InterlockedIncrement64(&kangarooTwelveJob.numberOfHelpers);
+    if (kangarooTwelveJob.active)
+    {
+        hashKangarooTwelveJobLeaves();
+    }
+    _InterlockedDecrement64(&kangarooTwelveJob.numberOfHelpers);
+
+    return true;
+}
+
+// Chaining values of the numberOfLeaves (at most K12_PARALLEL_WINDOW) complete chunks at input into kangarooTwelveJob.chainingValues
+static void hashKangarooTwelveLeavesInParallel(const unsigned char* input, unsigned int numberOfLeaves)
+{
+    kangarooTwelveJob.input = input;
+    kangarooTwelveJob.numberOfLeaves = numberOfLeaves;
+    kangarooTwelveJob.numberOfHashedLeaves = 0;
+    kangarooTwelveJob.nextLeaf = 0;
+    kangarooTwelveJob.active = 1;
+
+    hashKangarooTwelveJobLeaves();
+    while (kangarooTwelveJob.numberOfHashedLeaves != numberOfLeaves)
+    {
+        _mm_pause();
+    }
+
+    kangarooTwelveJob.active = 0;
+    while (kangarooTwelveJob.numberOfHelpers)
+    {
+        _mm_pause();
+    }
+}
+
+static void KangarooTwelveTree(const unsigned char* input, unsigned int inputByteLen, unsigned char* output, unsigned int outputByteLen, bool parallel)
 {
     KangarooTwelve_F queueNode;
     KangarooTwelve_F finalNode;
@@ -1118,6 +1515,30 @@ static void KangarooTwelve(const unsigned char* input, unsigned int inputByteLen
 
         while (inputByteLen > 0)
         {
+            if (parallel && inputByteLen >= 2 * K12_PARALLEL_LEAF_GROUP * K12_chunkSize)
+            {
+                const unsigned int numberOfLeaves = inputByteLen / K12_chunkSize < K12_PARALLEL_WINDOW ? inputByteLen / K12_chunkSize : K12_PARALLEL_WINDOW;
+                hashKangarooTwelveLeavesInParallel(input, numberOfLeaves);
+                KangarooTwelve_F_Absorb(&finalNode, kangarooTwelveJob.chainingValues, numberOfLeaves * K12_capacityInBytes);
+                input += numberOfLeaves * K12_chunkSize;
+                inputByteLen -= numberOfLeaves * K12_chunkSize;
+                blockNumber += numberOfLeaves;
+
+                continue;
+            }
+
+            if (KangarooTwelve_Leaves4x && inputByteLen >= 4 * K12_chunkSize)
+            {
+                unsigned char chainingValues[4 * K12_capacityInBytes];
+                KangarooTwelve_Leaves4x(input, chainingValues);
+                KangarooTwelve_F_Absorb(&finalNode, chainingValues, sizeof(chainingValues));
+                input += 4 * K12_chunkSize;
+                inputByteLen -= 4 * K12_chunkSize;
+                blockNumber += 4;
+
+                continue;
+            }
+
             const unsigned int len = K12_chunkSize ^ ((inputByteLen ^ K12_chunkSize) & -(inputByteLen < K12_chunkSize));
             setMem(&queueNode, sizeof(KangarooTwelve_F), 0);
             KangarooTwelve_F_Absorb(&queueNode, input, len);
@@ -1228,14 +1649,34 @@ static void KangarooTwelve(const unsigned char* input, unsigned int inputByteLen
     copyMem(output, finalNode.state, outputByteLen);
 }
 
+static void KangarooTwelve(const unsigned char* input, unsigned int inputByteLen, unsigned char* output, unsigned int outputByteLen)
+{
+    KangarooTwelveTree(input, inputByteLen, output, outputByteLen, false);
+}
+
 static inline void KangarooTwelve(const void* input, unsigned int inputByteLen, void* output, unsigned int outputByteLen)
 {
     KangarooTwelve((const unsigned char*)input, inputByteLen, (unsigned char*)output, outputByteLen);
 }
 
-static void KangarooTwelve64To32(const unsigned char* input, unsigned char* output)
+// Same digest as KangarooTwelve(), the leaves of large inputs are shared with the processors calling helpKangarooTwelveParallel().
+// Falls back to KangarooTwelve() while another call is sharing its leaves.
+static void KangarooTwelveParallel(const void* input, unsigned int inputByteLen, void* output, unsigned int outputByteLen)
+{
+    if (inputByteLen >= (2 * K12_PARALLEL_LEAF_GROUP + 1) * K12_chunkSize
+        && !_InterlockedCompareExchange8(&kangarooTwelveJobLock, 1, 0))
+    {
+        KangarooTwelveTree((const unsigned char*)input, inputByteLen, (unsigned char*)output, outputByteLen, true);
+        RELEASE(kangarooTwelveJobLock);
+    }
+    else
+    {
+        KangarooTwelve(input, inputByteLen, output, outputByteLen);
+    }
+}
+
+TARGET_AVX512 static void KangarooTwelve64To32_AVX512(const unsigned char* input, unsigned char* output)
 {
-#ifdef __AVX512F__
     __m512i Baeiou = _mm512_maskz_loadu_epi64(0x1F, input);
     __m512i Gaeiou = _mm512_set_epi64(0, 0, 0, 0, 0x0700, ((unsigned long long*)input)[7], ((unsigned long long*)input)[6], ((unsigned long long*)input)[5]);
 
@@ -1502,7 +1943,10 @@ static void KangarooTwelve64To32(const unsigned char* input, unsigned char* outp
     b0 = _mm512_permutexvar_epi64(pi1B, _mm512_rolv_epi64(_mm512_ternarylogic_epi64(Baeiou, b0, b1, 0x96), rhoB));
 
     _mm512_mask_storeu_epi64(output, 0xF, _mm512_permutex2var_epi64(_mm512_permutex2var_epi64(_mm512_unpacklo_epi64(_mm512_xor_si512(_mm512_ternarylogic_epi64(b0, b5, b2, 0xD2), K12RoundConst11), _mm512_ternarylogic_epi64(b5, b2, b3, 0xD2)), pi2S1, _mm512_ternarylogic_epi64(b4, b0, b5, 0xD2)), pi2BG, _mm512_unpacklo_epi64(_mm512_ternarylogic_epi64(b2, b3, b4, 0xD2), _mm512_ternarylogic_epi64(b3, b4, b0, 0xD2))));
-#else
+}
+
+static void KangarooTwelve64To32_Generic(const unsigned char* input, unsigned char* output)
+{
     unsigned long long Aba, Abe, Abi, Abo, Abu;
     unsigned long long Aga, Age, Agi, Ago, Agu;
     unsigned long long Aka, Ake, Aki, Ako, Aku;
@@ -2186,7 +2630,13 @@ static void KangarooTwelve64To32(const unsigned char* input, unsigned char* outp
     ((unsigned long long*)output)[1] = Bbe ^ _andn_u64(Bbi, Bbo);
     ((unsigned long long*)output)[2] = Bbi ^ _andn_u64(Bbo, Bbu);
     ((unsigned long long*)output)[3] = Bbo ^ _andn_u64(Bbu, Bba);
-#endif
+}
+
+static void (*KangarooTwelve64To32Kernel)(const unsigned char* input, unsigned char* output) = KangarooTwelve64To32_Generic;
+
+static void KangarooTwelve64To32(const unsigned char* input, unsigned char* output)
+{
+    KangarooTwelve64To32Kernel(input, output);
 }
 
 static void KangarooTwelve64To32(const void* input, void* output)
@@ -2194,11 +2644,177 @@ static void KangarooTwelve64To32(const void* input, void* output)
     KangarooTwelve64To32((const unsigned char*)input, (unsigned char*)output);
 }
 
+// KangarooTwelve64To32() of the 4 consecutive 64-byte inputs, hashed side by side
+static void KangarooTwelve64To32_4x(const unsigned char* inputs, unsigned char* outputs)
+{
+    __m256i lanes[25];
+    const unsigned long long* data = (const unsigned long long*)inputs;
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        lanes[i] = _mm256_setr_epi64x(data[i], data[8 + i], data[16 + i], data[24 + i]);
+    }
+    lanes[8] = _mm256_set1_epi64x(0x0700);
+    for (unsigned int i = 9; i < 25; i++)
+    {
+        lanes[i] = _mm256_setzero_si256();
+    }
+    lanes[20] = _mm256_set1_epi64x(0x8000000000000000ULL);
+    KeccakP1600_Permute_12rounds_4x(lanes);
+
+    const __m256i t0 = _mm256_unpacklo_epi64(lanes[0], lanes[1]), t1 = _mm256_unpackhi_epi64(lanes[0], lanes[1]);
+    const __m256i t2 = _mm256_unpacklo_epi64(lanes[2], lanes[3]), t3 = _mm256_unpackhi_epi64(lanes[2], lanes[3]);
+    _mm256_storeu_si256((__m256i*)outputs, _mm256_permute2x128_si256(t0, t2, 0x20));
+    _mm256_storeu_si256((__m256i*)(outputs + 32), _mm256_permute2x128_si256(t1, t3, 0x20));
+    _mm256_storeu_si256((__m256i*)(outputs + 64), _mm256_permute2x128_si256(t0, t2, 0x31));
+    _mm256_storeu_si256((__m256i*)(outputs + 96), _mm256_permute2x128_si256(t1, t3, 0x31));
+}
+
+// Set if 4 inputs hashed side by side are faster than 4 inputs hashed one after the other
+static void (*KangarooTwelve64To32x4)(const unsigned char* inputs, unsigned char* outputs) = NULL;
+
+// KangarooTwelve64To32() of numberOfInputs consecutive 64-byte inputs, 32 bytes per input are written to outputs
+static void KangarooTwelve64To32Batch(const void* inputs, void* outputs, unsigned int numberOfInputs)
+{
+    unsigned int i = 0;
+    if (KangarooTwelve64To32x4)
+    {
+        for (; i + 4 <= numberOfInputs; i += 4)
+        {
+            KangarooTwelve64To32x4((const unsigned char*)inputs + i * 64, (unsigned char*)outputs + i * 32);
+        }
+    }
+    for (; i < numberOfInputs; i++)
+    {
+        KangarooTwelve64To32((const unsigned char*)inputs + i * 64, (unsigned char*)outputs + i * 32);
+    }
+}
+
+// Minimum TSC cycles of 16 permutations, for picking variants whose relative speed depends on the micro-architecture
+static unsigned long long measureKeccakP1600Permutation(void (*permute)(unsigned char* state))
+{
+    static unsigned char state[200]; // Static so that the permutations are not optimized away
+    unsigned long long minCycles = 0xFFFFFFFFFFFFFFFFULL;
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        const unsigned long long start = __rdtsc();
+        for (unsigned int j = 0; j < 16; j++)
+        {
+            permute(state);
+        }
+        const unsigned long long cycles = __rdtsc() - start;
+        if (cycles < minCycles)
+        {
+            minCycles = cycles;
+        }
+    }
+
+    return minCycles;
+}
+
+static unsigned long long measureKangarooTwelveLeaves(bool sideBySide)
+{
+    static unsigned char chunks[4 * K12_chunkSize], chainingValues[4 * K12_capacityInBytes];
+    unsigned long long minCycles = 0xFFFFFFFFFFFFFFFFULL;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        const unsigned long long start = __rdtsc();
+        if (sideBySide)
+        {
+            KangarooTwelve_Leaves_4x(chunks, chainingValues);
+        }
+        else
+        {
+            for (unsigned int j = 0; j < 4; j++)
+            {
+                KangarooTwelve_Leaf(chunks + j * K12_chunkSize, chainingValues + j * K12_capacityInBytes);
+            }
+        }
+        const unsigned long long cycles = __rdtsc() - start;
+        if (cycles < minCycles)
+        {
+            minCycles = cycles;
+        }
+    }
+
+    return minCycles;
+}
+
+static unsigned long long measureKangarooTwelve64To32(bool sideBySide)
+{
+    static unsigned char inputs[4 * 64], outputs[4 * 32];
+    unsigned long long minCycles = 0xFFFFFFFFFFFFFFFFULL;
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        const unsigned long long start = __rdtsc();
+        for (unsigned int j = 0; j < 4; j++)
+        {
+            if (sideBySide)
+            {
+                KangarooTwelve64To32_4x(inputs, outputs);
+            }
+            else
+            {
+                for (unsigned int k = 0; k < 4; k++)
+                {
+                    KangarooTwelve64To32(inputs + k * 64, outputs + k * 32);
+                }
+            }
+        }
+        const unsigned long long cycles = __rdtsc() - start;
+        if (cycles < minCycles)
+        {
+            minCycles = cycles;
+        }
+    }
+
+    return minCycles;
+}
+
+// Binds the Keccak-p[1600,12] kernels to the fastest variants the CPU supports, cpuFeatures must be set before
+static void selectKangarooTwelveKernels()
+{
+    if (cpuFeatures.avx512)
+    {
+        initAVX512KangarooTwelveConstants();
+        KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_AVX512;
+        KeccakP1600_AbsorbBlocks = KeccakP1600_AbsorbBlocks_AVX512;
+        KangarooTwelve64To32Kernel = KangarooTwelve64To32_AVX512;
+    }
+    else
+    {
+        KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_Generic;
+        KeccakP1600_AbsorbBlocks = KeccakP1600_AbsorbBlocks_Generic;
+        KangarooTwelve64To32Kernel = KangarooTwelve64To32_Generic;
+    }
+    KangarooTwelve_Leaves4x = NULL;
+    KangarooTwelve64To32x4 = NULL;
+
+#if K12_AVX2_KERNELS
+    if (cpuFeatures.avx2)
+    {
+        // The single-state variant competes with the scalar code only, AVX-512 is always faster
+        if (!cpuFeatures.avx512
+            && (K12_AVX2_KERNELS == 1 || measureKeccakP1600Permutation(KeccakP1600_Permute_12rounds_AVX2) < measureKeccakP1600Permutation(KeccakP1600_Permute_12rounds_Generic)))
+        {
+            KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_AVX2;
+        }
+        if (K12_AVX2_KERNELS == 1 || measureKangarooTwelveLeaves(true) < measureKangarooTwelveLeaves(false))
+        {
+            KangarooTwelve_Leaves4x = KangarooTwelve_Leaves_4x;
+        }
+        if (K12_AVX2_KERNELS == 1 || measureKangarooTwelve64To32(true) < measureKangarooTwelve64To32(false))
+        {
+            KangarooTwelve64To32x4 = KangarooTwelve64To32_4x;
+        }
+    }
+#endif
+}
+
 void random(const unsigned char* publicKey, const unsigned char* nonce, unsigned char* output, unsigned int outputSize)
 {
     unsigned char state[200];
-    *((__m256i*) & state[0]) = *((__m256i*)publicKey);
-    *((__m256i*) & state[32]) = *((__m256i*)nonce);
+    _mm256_storeu_si256((__m256i*)&state[0], _mm256_loadu_si256((__m256i*)publicKey));
+    _mm256_storeu_si256((__m256i*)&state[32], _mm256_loadu_si256((__m256i*)nonce));
     setMem(&state[64], sizeof(state) - 64, 0);
 
     for (unsigned int i = 0; i < outputSize / sizeof(state); i++)
@@ -2213,3 +2829,24 @@ void random(const unsigned char* publicKey, const unsigned char* nonce, unsigned
         copyMem(output, state, outputSize % sizeof(state));
     }
 }
+
+// Incremental version of random(), yields the same output in blocks of RANDOM_STREAM_BLOCK_SIZE bytes
+#define RANDOM_STREAM_BLOCK_SIZE 200
+
+struct RandomStream
+{
+    unsigned char state[200];
+
+    void init(const unsigned char* publicKey, const unsigned char* nonce)
+    {
+        _mm256_storeu_si256((__m256i*)&state[0], _mm256_loadu_si256((__m256i*)publicKey));
+        _mm256_storeu_si256((__m256i*)&state[32], _mm256_loadu_si256((__m256i*)nonce));
+        setMem(&state[64], sizeof(state) - 64, 0);
+    }
+
+    void next(unsigned char* output)
+    {
+        KeccakP1600_Permute_12rounds(state);
+        copyMem(output, state, sizeof(state));
+    }
+};
@@ -11,6 +11,8 @@
 #include "entity.h"
 #include "public_peers.h"
 #include "special_command.h"
+#include "state_sync.h"
 #include "tick.h"
+#include "tick_phase_latencies.h"
 #include "transactions.h"
 #include "system_info.h"
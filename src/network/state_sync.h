@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common_def.h"
+
+#define STATE_SYNC_SPECTRUM 0
+#define STATE_SYNC_UNIVERSE 1
+#define STATE_SYNC_COMPUTER 2
+#define NUMBER_OF_SYNCED_STATES 3
+
+
+// Fetches the digests of the chunks of a state, the nodes of its Merkle tree at the chunk level (the leaves for the computer)
+struct RequestStateDigests
+{
+    unsigned char state;
+
+    enum {
+        type = 50,
+    };
+};
+
+
+// Followed by numberOfChunks digests
+struct RespondStateDigests
+{
+    unsigned int tick; // Current tick of the responder, its states may already include a part of the tick
+    unsigned char state;
+    unsigned char padding[3];
+    unsigned int numberOfChunks;
+
+    enum {
+        type = 51,
+    };
+};
+
+static_assert(sizeof(RespondStateDigests) == 4 + 1 + 3 + 4, "Something is wrong with the struct size.");
+
+
+struct RequestStateChunk
+{
+    unsigned char state;
+    unsigned char padding[3];
+    unsigned int chunkIndex; // Contract index for the computer
+    unsigned int offset; // Offset in the contract state for the computer
+
+    enum {
+        type = 52,
+    };
+};
+
+
+// Followed by size bytes of the leaves of the chunk or of the contract state
+struct RespondStateChunk
+{
+    unsigned int tick; // Current tick of the responder, its states may already include a part of the tick
+    unsigned char state;
+    unsigned char padding[3];
+    unsigned int chunkIndex;
+    unsigned int offset;
+    unsigned int size;
+
+    enum {
+        type = 53,
+    };
+};
+
+static_assert(sizeof(RespondStateChunk) == 4 + 1 + 3 + 4 + 4 + 4, "Something is wrong with the struct size.");
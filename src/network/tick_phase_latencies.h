@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common_def.h"
+
+#define TICK_PHASE_BEGIN_TICK 0
+#define TICK_PHASE_TRANSACTIONS 1 // Without IPO bids and solutions
+#define TICK_PHASE_IPO_BIDS 2
+#define TICK_PHASE_SOLUTIONS 3
+#define TICK_PHASE_END_TICK 4
+#define TICK_PHASE_SPECTRUM_DIGEST 5
+#define TICK_PHASE_UNIVERSE_DIGEST 6
+#define TICK_PHASE_COMPUTER_DIGEST 7
+#define TICK_PHASE_TICK_ASSEMBLY 8
+#define NUMBER_OF_TICK_PHASES 9
+
+
+// Fetches the latencies of the phases of the tick processing
+struct RequestTickPhaseLatencies
+{
+    enum {
+        type = 48,
+    };
+};
+
+
+struct TickPhaseLatency
+{
+    unsigned int p50; // Microseconds, rounded up to the bucket of the histogram
+    unsigned int p99; // Microseconds, rounded up to the bucket of the histogram
+    unsigned int max; // Microseconds
+};
+
+struct RespondTickPhaseLatencies
+{
+    unsigned int tick; // Latest processed tick
+    unsigned int numberOfTicks; // Number of ticks the latencies are taken over
+    TickPhaseLatency phases[NUMBER_OF_TICK_PHASES];
+
+    enum {
+        type = 49,
+    };
+};
+
+static_assert(sizeof(RespondTickPhaseLatencies) == 4 + 4 + NUMBER_OF_TICK_PHASES * 3 * 4, "Something is wrong with the struct size.");
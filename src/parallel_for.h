@@ -0,0 +1,85 @@
+#pragma once
+
+#include <intrin.h>
+
+#include "platform/concurrency.h"
+
+// Loop of independent iterations run by the processor that begins it and by the idle processors calling helpParallelFor(),
+// which take the indices in groups. Only one loop runs at a time and it must be finished by the processor that began it.
+static struct
+{
+    void (*volatile body)(void* context, unsigned int index);
+    void* volatile context;
+    volatile long long numberOfIndices;
+    volatile long long groupSize;
+    volatile long long nextIndex;
+    volatile long long numberOfHelpers;
+    volatile char active;
+} parallelForJob;
+
+static void runParallelForJob()
+{
+    while (true)
+    {
+        const long long firstIndex = _InterlockedExchangeAdd64(&parallelForJob.nextIndex, parallelForJob.groupSize);
+        if (firstIndex >= parallelForJob.numberOfIndices)
+        {
+            break;
+        }
+        const long long endIndex = firstIndex + parallelForJob.groupSize < parallelForJob.numberOfIndices ? firstIndex + parallelForJob.groupSize : parallelForJob.numberOfIndices;
+        for (long long index = firstIndex; index < endIndex; index++)
+        {
+            parallelForJob.body(parallelForJob.context, (unsigned int)index);
+        }
+    }
+}
+
+// To be called by idle processors, returns false if no loop has indices to run
+static bool helpParallelFor()
+{
+    if (!parallelForJob.active)
+    {
+        return false;
+    }
+    _InterlockedIncrement64(&parallelForJob.numberOfHelpers);
+    if (parallelForJob.active)
+    {
+        runParallelForJob();
+    }
+    _InterlockedDecrement64(&parallelForJob.numberOfHelpers);
+
+    return true;
+}
+
+// Publishes body(context, index) for index in [0, numberOfIndices) and returns at once, idle processors run the iterations until
+// finishParallelFor() is called
+static void beginParallelFor(void (*body)(void* context, unsigned int index), void* context, unsigned int numberOfIndices, unsigned int groupSize)
+{
+    parallelForJob.body = body;
+    parallelForJob.context = context;
+    parallelForJob.numberOfIndices = numberOfIndices;
+    parallelForJob.groupSize = groupSize;
+    parallelForJob.nextIndex = 0;
+    parallelForJob.active = 1;
+}
+
+// Runs the iterations no processor has taken yet and waits until the helpers have completed theirs
+static void finishParallelFor()
+{
+    if (parallelForJob.active)
+    {
+        runParallelForJob();
+
+        parallelForJob.active = 0;
+        while (parallelForJob.numberOfHelpers)
+        {
+            _mm_pause();
+        }
+    }
+}
+
+static void parallelFor(void (*body)(void* context, unsigned int index), void* context, unsigned int numberOfIndices, unsigned int groupSize)
+{
+    beginParallelFor(body, context, numberOfIndices, groupSize);
+    finishParallelFor();
+}
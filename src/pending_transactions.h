@@ -0,0 +1,366 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+
+#define PENDING_TRANSACTIONS_ARENA_SIZE 1073741824ULL // Must be a multiple of PENDING_TRANSACTION_BLOCK_SIZE
+#define MAX_NUMBER_OF_PENDING_TRANSACTIONS 0x400000
+#define PENDING_TRANSACTION_BLOCK_SIZE 64ULL
+#define NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES 32 // Transactions of up to PENDING_TRANSACTION_BLOCK_SIZE * NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES bytes
+#define NO_PENDING_TRANSACTION 0xFFFFFFFF
+#define MAX_PENDING_TRANSACTION_EVICTION_STEPS 4096 // Entries and ticks looked at to make room for a transaction, bounds the time under the lock
+
+// Pool of the transactions waiting for their tick, at most one per source entity: a transaction with a higher tick replaces
+// the previous one of the same source. Transactions are stored in a slab arena with a free list per size class (multiples of
+// PENDING_TRANSACTION_BLOCK_SIZE), a larger free block is split if there is none of the size class. Entries are found by source
+// index and by tick. The tick lists form a ring indexed by tick % numberOfPendingTransactionTickLists, so the ticks of the pending
+// transactions must not span more lists than that. A full pool makes room by evicting the transactions of the farthest ticks.
+struct PendingTransaction
+{
+    m256i digest; // Of the whole transaction including the signature
+    unsigned long long offset; // Of the transaction in pendingTransactionsArena
+    unsigned int tick;
+    unsigned int sourceIndex;
+    unsigned int size; // 0 if the entry is free
+    unsigned int previous, next; // Entries of the same tick list (next links the free entries), NO_PENDING_TRANSACTION at the ends
+};
+
+static volatile char pendingTransactionsLock = 0;
+static unsigned char* pendingTransactionsArena = NULL;
+static unsigned long long pendingTransactionsArenaEnd; // Blocks below are used or free, blocks above have never been used
+static unsigned long long freePendingTransactionBlocks[NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES]; // First 8 bytes of a free block hold the offset of the next one
+static PendingTransaction* pendingTransactions = NULL;
+static unsigned int firstFreePendingTransaction;
+static unsigned int numberOfPendingTransactions;
+static unsigned int* pendingTransactionsBySource = NULL;
+static unsigned long long numberOfPendingTransactionSources;
+static unsigned int* pendingTransactionsByTick = NULL;
+static unsigned int numberOfPendingTransactionTickLists;
+static unsigned int oldestPendingTransactionTick; // Transactions of earlier ticks have been removed
+static unsigned int newestPendingTransactionTick; // Transactions of later ticks have been removed or evicted
+static unsigned long long numberOfRejectedPendingTransactions; // Without room even after evicting the transactions of later ticks
+
+// Not thread-safe, only call when no other processor uses the pool
+static void clearPendingTransactions()
+{
+    pendingTransactionsArenaEnd = 0;
+    for (unsigned int i = 0; i < NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES; i++)
+    {
+        freePendingTransactionBlocks[i] = PENDING_TRANSACTIONS_ARENA_SIZE;
+    }
+    for (unsigned int i = 0; i < MAX_NUMBER_OF_PENDING_TRANSACTIONS; i++)
+    {
+        pendingTransactions[i].size = 0;
+        pendingTransactions[i].next = i + 1 < MAX_NUMBER_OF_PENDING_TRANSACTIONS ? i + 1 : NO_PENDING_TRANSACTION;
+    }
+    firstFreePendingTransaction = 0;
+    numberOfPendingTransactions = 0;
+    setMem(pendingTransactionsBySource, numberOfPendingTransactionSources * sizeof(unsigned int), 0xFF);
+    setMem(pendingTransactionsByTick, numberOfPendingTransactionTickLists * sizeof(unsigned int), 0xFF);
+    oldestPendingTransactionTick = 0;
+    newestPendingTransactionTick = 0;
+    numberOfRejectedPendingTransactions = 0;
+}
+
+// numberOfSources is the number of source indices (spectrum capacity), numberOfTickLists the maximal tick span of the pool
+static bool initPendingTransactions(unsigned long long numberOfSources, unsigned int numberOfTickLists)
+{
+    if (!allocatePool(PENDING_TRANSACTIONS_ARENA_SIZE, (void**)&pendingTransactionsArena)
+        || !allocatePool(MAX_NUMBER_OF_PENDING_TRANSACTIONS * sizeof(PendingTransaction), (void**)&pendingTransactions)
+        || !allocatePool(numberOfSources * sizeof(unsigned int), (void**)&pendingTransactionsBySource)
+        || !allocatePool(numberOfTickLists * sizeof(unsigned int), (void**)&pendingTransactionsByTick))
+    {
+        return false;
+    }
+    numberOfPendingTransactionSources = numberOfSources;
+    numberOfPendingTransactionTickLists = numberOfTickLists;
+    clearPendingTransactions();
+
+    return true;
+}
+
+static void deinitPendingTransactions()
+{
+    if (pendingTransactionsByTick)
+    {
+        freePool(pendingTransactionsByTick);
+    }
+    if (pendingTransactionsBySource)
+    {
+        freePool(pendingTransactionsBySource);
+    }
+    if (pendingTransactions)
+    {
+        freePool(pendingTransactions);
+    }
+    if (pendingTransactionsArena)
+    {
+        freePool(pendingTransactionsArena);
+    }
+}
+
+// Caller must hold pendingTransactionsLock
+static void removePendingTransaction(unsigned int index)
+{
+    PendingTransaction& entry = pendingTransactions[index];
+    if (entry.previous != NO_PENDING_TRANSACTION)
+    {
+        pendingTransactions[entry.previous].next = entry.next;
+    }
+    else
+    {
+        pendingTransactionsByTick[entry.tick % numberOfPendingTransactionTickLists] = entry.next;
+    }
+    if (entry.next != NO_PENDING_TRANSACTION)
+    {
+        pendingTransactions[entry.next].previous = entry.previous;
+    }
+    if (entry.sourceIndex < numberOfPendingTransactionSources && pendingTransactionsBySource[entry.sourceIndex] == index)
+    {
+        pendingTransactionsBySource[entry.sourceIndex] = NO_PENDING_TRANSACTION;
+    }
+
+    const unsigned int sizeClass = (unsigned int)((entry.size - 1) / PENDING_TRANSACTION_BLOCK_SIZE);
+    *((unsigned long long*)&pendingTransactionsArena[entry.offset]) = freePendingTransactionBlocks[sizeClass];
+    freePendingTransactionBlocks[sizeClass] = entry.offset;
+
+    entry.size = 0;
+    entry.next = firstFreePendingTransaction;
+    firstFreePendingTransaction = index;
+    numberOfPendingTransactions--;
+}
+
+// Whether a block of the size class is free, can be split from a larger free block or is left at the end of the arena
+static bool hasFreePendingTransactionBlock(unsigned int sizeClass)
+{
+    for (unsigned int largerSizeClass = sizeClass; largerSizeClass < NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES; largerSizeClass++)
+    {
+        if (freePendingTransactionBlocks[largerSizeClass] != PENDING_TRANSACTIONS_ARENA_SIZE)
+        {
+            return true;
+        }
+    }
+    return pendingTransactionsArenaEnd + (sizeClass + 1) * PENDING_TRANSACTION_BLOCK_SIZE <= PENDING_TRANSACTIONS_ARENA_SIZE;
+}
+
+// Only call if hasFreePendingTransactionBlock(sizeClass), the rest of a split block goes to the free list of its size class
+static unsigned long long allocatePendingTransactionBlock(unsigned int sizeClass)
+{
+    for (unsigned int largerSizeClass = sizeClass; largerSizeClass < NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES; largerSizeClass++)
+    {
+        const unsigned long long offset = freePendingTransactionBlocks[largerSizeClass];
+        if (offset != PENDING_TRANSACTIONS_ARENA_SIZE)
+        {
+            freePendingTransactionBlocks[largerSizeClass] = *((unsigned long long*)&pendingTransactionsArena[offset]);
+            if (largerSizeClass > sizeClass)
+            {
+                const unsigned long long restOffset = offset + (sizeClass + 1) * PENDING_TRANSACTION_BLOCK_SIZE;
+                const unsigned int restSizeClass = largerSizeClass - sizeClass - 1;
+                *((unsigned long long*)&pendingTransactionsArena[restOffset]) = freePendingTransactionBlocks[restSizeClass];
+                freePendingTransactionBlocks[restSizeClass] = restOffset;
+            }
+            return offset;
+        }
+    }
+    const unsigned long long offset = pendingTransactionsArenaEnd;
+    pendingTransactionsArenaEnd += (sizeClass + 1) * PENDING_TRANSACTION_BLOCK_SIZE;
+    return offset;
+}
+
+// Whether a transaction of the size class fits once the entry replacedIndex (NO_PENDING_TRANSACTION if none) is removed
+static bool hasRoomForPendingTransaction(unsigned int sizeClass, unsigned int replacedIndex)
+{
+    if (firstFreePendingTransaction == NO_PENDING_TRANSACTION && replacedIndex == NO_PENDING_TRANSACTION)
+    {
+        return false;
+    }
+    return hasFreePendingTransactionBlock(sizeClass)
+        || (replacedIndex != NO_PENDING_TRANSACTION && (pendingTransactions[replacedIndex].size - 1) / PENDING_TRANSACTION_BLOCK_SIZE >= sizeClass);
+}
+
+// Evicts the transactions of the farthest ticks after tick until a transaction of the size class fits, caller must hold
+// pendingTransactionsLock
+static bool makeRoomForPendingTransaction(unsigned int sizeClass, unsigned int tick, unsigned int replacedIndex)
+{
+    unsigned int evictionTick = newestPendingTransactionTick;
+    unsigned int numberOfSteps = 0;
+    while (!hasRoomForPendingTransaction(sizeClass, replacedIndex))
+    {
+        if (evictionTick <= tick || numberOfSteps >= MAX_PENDING_TRANSACTION_EVICTION_STEPS)
+        {
+            return false;
+        }
+
+        // Any entry helps if only entries are missing, otherwise its block must be large enough for the size class
+        const bool isBlockMissing = !hasFreePendingTransactionBlock(sizeClass);
+        unsigned int evictedIndex = NO_PENDING_TRANSACTION;
+        bool isTickEmpty = true;
+        for (unsigned int index = pendingTransactionsByTick[evictionTick % numberOfPendingTransactionTickLists]; index != NO_PENDING_TRANSACTION && numberOfSteps < MAX_PENDING_TRANSACTION_EVICTION_STEPS; index = pendingTransactions[index].next)
+        {
+            numberOfSteps++;
+            if (pendingTransactions[index].tick == evictionTick)
+            {
+                isTickEmpty = false;
+                if (!isBlockMissing || (pendingTransactions[index].size - 1) / PENDING_TRANSACTION_BLOCK_SIZE >= sizeClass)
+                {
+                    evictedIndex = index;
+                    break;
+                }
+            }
+        }
+        if (evictedIndex != NO_PENDING_TRANSACTION)
+        {
+            removePendingTransaction(evictedIndex);
+        }
+        else if (numberOfSteps < MAX_PENDING_TRANSACTION_EVICTION_STEPS)
+        {
+            if (isTickEmpty && evictionTick == newestPendingTransactionTick)
+            {
+                newestPendingTransactionTick--;
+            }
+            evictionTick--;
+            numberOfSteps++;
+        }
+    }
+
+    return true;
+}
+
+// Stores the transaction unless the source already has one with the same or a higher tick, or the pool is full even after
+// evicting the transactions of later ticks
+static bool addPendingTransaction(unsigned int sourceIndex, const void* transaction, unsigned int size, unsigned int tick, const m256i& digest)
+{
+    if (!size || size > PENDING_TRANSACTION_BLOCK_SIZE * NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES || sourceIndex >= numberOfPendingTransactionSources)
+    {
+        return false;
+    }
+    const unsigned int sizeClass = (size - 1) / PENDING_TRANSACTION_BLOCK_SIZE;
+
+    ACQUIRE(pendingTransactionsLock);
+
+    if (tick < oldestPendingTransactionTick || tick - oldestPendingTransactionTick >= numberOfPendingTransactionTickLists
+        || (pendingTransactionsBySource[sourceIndex] != NO_PENDING_TRANSACTION && pendingTransactions[pendingTransactionsBySource[sourceIndex]].tick >= tick))
+    {
+        RELEASE(pendingTransactionsLock);
+
+        return false;
+    }
+    // The previous transaction of the source is kept if the new one does not fit
+    if (!makeRoomForPendingTransaction(sizeClass, tick, pendingTransactionsBySource[sourceIndex]))
+    {
+        numberOfRejectedPendingTransactions++;
+
+        RELEASE(pendingTransactionsLock);
+
+        return false;
+    }
+    if (pendingTransactionsBySource[sourceIndex] != NO_PENDING_TRANSACTION)
+    {
+        removePendingTransaction(pendingTransactionsBySource[sourceIndex]);
+    }
+    const unsigned long long offset = allocatePendingTransactionBlock(sizeClass);
+
+    const unsigned int index = firstFreePendingTransaction;
+    PendingTransaction& entry = pendingTransactions[index];
+    firstFreePendingTransaction = entry.next;
+    entry.digest = digest;
+    entry.offset = offset;
+    entry.tick = tick;
+    entry.sourceIndex = sourceIndex;
+    entry.size = size;
+    entry.previous = NO_PENDING_TRANSACTION;
+    entry.next = pendingTransactionsByTick[tick % numberOfPendingTransactionTickLists];
+    if (entry.next != NO_PENDING_TRANSACTION)
+    {
+        pendingTransactions[entry.next].previous = index;
+    }
+    pendingTransactionsByTick[tick % numberOfPendingTransactionTickLists] = index;
+    pendingTransactionsBySource[sourceIndex] = index;
+    numberOfPendingTransactions++;
+    if (tick > newestPendingTransactionTick)
+    {
+        newestPendingTransactionTick = tick;
+    }
+    copyMem(&pendingTransactionsArena[offset], transaction, size);
+
+    RELEASE(pendingTransactionsLock);
+
+    return true;
+}
+
+// Drops the transactions of the ticks before tick, costs O(removed transactions + skipped ticks)
+static void removePendingTransactionsBeforeTick(unsigned int tick)
+{
+    if (tick <= oldestPendingTransactionTick)
+    {
+        return;
+    }
+
+    ACQUIRE(pendingTransactionsLock);
+
+    unsigned int firstTick = oldestPendingTransactionTick;
+    if (tick - firstTick > numberOfPendingTransactionTickLists)
+    {
+        firstTick = tick - numberOfPendingTransactionTickLists;
+    }
+    for (unsigned int t = firstTick; t < tick; t++)
+    {
+        unsigned int index = pendingTransactionsByTick[t % numberOfPendingTransactionTickLists];
+        while (index != NO_PENDING_TRANSACTION)
+        {
+            const unsigned int next = pendingTransactions[index].next;
+            if (pendingTransactions[index].tick < tick)
+            {
+                removePendingTransaction(index);
+            }
+            index = next;
+        }
+    }
+    if (tick > oldestPendingTransactionTick)
+    {
+        oldestPendingTransactionTick = tick;
+    }
+
+    RELEASE(pendingTransactionsLock);
+}
+
+// First entry of the list of tick (entries of other ticks sharing the list have to be skipped), caller must hold pendingTransactionsLock
+static unsigned int firstPendingTransaction(unsigned int tick)
+{
+    return pendingTransactionsByTick[tick % numberOfPendingTransactionTickLists];
+}
+
+static const unsigned char* pendingTransactionData(unsigned int index)
+{
+    return &pendingTransactionsArena[pendingTransactions[index].offset];
+}
+
+// Source indices change when the spectrum is reorganized, getSourceIndex(const unsigned char* transaction) returns the new index of the
+// source of a transaction or -1 to drop it
+template <typename GetSourceIndex>
+static void reindexPendingTransactions(GetSourceIndex getSourceIndex)
+{
+    ACQUIRE(pendingTransactionsLock);
+
+    setMem(pendingTransactionsBySource, numberOfPendingTransactionSources * sizeof(unsigned int), 0xFF);
+    for (unsigned int i = 0; i < MAX_NUMBER_OF_PENDING_TRANSACTIONS; i++)
+    {
+        if (pendingTransactions[i].size)
+        {
+            const int sourceIndex = getSourceIndex(pendingTransactionData(i));
+            if (sourceIndex < 0 || (unsigned long long)sourceIndex >= numberOfPendingTransactionSources)
+            {
+                pendingTransactions[i].sourceIndex = NO_PENDING_TRANSACTION;
+                removePendingTransaction(i);
+            }
+            else
+            {
+                pendingTransactions[i].sourceIndex = sourceIndex;
+                pendingTransactionsBySource[sourceIndex] = i;
+            }
+        }
+    }
+
+    RELEASE(pendingTransactionsLock);
+}
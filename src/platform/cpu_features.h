@@ -0,0 +1,67 @@
+#pragma once
+
+#include <intrin.h>
+
+// Instruction set extensions used to select the variants of the hot kernels at run-time, so that a single binary
+// built for AVX2 uses the AVX-512 code paths on CPUs providing them
+
+#if defined(_MSC_VER)
+// MSVC compiles intrinsics of any instruction set regardless of /arch, callers have to check cpuFeatures
+#define TARGET_AVX512
+#define TARGET_AVX512_VPOPCNTDQ
+#define TARGET_AVX512_IFMA
+#else
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl")))
+#define TARGET_AVX512_VPOPCNTDQ __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx512vpopcntdq")))
+#define TARGET_AVX512_IFMA __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx512ifma")))
+#endif
+
+struct CpuFeatures
+{
+    bool avx2;
+    bool avx512; // F, DQ, BW and VL
+    bool avx512Vpopcntdq;
+    bool avx512Ifma;
+};
+
+static CpuFeatures cpuFeatures = { false, false, false, false };
+
+// State components (bits of XCR0) supported by the CPU
+static unsigned long long getSupportedXcr0()
+{
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 0xD)
+    {
+        return 7;
+    }
+    __cpuidex(cpuInfo, 0xD, 0);
+    return ((unsigned long long)(unsigned int)cpuInfo[3] << 32) | (unsigned int)cpuInfo[0];
+}
+
+// Must be called after CR4.OSXSAVE and XCR0 have been set up (see enableAVX()), features whose registers are not enabled in XCR0 are not reported
+static void detectCpuFeatures()
+{
+    cpuFeatures.avx2 = false;
+    cpuFeatures.avx512 = false;
+    cpuFeatures.avx512Vpopcntdq = false;
+    cpuFeatures.avx512Ifma = false;
+
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 0);
+    const int maxLeaf = cpuInfo[0];
+    __cpuid(cpuInfo, 1);
+    if (maxLeaf < 7 || !(cpuInfo[2] & (1 << 27))) // OSXSAVE
+    {
+        return;
+    }
+    const unsigned long long xcr0 = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
+
+    __cpuidex(cpuInfo, 7, 0);
+    const unsigned int ebx = cpuInfo[1], ecx = cpuInfo[2];
+    cpuFeatures.avx2 = (xcr0 & 6) == 6 && (ebx & (1 << 5));
+    const unsigned int avx512Bits = (1 << 16) | (1 << 17) | (1 << 30) | (1U << 31); // F, DQ, BW, VL
+    cpuFeatures.avx512 = cpuFeatures.avx2 && (xcr0 & 0xE0) == 0xE0 && (ebx & avx512Bits) == avx512Bits;
+    cpuFeatures.avx512Vpopcntdq = cpuFeatures.avx512 && (ecx & (1 << 14));
+    cpuFeatures.avx512Ifma = cpuFeatures.avx512 && (ebx & (1 << 21));
+}
@@ -102,14 +102,9 @@ union m256i
         _mm256_storeu_si256((__m256i*)this, _mm256_lddqu_si256((const __m256i*) & value));
     }
 
-    __m256i& m256i_intr()
+    __m256i m256i_intr() const
     {
-        return *(__m256i*) this;
-    }
-
-    const __m256i& m256i_intr() const
-    {
-        return *(const __m256i*) this;
+        return _mm256_loadu_si256((const __m256i*)this);
     }
 
     void setRandomValue()
@@ -129,19 +124,20 @@ static inline const __m256i& __m256i_convert(const __m256i& a)
     return a;
 }
 
-static inline const __m256i& __m256i_convert(const m256i& a)
+// m256i and byte arrays are not aligned to 32 bytes
+static inline __m256i __m256i_convert(const m256i& a)
 {
-    return *((__m256i*) & a);
+    return _mm256_loadu_si256((const __m256i*)&a);
 }
 
-static inline const __m256i& __m256i_convert(volatile const m256i& a)
+static inline __m256i __m256i_convert(volatile const m256i& a)
 {
-    return *((__m256i*) & a);
+    return _mm256_loadu_si256((const __m256i*)&a);
 }
 
-static inline const __m256i& __m256i_convert(const unsigned char a[32])
+static inline __m256i __m256i_convert(const unsigned char a[32])
 {
-    return *((__m256i*)a);
+    return _mm256_loadu_si256((const __m256i*)a);
 }
 
 /*
@@ -171,6 +167,6 @@ static inline bool isZero(const __m256i& a)
 template <typename T>
 static inline bool isZero(const T& a)
 {
-    const __m256i& ac = __m256i_convert(a);
+    const __m256i ac = __m256i_convert(a);
     return _mm256_testz_si256(ac, ac) == 1;
 }
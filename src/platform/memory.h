@@ -2,8 +2,20 @@
 
 #ifdef NO_UEFI
 
+#include <cstdlib>
 #include <cstring>
 
+static inline bool allocatePool(unsigned long long size, void** buffer)
+{
+    *buffer = malloc(size);
+    return *buffer != nullptr;
+}
+
+static inline void freePool(void* buffer)
+{
+    free(buffer);
+}
+
 static inline void setMem(void* buffer, unsigned long long size, unsigned char value)
 {
     memset(buffer, value, size);
@@ -18,6 +30,18 @@ static inline void copyMem(void* destination, const void* source, unsigned long
 
 #include "uefi.h"
 
+// Only call from the BSP, boot services are not MP-safe
+static inline bool allocatePool(unsigned long long size, void** buffer)
+{
+    return bs->AllocatePool(EfiRuntimeServicesData, size, buffer) == EFI_SUCCESS;
+}
+
+// Only call from the BSP, boot services are not MP-safe
+static inline void freePool(void* buffer)
+{
+    bs->FreePool(buffer);
+}
+
 static inline void setMem(void* buffer, unsigned long long size, unsigned char value)
 {
     bs->SetMem(buffer, size, value);
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+#include "platform/uefi.h"
+#include "platform/console_logging.h"
+
+#include "network/common_def.h"
+#include "four_q.h"
+
+#define TRANSACTION_SENDER_KEY_CACHE_SETS 256 // Must be 2^N
+#define TRANSACTION_SENDER_KEY_CACHE_WAYS 4
+#define TRANSACTION_SENDER_KEY_CANDIDATES 8 // Per set, senders seen once whose keys are decoded and cached when they are seen again
+
+// Decoded public keys for verifyWithCachedKey(). Locks are only held to look up, copy or store an entry, keys are decoded and
+// signatures verified on a copy. Empty entries hold a key with bit 128 set, which verify() rejects anyway.
+
+// Entry i belongs to the computor with index i of the current computor list, so it is rebuilt once per epoch
+static VerificationKey* computorVerificationKeys = NULL;
+static volatile char computorVerificationKeyLocks[NUMBER_OF_COMPUTORS];
+
+// Set-associative LRU of transaction senders
+static VerificationKey* senderVerificationKeys = NULL;
+static unsigned long long senderVerificationKeyLastUseTicks[TRANSACTION_SENDER_KEY_CACHE_SETS * TRANSACTION_SENDER_KEY_CACHE_WAYS];
+static volatile char senderVerificationKeyLocks[TRANSACTION_SENDER_KEY_CACHE_SETS];
+static m256i senderVerificationKeyCandidates[TRANSACTION_SENDER_KEY_CACHE_SETS * TRANSACTION_SENDER_KEY_CANDIDATES];
+static unsigned char nextSenderVerificationKeyCandidates[TRANSACTION_SENDER_KEY_CACHE_SETS];
+static m256i senderVerificationKeySetSalt; // Random, so that keys cannot be ground to crowd one set
+
+static void clearVerificationKey(VerificationKey& key)
+{
+    key.publicKey = m256i(0, 0x8000000000000000ULL, 0, 0);
+    key.valid = false;
+}
+
+static bool initPublicKeyCache()
+{
+    EFI_STATUS status;
+    if ((status = bs->AllocatePool(EfiRuntimeServicesData, NUMBER_OF_COMPUTORS * sizeof(VerificationKey), (void**)&computorVerificationKeys))
+        || (status = bs->AllocatePool(EfiRuntimeServicesData, TRANSACTION_SENDER_KEY_CACHE_SETS * TRANSACTION_SENDER_KEY_CACHE_WAYS * sizeof(VerificationKey), (void**)&senderVerificationKeys)))
+    {
+        logStatusToConsole(L"EFI_BOOT_SERVICES.AllocatePool() fails", status, __LINE__);
+
+        return false;
+    }
+    for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+    {
+        clearVerificationKey(computorVerificationKeys[i]);
+        computorVerificationKeyLocks[i] = 0;
+    }
+    for (unsigned int i = 0; i < TRANSACTION_SENDER_KEY_CACHE_SETS * TRANSACTION_SENDER_KEY_CACHE_WAYS; i++)
+    {
+        clearVerificationKey(senderVerificationKeys[i]);
+        senderVerificationKeyLastUseTicks[i] = 0;
+    }
+    for (unsigned int i = 0; i < TRANSACTION_SENDER_KEY_CACHE_SETS; i++)
+    {
+        senderVerificationKeyLocks[i] = 0;
+        nextSenderVerificationKeyCandidates[i] = 0;
+    }
+    for (unsigned int i = 0; i < TRANSACTION_SENDER_KEY_CACHE_SETS * TRANSACTION_SENDER_KEY_CANDIDATES; i++)
+    {
+        senderVerificationKeyCandidates[i] = m256i(0, 0x8000000000000000ULL, 0, 0);
+    }
+    senderVerificationKeySetSalt.setRandomValue();
+
+    return true;
+}
+
+static void deinitPublicKeyCache()
+{
+    if (senderVerificationKeys)
+    {
+        bs->FreePool(senderVerificationKeys);
+    }
+    if (computorVerificationKeys)
+    {
+        bs->FreePool(computorVerificationKeys);
+    }
+}
+
+// Same as verify(computorPublicKey, digest, signature) for the computor with index computorIndex
+static bool verifyComputorSignature(unsigned int computorIndex, const m256i& computorPublicKey, const unsigned char* digest, const unsigned char* signature)
+{
+    VerificationKey key;
+    ACQUIRE(computorVerificationKeyLocks[computorIndex]);
+    const bool isCached = computorVerificationKeys[computorIndex].publicKey == computorPublicKey;
+    if (isCached)
+    {
+        copyMem(&key, &computorVerificationKeys[computorIndex], sizeof(key));
+    }
+    RELEASE(computorVerificationKeyLocks[computorIndex]);
+
+    if (!isCached)
+    {
+        prepareVerificationKey(computorPublicKey.m256i_u8, key);
+
+        ACQUIRE(computorVerificationKeyLocks[computorIndex]);
+        copyMem(&computorVerificationKeys[computorIndex], &key, sizeof(key));
+        RELEASE(computorVerificationKeyLocks[computorIndex]);
+    }
+
+    return verifyWithCachedKey(key, digest, signature);
+}
+
+static unsigned int senderVerificationKeySetIndex(const m256i& sourcePublicKey)
+{
+    unsigned long long hash = 0;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        hash = (hash ^ sourcePublicKey.m256i_u64[i] ^ senderVerificationKeySetSalt.m256i_u64[i]) * 0x9E3779B97F4A7C15ULL;
+    }
+
+    return (unsigned int)(hash >> 32) & (TRANSACTION_SENDER_KEY_CACHE_SETS - 1);
+}
+
+// Same as verify(sourcePublicKey, digest, signature), keeping the decoded key of senders seen more than once
+static bool verifySenderSignature(const m256i& sourcePublicKey, const unsigned char* digest, const unsigned char* signature)
+{
+    const unsigned int setIndex = senderVerificationKeySetIndex(sourcePublicKey);
+    const unsigned int firstEntryIndex = setIndex * TRANSACTION_SENDER_KEY_CACHE_WAYS;
+    const unsigned int firstCandidateIndex = setIndex * TRANSACTION_SENDER_KEY_CANDIDATES;
+
+    VerificationKey key;
+    bool isCandidate = false;
+    ACQUIRE(senderVerificationKeyLocks[setIndex]);
+    for (unsigned int i = firstEntryIndex; i < firstEntryIndex + TRANSACTION_SENDER_KEY_CACHE_WAYS; i++)
+    {
+        if (senderVerificationKeys[i].publicKey == sourcePublicKey)
+        {
+            senderVerificationKeyLastUseTicks[i] = __rdtsc();
+            copyMem(&key, &senderVerificationKeys[i], sizeof(key));
+            RELEASE(senderVerificationKeyLocks[setIndex]);
+
+            return verifyWithCachedKey(key, digest, signature);
+        }
+    }
+    for (unsigned int i = firstCandidateIndex; i < firstCandidateIndex + TRANSACTION_SENDER_KEY_CANDIDATES; i++)
+    {
+        if (senderVerificationKeyCandidates[i] == sourcePublicKey)
+        {
+            senderVerificationKeyCandidates[i] = m256i(0, 0x8000000000000000ULL, 0, 0);
+            isCandidate = true;
+
+            break;
+        }
+    }
+    if (!isCandidate)
+    {
+        senderVerificationKeyCandidates[firstCandidateIndex + nextSenderVerificationKeyCandidates[setIndex]] = sourcePublicKey;
+        nextSenderVerificationKeyCandidates[setIndex] = (nextSenderVerificationKeyCandidates[setIndex] + 1) % TRANSACTION_SENDER_KEY_CANDIDATES;
+    }
+    RELEASE(senderVerificationKeyLocks[setIndex]);
+
+    // A sender seen for the first time is verified without building the tables of its key, one-off keys would only evict others
+    if (!isCandidate)
+    {
+        return verify(sourcePublicKey.m256i_u8, digest, signature);
+    }
+
+    prepareVerificationKey(sourcePublicKey.m256i_u8, key);
+
+    ACQUIRE(senderVerificationKeyLocks[setIndex]);
+    unsigned int entryIndex = firstEntryIndex;
+    for (unsigned int i = firstEntryIndex; i < firstEntryIndex + TRANSACTION_SENDER_KEY_CACHE_WAYS; i++)
+    {
+        if (senderVerificationKeys[i].publicKey == sourcePublicKey)
+        {
+            entryIndex = i;
+
+            break;
+        }
+        if (senderVerificationKeyLastUseTicks[i] < senderVerificationKeyLastUseTicks[entryIndex])
+        {
+            entryIndex = i;
+        }
+    }
+    copyMem(&senderVerificationKeys[entryIndex], &key, sizeof(key));
+    senderVerificationKeyLastUseTicks[entryIndex] = __rdtsc();
+    RELEASE(senderVerificationKeyLocks[setIndex]);
+
+    return verifyWithCachedKey(key, digest, signature);
+}
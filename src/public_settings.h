@@ -28,11 +28,14 @@
 
 #define IGNORE_RESOURCE_TESTING 0
 
+#if !defined(NO_UEFI)
+// Only the node keeps files, L"" strings cannot initialize unsigned short arrays in the host builds (GCC/Clang)
 static unsigned short SYSTEM_FILE_NAME[] = L"system";
 static unsigned short SPECTRUM_FILE_NAME[] = L"spectrum.???";
 static unsigned short UNIVERSE_FILE_NAME[] = L"universe.???";
 static unsigned short SCORE_CACHE_FILE_NAME[] = L"score.???";
 static unsigned short CONTRACT_FILE_NAME[] = L"contract????.???";
+#endif
 
 #define DATA_LENGTH 1200
 #define INFO_LENGTH 1200
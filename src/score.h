@@ -3,13 +3,72 @@
 #include "platform/memory.h"
 #include "platform/m256.h"
 #include "platform/concurrency.h"
+#include "platform/cpu_features.h"
 #include "smart_contracts/math_lib.h"
 #include "public_settings.h"
 
+#include "network/common_def.h"
+#include "kangaroo_twelve.h"
+
 #include "score_cache.h"
 
 ////////// Scoring algorithm \\\\\\\\\\
 
+// Maximum number of solutions interleaved by scoreBatch() on one processor
+#define MAX_SCORE_BATCH_SIZE 4
+
+// States of solutionBufferRequested, a processor waiting for the BSP to allocate a buffer stops waiting once it is not requested anymore
+#define SOLUTION_BUFFER_REQUESTED 1
+#define SOLUTION_BUFFER_REQUEST_FAILED 2
+
+// Sum of popcount(positive[i] ^ neurons[i]) - popcount(negative[i] ^ neurons[i]) over numberOfWords 64-bit words of a synapse row
+static int sumNeuronInput_Generic(const unsigned long long* positive, const unsigned long long* negative, const unsigned long long* neurons, unsigned int numberOfWords)
+{
+    unsigned long long positiveSum = 0, negativeSum = 0;
+    unsigned int i = 0;
+    for (; i + 4 <= numberOfWords; i += 4)
+    {
+        positiveSum += __popcnt64(positive[i] ^ neurons[i]) + __popcnt64(positive[i + 1] ^ neurons[i + 1])
+            + __popcnt64(positive[i + 2] ^ neurons[i + 2]) + __popcnt64(positive[i + 3] ^ neurons[i + 3]);
+        negativeSum += __popcnt64(negative[i] ^ neurons[i]) + __popcnt64(negative[i + 1] ^ neurons[i + 1])
+            + __popcnt64(negative[i + 2] ^ neurons[i + 2]) + __popcnt64(negative[i + 3] ^ neurons[i + 3]);
+    }
+    for (; i < numberOfWords; i++)
+    {
+        positiveSum += __popcnt64(positive[i] ^ neurons[i]);
+        negativeSum += __popcnt64(negative[i] ^ neurons[i]);
+    }
+    return (int)positiveSum - (int)negativeSum;
+}
+
+TARGET_AVX512_VPOPCNTDQ static int sumNeuronInput_AVX512(const unsigned long long* positive, const unsigned long long* negative, const unsigned long long* neurons, unsigned int numberOfWords)
+{
+    __m512i sum = _mm512_setzero_si512();
+    unsigned int i = 0;
+    for (; i + 8 <= numberOfWords; i += 8)
+    {
+        const __m512i b = _mm512_loadu_si512(neurons + i);
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_loadu_si512(positive + i), b)));
+        sum = _mm512_sub_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_loadu_si512(negative + i), b)));
+    }
+    if (i < numberOfWords)
+    {
+        const __mmask8 mask = (__mmask8)((1 << (numberOfWords - i)) - 1);
+        const __m512i b = _mm512_maskz_loadu_epi64(mask, neurons + i);
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, positive + i), b)));
+        sum = _mm512_sub_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, negative + i), b)));
+    }
+    return (int)_mm512_reduce_add_epi64(sum);
+}
+
+static int (*sumNeuronInput)(const unsigned long long* positive, const unsigned long long* negative, const unsigned long long* neurons, unsigned int numberOfWords) = sumNeuronInput_Generic;
+
+// Binds the score kernels to the fastest variants the CPU supports, cpuFeatures must be set before
+static void selectScoreKernels()
+{
+    sumNeuronInput = cpuFeatures.avx512Vpopcntdq ? sumNeuronInput_AVX512 : sumNeuronInput_Generic;
+}
+
 template<
     unsigned int dataLength,
     unsigned int infoLength,
@@ -44,28 +103,82 @@ struct ScoreFunction
         0xFFFFFFFFFFFFFFFFULL : (0xFFFFFFFFFFFFFFFFULL >> (64 - LAST_ELEMENT_BIT_OUTPUT));
 #pragma warning(pop)
 
-    struct
+    // Bytes of the synapse stream read when converting one neuron row to bit planes
+    static constexpr unsigned int SYNAPSE_ROW_READ_SIZE_INPUT = SYNAPSE_CHUNK_SIZE_INPUT_BIT * 8;
+    static constexpr unsigned int SYNAPSE_ROW_READ_SIZE_OUTPUT = SYNAPSE_CHUNK_SIZE_OUTPUT_BIT * 8;
+    static constexpr unsigned int RANDOM_WINDOW_SIZE = (SYNAPSE_ROW_READ_SIZE_INPUT > SYNAPSE_ROW_READ_SIZE_OUTPUT ? SYNAPSE_ROW_READ_SIZE_INPUT : SYNAPSE_ROW_READ_SIZE_OUTPUT) + RANDOM_STREAM_BLOCK_SIZE;
+
+    static constexpr unsigned int NEURON_VALUE_BIT_SIZE = math_lib::max(PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT, PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT);
+
+    struct Neurons
     {
         int input[dataLength + numberOfInputNeurons + infoLength];
         int output[infoLength + numberOfOutputNeurons + dataLength];
-    } neurons[solutionBufferCount];
-    struct
-    {
-        char input[(numberOfInputNeurons + infoLength) * (dataLength + numberOfInputNeurons + infoLength)];
-        char output[(numberOfOutputNeurons + dataLength) * (infoLength + numberOfOutputNeurons + dataLength)];
-        unsigned short lengths[maxInputDuration * (numberOfInputNeurons + infoLength) + maxOutputDuration * (numberOfOutputNeurons + dataLength)];
-    } synapses[solutionBufferCount];
+    };
 
-    struct
+    // Per-processor working memory. The ternary synapses and the neuron visiting order (lengths) are not stored,
+    // they are consumed from the random stream while being generated and only the bit planes are kept.
+    struct SolutionBuffer
     {
-        char input_positive[(numberOfInputNeurons + infoLength) * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT];
-        char input_negative[(numberOfInputNeurons + infoLength) * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT];
-        char output_positive[(numberOfOutputNeurons + dataLength) * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT];
-        char output_negative[(numberOfOutputNeurons + dataLength) * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT];
-    } synapses1Bit[solutionBufferCount];
+        Neurons neurons;
+
+        struct
+        {
+            char input_positive[(numberOfInputNeurons + infoLength) * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT];
+            char input_negative[(numberOfInputNeurons + infoLength) * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT];
+            char output_positive[(numberOfOutputNeurons + dataLength) * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT];
+            char output_negative[(numberOfOutputNeurons + dataLength) * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT];
+        } synapses1Bit;
+
+        unsigned char nrVal1Bit[NEURON_VALUE_BIT_SIZE];
+        unsigned short neuronIndices[math_lib::max(numberOfInputNeurons + infoLength, numberOfOutputNeurons + dataLength)];
+        unsigned short numberOfRemainingNeurons;
+        unsigned short nextNeuronIndex;
+
+        RandomStream randomStream;
+        unsigned int randomWindowBegin, randomWindowEnd;
+        unsigned char randomWindow[RANDOM_WINDOW_SIZE];
+
+        // Make at least size bytes of the random stream available at randomWindow + randomWindowBegin
+        inline const unsigned char* fetchRandom(unsigned int size)
+        {
+            if (randomWindowEnd - randomWindowBegin < size)
+            {
+                unsigned int remaining = randomWindowEnd - randomWindowBegin;
+                for (unsigned int i = 0; i < remaining; i++)
+                {
+                    randomWindow[i] = randomWindow[randomWindowBegin + i];
+                }
+                randomWindowBegin = 0;
+                randomWindowEnd = remaining;
+                while (randomWindowEnd < size)
+                {
+                    randomStream.next(&randomWindow[randomWindowEnd]);
+                    randomWindowEnd += RANDOM_STREAM_BLOCK_SIZE;
+                }
+            }
+            return &randomWindow[randomWindowBegin];
+        }
 
+        inline unsigned short nextLength()
+        {
+            const unsigned short length = *((const unsigned short*)fetchRandom(sizeof(unsigned short)));
+            randomWindowBegin += sizeof(unsigned short);
+            return length;
+        }
+    };
+
+    // Buffers are allocated when a processor starts scoring and released after being idle for a while (see manageSolutionBuffers()).
+    // Processor solutionBufIdx owns the buffers solutionBufIdx * MAX_SCORE_BATCH_SIZE + lane, lanes > 0 are only used by scoreBatch().
+    SolutionBuffer* volatile solutionBuffers[solutionBufferCount * MAX_SCORE_BATCH_SIZE];
+    volatile char solutionBufferRequested[solutionBufferCount * MAX_SCORE_BATCH_SIZE];
+    volatile unsigned long long solutionBufferLastUseTick[solutionBufferCount * MAX_SCORE_BATCH_SIZE];
     volatile char solutionEngineLock[solutionBufferCount];
 
+    // Neurons and their sign bits at the start of every solution, only depending on miningData
+    Neurons initialNeurons;
+    unsigned char initialNrVal1Bit[NEURON_VALUE_BIT_SIZE];
+
 #if USE_SCORE_CACHE
     ScoreCache<SCORE_CACHE_SIZE, SCORE_CACHE_COLLISION_RETRIES> scoreCache;
 #endif
@@ -74,12 +187,114 @@ struct ScoreFunction
     {
         initialRandomSeed = randomSeed; // persist the initial random seed to be able to sned it back on system info response
         random((unsigned char*)&randomSeed, (unsigned char*)&randomSeed, (unsigned char*)miningData, sizeof(miningData));
+
+        setMem(&initialNeurons, sizeof(initialNeurons), 0);
+        copyMem(&initialNeurons.input[0], miningData, sizeof(miningData));
+        setMem(initialNrVal1Bit, sizeof(initialNrVal1Bit), 0);
+        for (unsigned int i = 0; i < dataLength; i++)
+        {
+            if (miningData[i] < 0)
+            {
+                setBitNeuron(initialNrVal1Bit, i);
+            }
+        }
+    }
+
+    void initMemory()
+    {
+        for (unsigned int i = 0; i < solutionBufferCount * MAX_SCORE_BATCH_SIZE; i++)
+        {
+            solutionBuffers[i] = NULL;
+            solutionBufferRequested[i] = 0;
+            solutionBufferLastUseTick[i] = 0;
+        }
+        for (unsigned int i = 0; i < solutionBufferCount; i++)
+        {
+            solutionEngineLock[i] = 0;
+        }
+    }
+
+    void freeMemory()
+    {
+        for (unsigned int i = 0; i < solutionBufferCount * MAX_SCORE_BATCH_SIZE; i++)
+        {
+            if (solutionBuffers[i])
+            {
+                freePool(solutionBuffers[i]);
+                solutionBuffers[i] = NULL;
+            }
+        }
+    }
+
+    // Allocate requested and release idle solution buffers, must be called regularly from the BSP
+    void manageSolutionBuffers(const unsigned long long curTimeTick, const unsigned long long idleTicks)
+    {
+        for (unsigned int i = 0; i < solutionBufferCount * MAX_SCORE_BATCH_SIZE; i++)
+        {
+            volatile char& lock = solutionEngineLock[i / MAX_SCORE_BATCH_SIZE];
+            if (solutionBufferRequested[i] == SOLUTION_BUFFER_REQUESTED)
+            {
+                if (!solutionBuffers[i])
+                {
+                    void* buffer;
+                    if (!allocatePool(sizeof(SolutionBuffer), &buffer))
+                    {
+                        // The waiting processor scores without this buffer, a later request tries again
+                        solutionBufferRequested[i] = SOLUTION_BUFFER_REQUEST_FAILED;
+                        continue;
+                    }
+                    solutionBufferLastUseTick[i] = curTimeTick;
+                    solutionBuffers[i] = (SolutionBuffer*)buffer;
+                }
+                solutionBufferRequested[i] = 0;
+            }
+            else if (solutionBuffers[i] && curTimeTick - solutionBufferLastUseTick[i] > idleTicks
+                && !_InterlockedCompareExchange8(&lock, 1, 0))
+            {
+                if (!solutionBufferRequested[i] && curTimeTick - solutionBufferLastUseTick[i] > idleTicks)
+                {
+                    freePool(solutionBuffers[i]);
+                    solutionBuffers[i] = NULL;
+                }
+                RELEASE(lock);
+            }
+        }
+    }
+
+    // Get buffer bufferIndex = solutionBufIdx * MAX_SCORE_BATCH_SIZE + lane (solutionEngineLock[solutionBufIdx] must be held),
+    // NULL if it cannot be allocated
+    SolutionBuffer* getSolutionBuffer(const unsigned long long bufferIndex)
+    {
+        if (!solutionBuffers[bufferIndex])
+        {
+#ifdef NO_UEFI
+            void* buffer;
+            if (!allocatePool(sizeof(SolutionBuffer), &buffer))
+            {
+                return NULL;
+            }
+            solutionBuffers[bufferIndex] = (SolutionBuffer*)buffer;
+#else
+            // APs cannot use boot services, so let the BSP allocate the buffer
+            solutionBufferRequested[bufferIndex] = SOLUTION_BUFFER_REQUESTED;
+            while (solutionBufferRequested[bufferIndex] == SOLUTION_BUFFER_REQUESTED)
+            {
+                _mm_pause();
+            }
+            if (!solutionBuffers[bufferIndex])
+            {
+                solutionBufferRequested[bufferIndex] = 0;
+                return NULL;
+            }
+#endif
+        }
+        return solutionBuffers[bufferIndex];
     }
 
     // Save score cache to SCORE_CACHE_FILE_NAME
     void saveScoreCache()
     {
-#if USE_SCORE_CACHE
+#if USE_SCORE_CACHE && !defined(NO_UEFI)
         scoreCache.save(SCORE_CACHE_FILE_NAME);
 #endif
     }
@@ -88,7 +303,7 @@ struct ScoreFunction
     bool loadScoreCache(int epoch)
     {
         bool success = true;
-#if USE_SCORE_CACHE
+#if USE_SCORE_CACHE && !defined(NO_UEFI)
         SCORE_CACHE_FILE_NAME[sizeof(SCORE_CACHE_FILE_NAME) / sizeof(SCORE_CACHE_FILE_NAME[0]) - 4] = epoch / 100 + L'0';
         SCORE_CACHE_FILE_NAME[sizeof(SCORE_CACHE_FILE_NAME) / sizeof(SCORE_CACHE_FILE_NAME[0]) - 3] = (epoch % 100) / 10 + L'0';
         SCORE_CACHE_FILE_NAME[sizeof(SCORE_CACHE_FILE_NAME) / sizeof(SCORE_CACHE_FILE_NAME[0]) - 2] = epoch % 10 + L'0';
@@ -118,191 +333,332 @@ struct ScoreFunction
         }
     }
 
-    // main score function
-    unsigned int operator()(const unsigned long long processor_Number, const m256i& publicKey, const m256i& nonce)
+    // Convert the synapses generated by random(publicKey, nonce) to bit planes and reset the neurons
+    void prepareSolution(SolutionBuffer* const buffer, const m256i& publicKey, const m256i& nonce)
     {
-        int score = 0;
-#if USE_SCORE_CACHE
-        unsigned int scoreCacheIndex = scoreCache.getCacheIndex(publicKey, nonce);
-        score = scoreCache.tryFetching(publicKey, nonce, scoreCacheIndex);
-        if (score >= scoreCache.MIN_VALID_SCORE)
-        {
-            return score;
-        }
-        score = 0;
-#endif
-
-        const unsigned long long solutionBufIdx = processor_Number % solutionBufferCount;
-        ACQUIRE(solutionEngineLock[solutionBufIdx]);
-
-        unsigned char nrVal1Bit[math_lib::max(PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT, PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT)];
-        random(publicKey.m256i_u8, nonce.m256i_u8, (unsigned char*)&synapses[solutionBufIdx], sizeof(synapses[0]));
+        // Stream the synapses row by row into the bit planes
+        buffer->randomStream.init(publicKey.m256i_u8, nonce.m256i_u8);
+        buffer->randomWindowBegin = 0;
+        buffer->randomWindowEnd = 0;
         for (unsigned int inputNeuronIndex = 0; inputNeuronIndex < numberOfInputNeurons + infoLength; inputNeuronIndex++)
         {
-            unsigned long long* p = (unsigned long long*)(synapses[solutionBufIdx].input + inputNeuronIndex * (dataLength + numberOfInputNeurons + infoLength));
+            const unsigned long long* p = (const unsigned long long*)buffer->fetchRandom(SYNAPSE_ROW_READ_SIZE_INPUT);
             for (unsigned int anotherInputNeuronIndex = 0; anotherInputNeuronIndex < (dataLength + numberOfInputNeurons + infoLength + 7) / 8; anotherInputNeuronIndex++)
             {
                 const unsigned int offset = inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT + anotherInputNeuronIndex;
-                neuronU64To1Bit(p[anotherInputNeuronIndex], (unsigned char*)synapses1Bit[solutionBufIdx].input_positive + offset,
-                    (unsigned char*)synapses1Bit[solutionBufIdx].input_negative + offset);
+                neuronU64To1Bit(p[anotherInputNeuronIndex], (unsigned char*)buffer->synapses1Bit.input_positive + offset,
+                    (unsigned char*)buffer->synapses1Bit.input_negative + offset);
             }
+            buffer->randomWindowBegin += dataLength + numberOfInputNeurons + infoLength;
         }
 
         for (unsigned int outputNeuronIndex = 0; outputNeuronIndex < numberOfOutputNeurons + dataLength; outputNeuronIndex++)
         {
-            unsigned long long* p = (unsigned long long*)(synapses[solutionBufIdx].output + outputNeuronIndex * (dataLength + numberOfOutputNeurons + infoLength));
+            const unsigned long long* p = (const unsigned long long*)buffer->fetchRandom(SYNAPSE_ROW_READ_SIZE_OUTPUT);
             for (unsigned int anotherOutputNeuronIndex = 0; anotherOutputNeuronIndex < (infoLength + numberOfOutputNeurons + dataLength + 7) / 8; anotherOutputNeuronIndex++)
             {
                 const unsigned int offset = outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT + anotherOutputNeuronIndex;
-                neuronU64To1Bit(p[anotherOutputNeuronIndex], (unsigned char*)synapses1Bit[solutionBufIdx].output_positive + offset,
-                    (unsigned char*)synapses1Bit[solutionBufIdx].output_negative + offset);
+                neuronU64To1Bit(p[anotherOutputNeuronIndex], (unsigned char*)buffer->synapses1Bit.output_positive + offset,
+                    (unsigned char*)buffer->synapses1Bit.output_negative + offset);
             }
+            buffer->randomWindowBegin += dataLength + numberOfOutputNeurons + infoLength;
+        }
+
+        // The lengths (neuron visiting order) follow the synapses, aligned like in the former synapse struct
+        if ((SYNAPSE_CHUNK_SIZE_INPUT * (numberOfInputNeurons + infoLength) + SYNAPSE_CHUNK_SIZE_OUTPUT * (numberOfOutputNeurons + dataLength)) & 1)
+        {
+            buffer->fetchRandom(1);
+            buffer->randomWindowBegin++;
         }
 
         for (unsigned int inputNeuronIndex = 0; inputNeuronIndex < numberOfInputNeurons + infoLength; inputNeuronIndex++)
         {
-            unsigned char* ptr_positive = (unsigned char*)synapses1Bit[solutionBufIdx].input_positive + inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT;
-            unsigned char* ptr_negative = (unsigned char*)synapses1Bit[solutionBufIdx].input_negative + inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT;
+            unsigned char* ptr_positive = (unsigned char*)buffer->synapses1Bit.input_positive + inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT;
+            unsigned char* ptr_negative = (unsigned char*)buffer->synapses1Bit.input_negative + inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT;
             clearBitNeuron(ptr_positive, (dataLength + inputNeuronIndex));
             clearBitNeuron(ptr_negative, (dataLength + inputNeuronIndex));
         }
         for (unsigned int outputNeuronIndex = 0; outputNeuronIndex < numberOfOutputNeurons + dataLength; outputNeuronIndex++)
         {
-            unsigned char* ptr_positive = (unsigned char*)synapses1Bit[solutionBufIdx].output_positive + outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT;
-            unsigned char* ptr_negative = (unsigned char*)synapses1Bit[solutionBufIdx].output_negative + outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT;
+            unsigned char* ptr_positive = (unsigned char*)buffer->synapses1Bit.output_positive + outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT;
+            unsigned char* ptr_negative = (unsigned char*)buffer->synapses1Bit.output_negative + outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT;
             clearBitNeuron(ptr_positive, (infoLength + outputNeuronIndex));
             clearBitNeuron(ptr_negative, (infoLength + outputNeuronIndex));
         }
 
-        unsigned int lengthIndex = 0;
+        copyMem(&buffer->neurons, &initialNeurons, sizeof(initialNeurons));
+        copyMem(buffer->nrVal1Bit, initialNrVal1Bit, sizeof(initialNrVal1Bit));
+    }
+
+    static void resetNeuronOrder(SolutionBuffer* const buffer, const unsigned short numberOfNeurons)
+    {
+        for (buffer->numberOfRemainingNeurons = 0; buffer->numberOfRemainingNeurons < numberOfNeurons; buffer->numberOfRemainingNeurons++)
+        {
+            buffer->neuronIndices[buffer->numberOfRemainingNeurons] = buffer->numberOfRemainingNeurons;
+        }
+    }
+
+    // Take the next neuron to update in this tick (numberOfRemainingNeurons must not be 0)
+    static unsigned short pickNeuron(SolutionBuffer* const buffer)
+    {
+        const unsigned short neuronIndexIndex = buffer->nextLength() % buffer->numberOfRemainingNeurons;
+        const unsigned short neuronIndex = buffer->neuronIndices[neuronIndexIndex];
+        buffer->neuronIndices[neuronIndexIndex] = buffer->neuronIndices[--buffer->numberOfRemainingNeurons];
+        return neuronIndex;
+    }
 
-        copyMem(&neurons[solutionBufIdx].input[0], miningData, dataLength * sizeof(miningData[0]));
-        setMem(&neurons[solutionBufIdx].input[sizeof(miningData) / sizeof(neurons[0].input[0])], sizeof(neurons[0]) - sizeof(miningData), 0);
-        setMem(nrVal1Bit, sizeof(nrVal1Bit), 0);
+    static void prefetchRows(const char* positive, const char* negative, const unsigned int size)
+    {
+        for (unsigned int i = 0; i < size; i += 64)
+        {
+            _mm_prefetch(positive + i, _MM_HINT_T0);
+            _mm_prefetch(negative + i, _MM_HINT_T0);
+        }
+    }
 
-        for (int i = 0; i < dataLength + numberOfInputNeurons + infoLength; i++) {
-            if (neurons[solutionBufIdx].input[i] < 0) {
-                setBitNeuron(nrVal1Bit, i);
+    static void updateInputNeuron(SolutionBuffer* const buffer, const unsigned short inputNeuronIndex)
+    {
+        const unsigned char* nrVal1Bit = buffer->nrVal1Bit;
+        unsigned long long* sy_pos = (unsigned long long*)(buffer->synapses1Bit.input_positive + (inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT));
+        unsigned long long* sy_neg = (unsigned long long*)(buffer->synapses1Bit.input_negative + (inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT));
+        int lv = sumNeuronInput(sy_pos, sy_neg, (const unsigned long long*)nrVal1Bit, NEURON_SCANNED_ROUND_INPUT - 1);
+        {
+            unsigned long long A0 = (*(unsigned long long*)(sy_pos + (NEURON_SCANNED_ROUND_INPUT - 1)));
+            unsigned long long A1 = (*(unsigned long long*)(sy_neg + (NEURON_SCANNED_ROUND_INPUT - 1)));
+            unsigned long long B = (*(unsigned long long*)(nrVal1Bit + (NEURON_SCANNED_ROUND_INPUT - 1) * 8));
+            if (LAST_ELEMENT_BIT_INPUT != 0) {
+                A0 &= LAST_ELEMENT_MASK_INPUT;
+                A1 &= LAST_ELEMENT_MASK_INPUT;
+                B &= LAST_ELEMENT_MASK_INPUT;
+            }
+            int s = (int)__popcnt64(A0 ^ B);
+            s -= (int)__popcnt64(A1 ^ B);
+            lv += s;
+            buffer->neurons.input[dataLength + inputNeuronIndex] += lv;
+            if (buffer->neurons.input[dataLength + inputNeuronIndex] < 0) {
+                setBitNeuron(buffer->nrVal1Bit, dataLength + inputNeuronIndex);
+            }
+            else {
+                clearBitNeuron(buffer->nrVal1Bit, dataLength + inputNeuronIndex);
+            }
+        }
+    }
+
+    static void beginOutputPhase(SolutionBuffer* const buffer)
+    {
+        // The output neurons after the info part are still 0 and have their sign bit cleared
+        copyMem(&buffer->neurons.output[0], &buffer->neurons.input[dataLength + numberOfInputNeurons], infoLength * sizeof(buffer->neurons.input[0]));
+        setMem(buffer->nrVal1Bit, sizeof(buffer->nrVal1Bit), 0);
+        for (unsigned int i = 0; i < infoLength; i++) {
+            if (buffer->neurons.output[i] < 0) {
+                setBitNeuron(buffer->nrVal1Bit, i);
+            }
+        }
+    }
+
+    static void updateOutputNeuron(SolutionBuffer* const buffer, const unsigned short outputNeuronIndex)
+    {
+        const unsigned char* nrVal1Bit = buffer->nrVal1Bit;
+        unsigned long long* sy_pos = (unsigned long long*)(buffer->synapses1Bit.output_positive + (outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT));
+        unsigned long long* sy_neg = (unsigned long long*)(buffer->synapses1Bit.output_negative + (outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT));
+        int lv = sumNeuronInput(sy_pos, sy_neg, (const unsigned long long*)nrVal1Bit, NEURON_SCANNED_ROUND_OUTPUT - 1);
+        {
+            unsigned long long A0 = (*(unsigned long long*)(sy_pos + (NEURON_SCANNED_ROUND_OUTPUT - 1)));
+            unsigned long long A1 = (*(unsigned long long*)(sy_neg + (NEURON_SCANNED_ROUND_OUTPUT - 1)));
+            unsigned long long B = (*(unsigned long long*)(nrVal1Bit + (NEURON_SCANNED_ROUND_OUTPUT - 1) * 8));
+            if (LAST_ELEMENT_BIT_OUTPUT != 0) {
+                A0 &= LAST_ELEMENT_MASK_OUTPUT;
+                A1 &= LAST_ELEMENT_MASK_OUTPUT;
+                B &= LAST_ELEMENT_MASK_OUTPUT;
+            }
+            int s = (int)__popcnt64(A0 ^ B);
+            s -= (int)__popcnt64(A1 ^ B);
+            lv += s;
+            buffer->neurons.output[infoLength + outputNeuronIndex] += lv;
+            if (buffer->neurons.output[infoLength + outputNeuronIndex] < 0) {
+                setBitNeuron(buffer->nrVal1Bit, infoLength + outputNeuronIndex);
             }
             else {
-                clearBitNeuron(nrVal1Bit, i);
+                clearBitNeuron(buffer->nrVal1Bit, infoLength + outputNeuronIndex);
             }
         }
+    }
+
+    unsigned int countMatchingData(const SolutionBuffer* const buffer)
+    {
+        unsigned int score = 0;
+        for (unsigned int i = 0; i < dataLength; i++)
+        {
+            if ((miningData[i] >= 0) == (buffer->neurons.output[infoLength + numberOfOutputNeurons + i] >= 0))
+            {
+                score++;
+            }
+        }
+        return score;
+    }
+
+    // Run numberOfLanes independent solutions in lockstep, one buffer each. The order in which a solution visits its
+    // neurons does not depend on the neuron values, so the next neuron of every lane is picked one step ahead and its
+    // bit plane rows are prefetched while the other lanes are computed.
+    void scoreLanes(SolutionBuffer* const* buffers, const unsigned int numberOfLanes,
+        const m256i* publicKeys, const m256i* nonces, const unsigned int* solutionIndices, unsigned int* scores)
+    {
+        for (unsigned int lane = 0; lane < numberOfLanes; lane++)
+        {
+            prepareSolution(buffers[lane], publicKeys[solutionIndices[lane]], nonces[solutionIndices[lane]]);
+        }
 
         for (unsigned int tick = 0; tick < maxInputDuration; tick++)
         {
-            unsigned short neuronIndices[numberOfInputNeurons + infoLength];
-            unsigned short numberOfRemainingNeurons = 0;
-            for (numberOfRemainingNeurons = 0; numberOfRemainingNeurons < numberOfInputNeurons + infoLength; numberOfRemainingNeurons++)
+            for (unsigned int lane = 0; lane < numberOfLanes; lane++)
             {
-                neuronIndices[numberOfRemainingNeurons] = numberOfRemainingNeurons;
+                resetNeuronOrder(buffers[lane], numberOfInputNeurons + infoLength);
+                buffers[lane]->nextNeuronIndex = pickNeuron(buffers[lane]);
             }
-            while (numberOfRemainingNeurons)
+            for (unsigned int step = 0; step < numberOfInputNeurons + infoLength; step++)
             {
-                const unsigned short neuronIndexIndex = synapses[solutionBufIdx].lengths[lengthIndex++] % numberOfRemainingNeurons;
-                const unsigned short inputNeuronIndex = neuronIndices[neuronIndexIndex];
-                neuronIndices[neuronIndexIndex] = neuronIndices[--numberOfRemainingNeurons];
-                unsigned long long* sy_pos = (unsigned long long*)(synapses1Bit[solutionBufIdx].input_positive + (inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT));
-                unsigned long long* sy_neg = (unsigned long long*)(synapses1Bit[solutionBufIdx].input_negative + (inputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT));
-                int lv = 0;
-                for (int i = 0; i < (NEURON_SCANNED_ROUND_INPUT - 1); i++) {
-                    unsigned long long A0 = sy_pos[i];
-                    unsigned long long A1 = sy_neg[i];
-                    unsigned long long B = ((unsigned long long*)nrVal1Bit)[i];
-                    int s = (int)__popcnt64(A0 ^ B);
-                    s -= (int)__popcnt64(A1 ^ B);
-                    lv += s;
-                }
+                for (unsigned int lane = 0; lane < numberOfLanes; lane++)
                 {
-                    unsigned long long A0 = (*(unsigned long long*)(sy_pos + (NEURON_SCANNED_ROUND_INPUT - 1)));
-                    unsigned long long A1 = (*(unsigned long long*)(sy_neg + (NEURON_SCANNED_ROUND_INPUT - 1)));
-                    unsigned long long B = (*(unsigned long long*)(nrVal1Bit + (NEURON_SCANNED_ROUND_INPUT - 1) * 8));
-                    if (LAST_ELEMENT_BIT_INPUT != 0) {
-                        A0 &= LAST_ELEMENT_MASK_INPUT;
-                        A1 &= LAST_ELEMENT_MASK_INPUT;
-                        B &= LAST_ELEMENT_MASK_INPUT;
-                    }
-                    int s = (int)__popcnt64(A0 ^ B);
-                    s -= (int)__popcnt64(A1 ^ B);
-                    lv += s;
-                    neurons[solutionBufIdx].input[dataLength + inputNeuronIndex] += lv;
-                    if (neurons[solutionBufIdx].input[dataLength + inputNeuronIndex] < 0) {
-                        setBitNeuron(nrVal1Bit, dataLength + inputNeuronIndex);
-                    }
-                    else {
-                        clearBitNeuron(nrVal1Bit, dataLength + inputNeuronIndex);
+                    SolutionBuffer* const buffer = buffers[lane];
+                    const unsigned short inputNeuronIndex = buffer->nextNeuronIndex;
+                    if (buffer->numberOfRemainingNeurons)
+                    {
+                        buffer->nextNeuronIndex = pickNeuron(buffer);
+                        prefetchRows(buffer->synapses1Bit.input_positive + buffer->nextNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT,
+                            buffer->synapses1Bit.input_negative + buffer->nextNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT,
+                            PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT);
                     }
+                    updateInputNeuron(buffer, inputNeuronIndex);
                 }
             }
         }
 
-        copyMem(&neurons[solutionBufIdx].output[0], &neurons[solutionBufIdx].input[dataLength + numberOfInputNeurons], infoLength * sizeof(neurons[0].input[0]));
-        for (int i = 0; i < dataLength + numberOfOutputNeurons + infoLength; i++) {
-            if (neurons[solutionBufIdx].output[i] < 0) {
-                setBitNeuron(nrVal1Bit, i);
-            }
-            else {
-                clearBitNeuron(nrVal1Bit, i);
-            }
+        for (unsigned int lane = 0; lane < numberOfLanes; lane++)
+        {
+            beginOutputPhase(buffers[lane]);
         }
         for (unsigned int tick = 0; tick < maxOutputDuration; tick++)
         {
-            unsigned short neuronIndices[numberOfOutputNeurons + dataLength];
-            unsigned short numberOfRemainingNeurons = 0;
-            for (numberOfRemainingNeurons = 0; numberOfRemainingNeurons < numberOfOutputNeurons + dataLength; numberOfRemainingNeurons++)
+            for (unsigned int lane = 0; lane < numberOfLanes; lane++)
             {
-                neuronIndices[numberOfRemainingNeurons] = numberOfRemainingNeurons;
+                resetNeuronOrder(buffers[lane], numberOfOutputNeurons + dataLength);
+                buffers[lane]->nextNeuronIndex = pickNeuron(buffers[lane]);
             }
-            while (numberOfRemainingNeurons)
+            for (unsigned int step = 0; step < numberOfOutputNeurons + dataLength; step++)
             {
-                const unsigned short neuronIndexIndex = synapses[solutionBufIdx].lengths[lengthIndex++] % numberOfRemainingNeurons;
-                const unsigned short outputNeuronIndex = neuronIndices[neuronIndexIndex];
-                neuronIndices[neuronIndexIndex] = neuronIndices[--numberOfRemainingNeurons];
-                unsigned long long* sy_pos = (unsigned long long*)(synapses1Bit[solutionBufIdx].output_positive + (outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT));
-                unsigned long long* sy_neg = (unsigned long long*)(synapses1Bit[solutionBufIdx].output_negative + (outputNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT));
-                int lv = 0;
-                for (int i = 0; i < (NEURON_SCANNED_ROUND_OUTPUT - 1); i++) {
-                    unsigned long long A0 = sy_pos[i];
-                    unsigned long long A1 = sy_neg[i];
-                    unsigned long long B = ((unsigned long long*)nrVal1Bit)[i];
-                    int s = (int)__popcnt64(A0 ^ B);
-                    s -= (int)__popcnt64(A1 ^ B);
-                    lv += s;
-                }
+                for (unsigned int lane = 0; lane < numberOfLanes; lane++)
                 {
-                    unsigned long long A0 = (*(unsigned long long*)(sy_pos + (NEURON_SCANNED_ROUND_OUTPUT - 1)));
-                    unsigned long long A1 = (*(unsigned long long*)(sy_neg + (NEURON_SCANNED_ROUND_OUTPUT - 1)));
-                    unsigned long long B = (*(unsigned long long*)(nrVal1Bit + (NEURON_SCANNED_ROUND_OUTPUT - 1) * 8));
-                    if (LAST_ELEMENT_BIT_OUTPUT != 0) {
-                        A0 &= LAST_ELEMENT_MASK_OUTPUT;
-                        A1 &= LAST_ELEMENT_MASK_OUTPUT;
-                        B &= LAST_ELEMENT_MASK_OUTPUT;
-                    }
-                    int s = (int)__popcnt64(A0 ^ B);
-                    s -= (int)__popcnt64(A1 ^ B);
-                    lv += s;
-                    neurons[solutionBufIdx].output[infoLength + outputNeuronIndex] += lv;
-                    if (neurons[solutionBufIdx].output[infoLength + outputNeuronIndex] < 0) {
-                        setBitNeuron(nrVal1Bit, infoLength + outputNeuronIndex);
-                    }
-                    else {
-                        clearBitNeuron(nrVal1Bit, infoLength + outputNeuronIndex);
+                    SolutionBuffer* const buffer = buffers[lane];
+                    const unsigned short outputNeuronIndex = buffer->nextNeuronIndex;
+                    if (buffer->numberOfRemainingNeurons)
+                    {
+                        buffer->nextNeuronIndex = pickNeuron(buffer);
+                        prefetchRows(buffer->synapses1Bit.output_positive + buffer->nextNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT,
+                            buffer->synapses1Bit.output_negative + buffer->nextNeuronIndex * PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT,
+                            PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT);
                     }
+                    updateOutputNeuron(buffer, outputNeuronIndex);
                 }
             }
         }
 
-        for (unsigned int i = 0; i < dataLength; i++)
+        for (unsigned int lane = 0; lane < numberOfLanes; lane++)
         {
-            if ((miningData[i] >= 0) == (neurons[solutionBufIdx].output[infoLength + numberOfOutputNeurons + i] >= 0))
+            scores[solutionIndices[lane]] = countMatchingData(buffers[lane]);
+        }
+    }
+
+    // Score the solutions solutionIndices[0..numberOfSolutions) (at most MAX_SCORE_BATCH_SIZE) with the buffers of solutionBufIdx,
+    // returns false if no buffer could be allocated and the solutions got score 0 without being scored
+    bool scoreGroup(const unsigned long long solutionBufIdx, const unsigned int* solutionIndices, const unsigned int numberOfSolutions,
+        const m256i* publicKeys, const m256i* nonces, unsigned int* scores)
+    {
+        ACQUIRE(solutionEngineLock[solutionBufIdx]);
+        SolutionBuffer* buffers[MAX_SCORE_BATCH_SIZE];
+        unsigned int numberOfLanes = 0;
+        while (numberOfLanes < numberOfSolutions
+            && (buffers[numberOfLanes] = getSolutionBuffer(solutionBufIdx * MAX_SCORE_BATCH_SIZE + numberOfLanes)) != NULL)
+        {
+            numberOfLanes++;
+        }
+        if (!numberOfLanes)
+        {
+            RELEASE(solutionEngineLock[solutionBufIdx]);
+            for (unsigned int i = 0; i < numberOfSolutions; i++)
             {
-                score++;
+                scores[solutionIndices[i]] = 0;
             }
+            return false;
+        }
+
+        // If not all lane buffers are available, use the ones we got several times
+        for (unsigned int i = 0; i < numberOfSolutions; i += numberOfLanes)
+        {
+            scoreLanes(buffers, numberOfSolutions - i < numberOfLanes ? numberOfSolutions - i : numberOfLanes,
+                publicKeys, nonces, solutionIndices + i, scores);
+        }
+
+        const unsigned long long curTimeTick = __rdtsc();
+        for (unsigned int lane = 0; lane < numberOfLanes; lane++)
+        {
+            solutionBufferLastUseTick[solutionBufIdx * MAX_SCORE_BATCH_SIZE + lane] = curTimeTick;
         }
         RELEASE(solutionEngineLock[solutionBufIdx]);
+
+        return true;
+    }
+
+    // Score n solutions on one processor, interleaving up to MAX_SCORE_BATCH_SIZE of them to hide memory latency.
+    // scores[i] is the same as operator()(processor_Number, publicKeys[i], nonces[i]) would return.
+    void scoreBatch(const unsigned long long processor_Number, const m256i* publicKeys, const m256i* nonces, const unsigned int n, unsigned int* scores)
+    {
+        const unsigned long long solutionBufIdx = processor_Number % solutionBufferCount;
+        unsigned int solutionIndices[MAX_SCORE_BATCH_SIZE];
 #if USE_SCORE_CACHE
-        scoreCache.addEntry(publicKey, nonce, scoreCacheIndex, score);
+        unsigned int scoreCacheIndices[MAX_SCORE_BATCH_SIZE];
 #endif
+        unsigned int numberOfSolutions = 0;
+        for (unsigned int i = 0; i < n; i++)
+        {
+#if USE_SCORE_CACHE
+            const unsigned int scoreCacheIndex = scoreCache.getCacheIndex(publicKeys[i], nonces[i]);
+            const int score = scoreCache.tryFetching(publicKeys[i], nonces[i], scoreCacheIndex);
+            if (score >= scoreCache.MIN_VALID_SCORE)
+            {
+                scores[i] = score;
+            }
+            else
+            {
+                scoreCacheIndices[numberOfSolutions] = scoreCacheIndex;
+                solutionIndices[numberOfSolutions++] = i;
+            }
+#else
+            solutionIndices[numberOfSolutions++] = i;
+#endif
+
+            if (numberOfSolutions && (numberOfSolutions == MAX_SCORE_BATCH_SIZE || i == n - 1))
+            {
+#if USE_SCORE_CACHE
+                if (scoreGroup(solutionBufIdx, solutionIndices, numberOfSolutions, publicKeys, nonces, scores))
+                {
+                    for (unsigned int j = 0; j < numberOfSolutions; j++)
+                    {
+                        scoreCache.addEntry(publicKeys[solutionIndices[j]], nonces[solutionIndices[j]], scoreCacheIndices[j], scores[solutionIndices[j]]);
+                    }
+                }
+#else
+                scoreGroup(solutionBufIdx, solutionIndices, numberOfSolutions, publicKeys, nonces, scores);
+#endif
+                numberOfSolutions = 0;
+            }
+        }
+    }
+
+    // main score function
+    unsigned int operator()(const unsigned long long processor_Number, const m256i& publicKey, const m256i& nonce)
+    {
+        unsigned int score;
+        scoreBatch(processor_Number, &publicKey, &nonce, 1, &score);
         return score;
     }
 
@@ -392,13 +748,21 @@ struct ScoreFunction
 
     void tryProcessSolution(unsigned long long processorNumber)
     {
-        m256i publicKey;
-        m256i nonce;
-        bool res = this->getTask(&publicKey, &nonce);
-        if (res)
+        m256i publicKeys[MAX_SCORE_BATCH_SIZE];
+        m256i nonces[MAX_SCORE_BATCH_SIZE];
+        unsigned int scores[MAX_SCORE_BATCH_SIZE];
+        unsigned int numberOfTasks = 0;
+        while (numberOfTasks < MAX_SCORE_BATCH_SIZE && this->getTask(&publicKeys[numberOfTasks], &nonces[numberOfTasks]))
+        {
+            numberOfTasks++;
+        }
+        if (numberOfTasks)
         {
-            (*this)(processorNumber, publicKey, nonce);
-            this->finishTask();
+            this->scoreBatch(processorNumber, publicKeys, nonces, numberOfTasks, scores);
+            for (unsigned int i = 0; i < numberOfTasks; i++)
+            {
+                this->finishTask();
+            }
         }
     }
 };
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+#include "platform/uefi.h"
+#include "platform/console_logging.h"
+
+#include "four_q.h"
+
+#define SHARED_KEY_CACHE_SETS 256 // Must be 2^N
+#define SHARED_KEY_CACHE_WAYS 4
+#define SHARED_KEY_CACHE_NO_COMPUTOR 0xFFFFFFFF
+
+// Shared keys of (own computor, message source) pairs, so that repeated BroadcastMessages of a source skip the scalar multiplication
+// of getSharedKey(). Set-associative LRU, entries are zeroed when they are replaced, at the end of each epoch and on shutdown.
+struct SharedKeyCacheEntry
+{
+    m256i sourcePublicKey;
+    m256i sharedKey;
+    unsigned long long lastUseTick;
+    unsigned int computorIndex; // Index into computorSeeds, SHARED_KEY_CACHE_NO_COMPUTOR if the entry is empty
+};
+
+static SharedKeyCacheEntry* sharedKeyCache = NULL;
+static volatile char sharedKeyCacheLocks[SHARED_KEY_CACHE_SETS];
+
+static void clearSharedKeyCacheEntry(SharedKeyCacheEntry& entry)
+{
+    setMem(&entry, sizeof(entry), 0);
+    entry.computorIndex = SHARED_KEY_CACHE_NO_COMPUTOR;
+}
+
+static bool initSharedKeyCache()
+{
+    EFI_STATUS status;
+    if (status = bs->AllocatePool(EfiRuntimeServicesData, SHARED_KEY_CACHE_SETS * SHARED_KEY_CACHE_WAYS * sizeof(SharedKeyCacheEntry), (void**)&sharedKeyCache))
+    {
+        logStatusToConsole(L"EFI_BOOT_SERVICES.AllocatePool() fails", status, __LINE__);
+
+        return false;
+    }
+    for (unsigned int i = 0; i < SHARED_KEY_CACHE_SETS * SHARED_KEY_CACHE_WAYS; i++)
+    {
+        clearSharedKeyCacheEntry(sharedKeyCache[i]);
+    }
+    for (unsigned int i = 0; i < SHARED_KEY_CACHE_SETS; i++)
+    {
+        sharedKeyCacheLocks[i] = 0;
+    }
+
+    return true;
+}
+
+// Zeroes all shared keys
+static void clearSharedKeyCache()
+{
+    for (unsigned int setIndex = 0; setIndex < SHARED_KEY_CACHE_SETS; setIndex++)
+    {
+        ACQUIRE(sharedKeyCacheLocks[setIndex]);
+        for (unsigned int i = setIndex * SHARED_KEY_CACHE_WAYS; i < (setIndex + 1) * SHARED_KEY_CACHE_WAYS; i++)
+        {
+            clearSharedKeyCacheEntry(sharedKeyCache[i]);
+        }
+        RELEASE(sharedKeyCacheLocks[setIndex]);
+    }
+}
+
+static void deinitSharedKeyCache()
+{
+    if (sharedKeyCache)
+    {
+        clearSharedKeyCache();
+        bs->FreePool(sharedKeyCache);
+    }
+}
+
+// Same as getSharedKey(computorPrivateKey, sourcePublicKey, sharedKey) for the own computor with index computorIndex
+static bool getCachedSharedKey(unsigned int computorIndex, const m256i& computorPrivateKey, const m256i& sourcePublicKey, unsigned char* sharedKey)
+{
+    const unsigned int setIndex = (sourcePublicKey.m256i_u32[0] ^ (computorIndex * 0x9E3779B9)) & (SHARED_KEY_CACHE_SETS - 1);
+    const unsigned int firstEntryIndex = setIndex * SHARED_KEY_CACHE_WAYS;
+
+    ACQUIRE(sharedKeyCacheLocks[setIndex]);
+    for (unsigned int i = firstEntryIndex; i < firstEntryIndex + SHARED_KEY_CACHE_WAYS; i++)
+    {
+        if (sharedKeyCache[i].computorIndex == computorIndex && sharedKeyCache[i].sourcePublicKey == sourcePublicKey)
+        {
+            sharedKeyCache[i].lastUseTick = __rdtsc();
+            copyMem(sharedKey, &sharedKeyCache[i].sharedKey, 32);
+            RELEASE(sharedKeyCacheLocks[setIndex]);
+
+            return true;
+        }
+    }
+    RELEASE(sharedKeyCacheLocks[setIndex]);
+
+    // The scalar multiplication runs without holding the set lock, invalid source keys are not cached
+    if (!getSharedKey(computorPrivateKey.m256i_u8, sourcePublicKey.m256i_u8, sharedKey))
+    {
+        return false;
+    }
+
+    ACQUIRE(sharedKeyCacheLocks[setIndex]);
+    unsigned int entryIndex = firstEntryIndex;
+    for (unsigned int i = firstEntryIndex; i < firstEntryIndex + SHARED_KEY_CACHE_WAYS; i++)
+    {
+        if (sharedKeyCache[i].computorIndex == computorIndex && sharedKeyCache[i].sourcePublicKey == sourcePublicKey)
+        {
+            entryIndex = i;
+
+            break;
+        }
+        if (sharedKeyCache[i].lastUseTick < sharedKeyCache[entryIndex].lastUseTick)
+        {
+            entryIndex = i;
+        }
+    }
+    clearSharedKeyCacheEntry(sharedKeyCache[entryIndex]);
+    sharedKeyCache[entryIndex].sourcePublicKey = sourcePublicKey;
+    copyMem(&sharedKeyCache[entryIndex].sharedKey, sharedKey, 32);
+    sharedKeyCache[entryIndex].lastUseTick = __rdtsc();
+    sharedKeyCache[entryIndex].computorIndex = computorIndex;
+    RELEASE(sharedKeyCacheLocks[setIndex]);
+
+    return true;
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+
+#include "kangaroo_twelve.h"
+
+#include "network/state_sync.h"
+
+#define STATE_SYNC_TICK_LAG 10000 // A node this many ticks behind the latest tick with a quorum of stored ticks syncs its states
+#define STATE_SYNC_CHUNK_LEVEL 12 // The spectrum and the universe are fetched in chunks of 2^STATE_SYNC_CHUNK_LEVEL leaves
+#define MAX_NUMBER_OF_STATE_SYNC_CHUNKS 4096
+#define STATE_SYNC_CONTRACT_STATE_PIECE_SIZE 262144 // Contract states (the chunks of the computer) are fetched in pieces
+#define STATE_SYNC_REQUESTS_PER_PERIOD 16 // Requested chunks or pieces per requesting period
+
+// Merkle trees of the states are stored level by level, the leaves first and the root last
+static inline unsigned long long merkleLevelBeginning(unsigned long long numberOfLeaves, unsigned int level)
+{
+    return numberOfLeaves * 2 - ((numberOfLeaves * 2) >> level);
+}
+
+// Recomputes the nodes above the nodes [first, first + count) of the level up to toLevel, first and count must be multiples of
+// 2^(toLevel - level)
+static void updateMerkleTreeNodes(m256i* tree, unsigned long long numberOfLeaves, unsigned int level, unsigned long long first, unsigned long long count, unsigned int toLevel)
+{
+    while (level < toLevel)
+    {
+        const unsigned long long levelBeginning = merkleLevelBeginning(numberOfLeaves, level);
+        const unsigned long long nextLevelBeginning = merkleLevelBeginning(numberOfLeaves, level + 1);
+        KangarooTwelve64To32Batch(&tree[levelBeginning + first], &tree[nextLevelBeginning + (first >> 1)], (unsigned int)(count >> 1));
+        first >>= 1;
+        count >>= 1;
+        level++;
+    }
+}
+
+// Computes the subtree of a chunk (leafSize bytes per leaf) into chunkTree, which has room for 2^(chunkLevel + 1) - 1 nodes, and
+// returns the digest of the chunk
+static const m256i& hashStateSyncChunk(m256i* chunkTree, unsigned int chunkLevel, const void* leaves, unsigned int leafSize)
+{
+    const unsigned long long numberOfChunkLeaves = 1ULL << chunkLevel;
+    if (leafSize == 64)
+    {
+        KangarooTwelve64To32Batch(leaves, chunkTree, (unsigned int)numberOfChunkLeaves);
+    }
+    else
+    {
+        for (unsigned long long i = 0; i < numberOfChunkLeaves; i++)
+        {
+            KangarooTwelve(((const unsigned char*)leaves) + i * leafSize, leafSize, &chunkTree[i], 32);
+        }
+    }
+    updateMerkleTreeNodes(chunkTree, numberOfChunkLeaves, 0, 0, numberOfChunkLeaves, chunkLevel);
+
+    return chunkTree[numberOfChunkLeaves * 2 - 2];
+}
+
+// Copies the subtree of a chunk computed by hashStateSyncChunk() into the tree of the state
+static void storeStateSyncChunkTree(m256i* tree, unsigned long long numberOfLeaves, unsigned int chunkLevel, unsigned int chunkIndex, const m256i* chunkTree)
+{
+    for (unsigned int level = 0; level <= chunkLevel; level++)
+    {
+        const unsigned long long numberOfLevelNodes = 1ULL << (chunkLevel - level);
+        copyMem(&tree[merkleLevelBeginning(numberOfLeaves, level) + chunkIndex * numberOfLevelNodes], &chunkTree[merkleLevelBeginning(1ULL << chunkLevel, level)], numberOfLevelNodes * sizeof(m256i));
+    }
+}
+
+// Recomputes the nodes above the chunk level and returns the root
+static const m256i& updateStateSyncRoot(m256i* tree, unsigned long long numberOfLeaves, unsigned int chunkLevel)
+{
+    unsigned int rootLevel = 0;
+    while ((1ULL << rootLevel) < numberOfLeaves)
+    {
+        rootLevel++;
+    }
+    updateMerkleTreeNodes(tree, numberOfLeaves, chunkLevel, 0, numberOfLeaves >> chunkLevel, rootLevel);
+
+    return tree[numberOfLeaves * 2 - 2];
+}
+
+// A lagging node fetches the chunk digests of one state after the other from peers and then every chunk whose local digest
+// differs, a chunk only replaces the local one if it hashes to its fetched digest. All digests of a round are taken from the same
+// tick of the peers. Once the peers have moved on from that tick, the chunks changed since can no longer be fetched; another
+// round then fetches the digests of a later tick again and the few chunks that have changed. Once all states match the fetched
+// digests their roots are checked against the prev digests of the quorum-confirmed ticks around the tick of the round.
+struct StateSync
+{
+    volatile bool isActive;
+    volatile bool isConverged; // All states match the chunk digests of the current round
+
+    unsigned int tick; // Tick of the peers the chunk digests of the round are taken from, 0 until the first ones have arrived
+    unsigned int state; // State whose chunks are fetched
+    bool areChunkDigestsKnown;
+    unsigned int numberOfChunks;
+    m256i chunkDigests[MAX_NUMBER_OF_STATE_SYNC_CHUNKS];
+
+    unsigned int nextChunk; // Next chunk to compare in the current pass over the chunks
+    unsigned int numberOfMismatchingChunks; // Found in the current pass
+    unsigned int numberOfPreviouslyMismatchingChunks; // Found in the previous pass over the chunks of the state
+    unsigned int numberOfRounds;
+
+    unsigned int contractIndex; // Contract whose state is assembled from its pieces
+    unsigned long long receivedContractStateSize; // Bytes of the contract state received since it was requested
+};
+
+static volatile char stateSyncLock = 0;
+static StateSync stateSync;
+
+static void beginStateSyncRound()
+{
+    stateSync.isConverged = false;
+    stateSync.tick = 0;
+    stateSync.state = STATE_SYNC_SPECTRUM;
+    stateSync.areChunkDigestsKnown = false;
+    stateSync.numberOfRounds++;
+}
+
+static void beginStateSync()
+{
+    ACQUIRE(stateSyncLock);
+
+    setMem(&stateSync, sizeof(stateSync), 0);
+    beginStateSyncRound();
+    stateSync.isActive = true;
+
+    RELEASE(stateSyncLock);
+}
+
+// Fetches the chunk digests again once the synced states match no quorum-confirmed tick
+static void repeatStateSyncRound()
+{
+    ACQUIRE(stateSyncLock);
+
+    beginStateSyncRound();
+
+    RELEASE(stateSyncLock);
+}
+
+static void endStateSync()
+{
+    ACQUIRE(stateSyncLock);
+
+    stateSync.isActive = false;
+
+    RELEASE(stateSyncLock);
+}
+
+// Takes the fetched chunk digests of the state the sync is waiting for if they are of the tick of the round. Digests of a later
+// tick begin a new round at that tick, digests of an earlier one are ignored.
+static void setStateSyncChunkDigests(unsigned int state, unsigned int tick, const m256i* chunkDigests, unsigned int numberOfChunks)
+{
+    ACQUIRE(stateSyncLock);
+
+    if (stateSync.isActive && !stateSync.isConverged
+        && state == stateSync.state && !stateSync.areChunkDigestsKnown
+        && tick && numberOfChunks && numberOfChunks <= MAX_NUMBER_OF_STATE_SYNC_CHUNKS)
+    {
+        if (stateSync.tick && tick > stateSync.tick)
+        {
+            // The chunks that have changed since the tick of the round cannot be fetched anymore
+            beginStateSyncRound();
+        }
+        else if (!stateSync.tick || tick == stateSync.tick)
+        {
+            copyMem(stateSync.chunkDigests, chunkDigests, numberOfChunks * sizeof(m256i));
+            stateSync.tick = tick;
+            stateSync.numberOfChunks = numberOfChunks;
+            stateSync.areChunkDigestsKnown = true;
+            stateSync.nextChunk = 0;
+            stateSync.numberOfMismatchingChunks = 0;
+            stateSync.numberOfPreviouslyMismatchingChunks = 0xFFFFFFFF;
+        }
+    }
+
+    RELEASE(stateSyncLock);
+}
+
+// Whether a fetched chunk of the state is still needed, its local digest (at the chunk level) differs from the fetched one
+static bool isStateSyncChunkMismatching(unsigned int state, unsigned int chunkIndex, const m256i* localChunkDigests)
+{
+    return stateSync.isActive && !stateSync.isConverged
+        && state == stateSync.state && stateSync.areChunkDigestsKnown
+        && chunkIndex < stateSync.numberOfChunks
+        && localChunkDigests[chunkIndex] != stateSync.chunkDigests[chunkIndex];
+}
+
+// Whether a fetched chunk of the state hashes to the chunk digest of the round, only then may it replace the local chunk
+static bool isStateSyncChunkValid(unsigned int state, unsigned int chunkIndex, const m256i& chunkDigest)
+{
+    return stateSync.isActive && !stateSync.isConverged
+        && state == stateSync.state && stateSync.areChunkDigestsKnown
+        && chunkIndex < stateSync.numberOfChunks
+        && chunkDigest == stateSync.chunkDigests[chunkIndex];
+}
+
+// Finds up to maxNumberOfChunks chunks of the state whose local digests differ from the fetched ones. A pass over all chunks
+// without a mismatch moves the sync on to the next state, after the last state the round has converged. A pass that has not
+// found fewer mismatching chunks than the previous one begins a new round, the peers no longer have the missing chunks.
+static unsigned int nextMismatchingStateSyncChunks(unsigned int state, const m256i* localChunkDigests, unsigned int* chunkIndices, unsigned int maxNumberOfChunks)
+{
+    unsigned int numberOfChunks = 0;
+
+    ACQUIRE(stateSyncLock);
+
+    if (stateSync.isActive && !stateSync.isConverged && state == stateSync.state && stateSync.areChunkDigestsKnown)
+    {
+        while (numberOfChunks < maxNumberOfChunks)
+        {
+            if (stateSync.nextChunk == stateSync.numberOfChunks)
+            {
+                if (stateSync.numberOfMismatchingChunks >= stateSync.numberOfPreviouslyMismatchingChunks)
+                {
+                    beginStateSyncRound();
+                }
+                else if (stateSync.numberOfMismatchingChunks)
+                {
+                    // Requested chunks may still be on their way, they are compared again in the next pass
+                    stateSync.numberOfPreviouslyMismatchingChunks = stateSync.numberOfMismatchingChunks;
+                    stateSync.nextChunk = 0;
+                    stateSync.numberOfMismatchingChunks = 0;
+                }
+                else
+                {
+                    stateSync.areChunkDigestsKnown = false;
+                    if (++stateSync.state == NUMBER_OF_SYNCED_STATES)
+                    {
+                        stateSync.isConverged = true;
+                    }
+                }
+
+                break;
+            }
+
+            if (localChunkDigests[stateSync.nextChunk] != stateSync.chunkDigests[stateSync.nextChunk])
+            {
+                chunkIndices[numberOfChunks++] = stateSync.nextChunk;
+                stateSync.numberOfMismatchingChunks++;
+            }
+            stateSync.nextChunk++;
+        }
+    }
+
+    RELEASE(stateSyncLock);
+
+    return numberOfChunks;
+}
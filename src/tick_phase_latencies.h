@@ -0,0 +1,133 @@
+#pragma once
+
+#include <intrin.h>
+
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+
+#include "network/tick_phase_latencies.h"
+
+#define TICK_PHASE_LATENCY_WINDOW 1024 // Number of latest ticks the latencies are taken over
+#define TICK_PHASE_LATENCY_SUB_BUCKETS 4 // Buckets per power of 2, taken from the 2 bits below the highest one
+#define NUMBER_OF_TICK_PHASE_LATENCY_BUCKETS (64 * TICK_PHASE_LATENCY_SUB_BUCKETS)
+
+// Rolling histograms of the latest spans of every phase (in TSC ticks), a span entering the window replaces the oldest one in
+// its histogram so that percentiles can be read without sorting
+struct TickPhaseLatencyHistogram
+{
+    unsigned long long spans[TICK_PHASE_LATENCY_WINDOW];
+    unsigned short bucketCounts[NUMBER_OF_TICK_PHASE_LATENCY_BUCKETS];
+};
+
+static volatile char tickPhaseLatenciesLock = 0;
+static TickPhaseLatencyHistogram tickPhaseLatencyHistograms[NUMBER_OF_TICK_PHASES];
+static unsigned long long numberOfRecordedTicks = 0;
+static unsigned int latestRecordedTick = 0;
+
+static void initTickPhaseLatencies()
+{
+    setMem(tickPhaseLatencyHistograms, sizeof(tickPhaseLatencyHistograms), 0);
+    numberOfRecordedTicks = 0;
+    latestRecordedTick = 0;
+}
+
+// Spans below TICK_PHASE_LATENCY_SUB_BUCKETS have their own buckets, larger spans are split by their highest bit and the bits
+// below it
+static inline unsigned int tickPhaseLatencyBucket(unsigned long long span)
+{
+    if (span < TICK_PHASE_LATENCY_SUB_BUCKETS)
+    {
+        return (unsigned int)span;
+    }
+    const unsigned int highestBit = 63 - (unsigned int)_lzcnt_u64(span); // At least 2
+
+    return (highestBit - 1) * TICK_PHASE_LATENCY_SUB_BUCKETS + (unsigned int)((span >> (highestBit - 2)) & (TICK_PHASE_LATENCY_SUB_BUCKETS - 1));
+}
+
+// Largest span that falls into the bucket
+static inline unsigned long long tickPhaseLatencyBucketLimit(unsigned int bucket)
+{
+    if (bucket < TICK_PHASE_LATENCY_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    const unsigned int highestBit = bucket / TICK_PHASE_LATENCY_SUB_BUCKETS + 1;
+    const unsigned long long lowestSpan = ((unsigned long long)(TICK_PHASE_LATENCY_SUB_BUCKETS + bucket % TICK_PHASE_LATENCY_SUB_BUCKETS)) << (highestBit - 2);
+
+    return lowestSpan + (1ULL << (highestBit - 2)) - 1;
+}
+
+// spans are the durations of the phases of the processed tick in TSC ticks
+static void recordTickPhaseLatencies(unsigned int tick, const unsigned long long spans[NUMBER_OF_TICK_PHASES])
+{
+    ACQUIRE(tickPhaseLatenciesLock);
+
+    const unsigned int position = numberOfRecordedTicks % TICK_PHASE_LATENCY_WINDOW;
+    for (unsigned int phase = 0; phase < NUMBER_OF_TICK_PHASES; phase++)
+    {
+        TickPhaseLatencyHistogram& histogram = tickPhaseLatencyHistograms[phase];
+        if (numberOfRecordedTicks >= TICK_PHASE_LATENCY_WINDOW)
+        {
+            histogram.bucketCounts[tickPhaseLatencyBucket(histogram.spans[position])]--;
+        }
+        histogram.spans[position] = spans[phase];
+        histogram.bucketCounts[tickPhaseLatencyBucket(spans[phase])]++;
+    }
+    numberOfRecordedTicks++;
+    latestRecordedTick = tick;
+
+    RELEASE(tickPhaseLatenciesLock);
+}
+
+static inline unsigned int tickPhaseLatencyMicroseconds(unsigned long long span, unsigned long long frequency)
+{
+    const unsigned long long microseconds = span * 1000000 / frequency;
+
+    return microseconds > 0xFFFFFFFF ? 0xFFFFFFFF : (unsigned int)microseconds;
+}
+
+// frequency is the number of TSC ticks per second
+static void getTickPhaseLatencies(RespondTickPhaseLatencies& response, unsigned long long frequency)
+{
+    ACQUIRE(tickPhaseLatenciesLock);
+
+    const unsigned int numberOfTicks = numberOfRecordedTicks < TICK_PHASE_LATENCY_WINDOW ? (unsigned int)numberOfRecordedTicks : TICK_PHASE_LATENCY_WINDOW;
+    response.tick = latestRecordedTick;
+    response.numberOfTicks = numberOfTicks;
+    for (unsigned int phase = 0; phase < NUMBER_OF_TICK_PHASES; phase++)
+    {
+        const TickPhaseLatencyHistogram& histogram = tickPhaseLatencyHistograms[phase];
+        TickPhaseLatency& latency = response.phases[phase];
+        setMem(&latency, sizeof(latency), 0);
+        if (numberOfTicks)
+        {
+            const unsigned int p50Rank = (numberOfTicks * 50 + 99) / 100;
+            const unsigned int p99Rank = (numberOfTicks * 99 + 99) / 100;
+            unsigned int numberOfSpans = 0;
+            for (unsigned int bucket = 0; bucket < NUMBER_OF_TICK_PHASE_LATENCY_BUCKETS && numberOfSpans < p99Rank; bucket++)
+            {
+                if (numberOfSpans < p50Rank && numberOfSpans + histogram.bucketCounts[bucket] >= p50Rank)
+                {
+                    latency.p50 = tickPhaseLatencyMicroseconds(tickPhaseLatencyBucketLimit(bucket), frequency);
+                }
+                numberOfSpans += histogram.bucketCounts[bucket];
+                if (numberOfSpans >= p99Rank)
+                {
+                    latency.p99 = tickPhaseLatencyMicroseconds(tickPhaseLatencyBucketLimit(bucket), frequency);
+                }
+            }
+
+            unsigned long long maxSpan = 0;
+            for (unsigned int i = 0; i < numberOfTicks; i++)
+            {
+                if (histogram.spans[i] > maxSpan)
+                {
+                    maxSpan = histogram.spans[i];
+                }
+            }
+            latency.max = tickPhaseLatencyMicroseconds(maxSpan, frequency);
+        }
+    }
+
+    RELEASE(tickPhaseLatenciesLock);
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+
+#include "network/common_def.h"
+
+#define NUMBER_OF_TICK_ESSENCES_PER_TICK 4 // Room for distinct essences on average, the ticks of honest computors share one
+#define MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES 16 // Per computor, for epochs of a few ticks
+#define TICK_ESSENCE_SHARING_THRESHOLD (NUMBER_OF_COMPUTORS - NUMBER_OF_COMPUTORS * 2 / 3) // More computors than can be faulty
+#define MAX_NUMBER_OF_SHARED_TICK_ESSENCES_PER_TICK (NUMBER_OF_COMPUTORS / TICK_ESSENCE_SHARING_THRESHOLD)
+
+// Ticks of the computors for the ticks of an epoch. The ticks of honest computors only differ in their salted digests and
+// signatures, so the rest of a tick (its essence) is stored once per tick and distinct value and the computor ticks refer to it.
+// Full ticks (of type TickType with the members of Tick) are reconstructed on demand. Stored data never changes during an epoch,
+// a computor tick is published by writing its epoch last.
+// A new essence is charged to the computor whose tick brought it until TICK_ESSENCE_SHARING_THRESHOLD computors share it, and
+// every computor has a budget of charged essences. Faulty computors can only use up their own budgets, the room for essences is
+// sized for all budgets plus the shared essences.
+struct StoredTickEssence
+{
+    unsigned short epoch;
+    unsigned int tick;
+
+    unsigned short millisecond;
+    unsigned char second;
+    unsigned char minute;
+    unsigned char hour;
+    unsigned char day;
+    unsigned char month;
+    unsigned char year;
+
+    unsigned long long prevResourceTestingDigest;
+
+    m256i prevSpectrumDigest;
+    m256i prevUniverseDigest;
+    m256i prevComputerDigest;
+    m256i transactionDigest;
+    m256i expectedNextTickTransactionDigest;
+
+    unsigned int nextEssence; // Next essence of the same tick, 0 if none
+    unsigned short numberOfComputorTicks;
+    unsigned short creatorComputorIndex;
+};
+
+struct StoredComputorTick
+{
+    unsigned short epoch; // The tick is missing unless this is the current epoch
+    unsigned int essence; // Index in tickEssences
+
+    unsigned long long saltedResourceTestingDigest;
+
+    m256i saltedSpectrumDigest;
+    m256i saltedUniverseDigest;
+    m256i saltedComputerDigest;
+
+    unsigned char signature[SIGNATURE_SIZE];
+};
+
+static volatile char tickEssencesLock = 0;
+static StoredTickEssence* tickEssences = NULL; // Index 0 is unused
+static unsigned int numberOfTickEssences = 0;
+static unsigned int maxNumberOfTickEssences = 0;
+static unsigned int numberOfUnsharedTickEssences[NUMBER_OF_COMPUTORS]; // Charged to each computor
+static unsigned int maxNumberOfUnsharedTickEssences = 0;
+static unsigned long long numberOfUnstoredComputorTicks = 0; // Without room for their essences
+static unsigned int* volatile firstTickEssences = NULL; // Per tick, 0 if the tick has no essence yet
+static StoredComputorTick* storedComputorTicks = NULL; // NUMBER_OF_COMPUTORS per tick
+static unsigned int numberOfStoredTicksTicks = 0;
+
+// numberOfTicks is the number of ticks of an epoch
+static bool initTickStorage(unsigned int numberOfTicks)
+{
+    maxNumberOfUnsharedTickEssences = (unsigned int)(((unsigned long long)numberOfTicks) * (NUMBER_OF_TICK_ESSENCES_PER_TICK - MAX_NUMBER_OF_SHARED_TICK_ESSENCES_PER_TICK) / NUMBER_OF_COMPUTORS);
+    if (maxNumberOfUnsharedTickEssences < MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES)
+    {
+        maxNumberOfUnsharedTickEssences = MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES;
+    }
+    maxNumberOfTickEssences = 1 + numberOfTicks * MAX_NUMBER_OF_SHARED_TICK_ESSENCES_PER_TICK + NUMBER_OF_COMPUTORS * maxNumberOfUnsharedTickEssences;
+    if (!allocatePool(((unsigned long long)maxNumberOfTickEssences) * sizeof(StoredTickEssence), (void**)&tickEssences)
+        || !allocatePool(numberOfTicks * sizeof(unsigned int), (void**)&firstTickEssences)
+        || !allocatePool(((unsigned long long)numberOfTicks) * NUMBER_OF_COMPUTORS * sizeof(StoredComputorTick), (void**)&storedComputorTicks))
+    {
+        return false;
+    }
+    setMem((void*)firstTickEssences, numberOfTicks * sizeof(unsigned int), 0);
+    setMem(storedComputorTicks, ((unsigned long long)numberOfTicks) * NUMBER_OF_COMPUTORS * sizeof(StoredComputorTick), 0);
+    numberOfStoredTicksTicks = numberOfTicks;
+    numberOfTickEssences = 1;
+    setMem(numberOfUnsharedTickEssences, sizeof(numberOfUnsharedTickEssences), 0);
+    numberOfUnstoredComputorTicks = 0;
+
+    return true;
+}
+
+static void deinitTickStorage()
+{
+    if (storedComputorTicks)
+    {
+        freePool(storedComputorTicks);
+        storedComputorTicks = NULL;
+    }
+    if (firstTickEssences)
+    {
+        freePool((void*)firstTickEssences);
+        firstTickEssences = NULL;
+    }
+    if (tickEssences)
+    {
+        freePool(tickEssences);
+        tickEssences = NULL;
+    }
+}
+
+// Frees the essences for a new epoch, the computor ticks of the previous epoch are missing from then on
+static void resetTickStorage()
+{
+    ACQUIRE(tickEssencesLock);
+
+    setMem((void*)firstTickEssences, numberOfStoredTicksTicks * sizeof(unsigned int), 0);
+    numberOfTickEssences = 1;
+    setMem(numberOfUnsharedTickEssences, sizeof(numberOfUnsharedTickEssences), 0);
+
+    RELEASE(tickEssencesLock);
+}
+
+static inline StoredComputorTick& storedComputorTick(unsigned int tickOffset, unsigned int computorIndex)
+{
+    return storedComputorTicks[((unsigned long long)tickOffset) * NUMBER_OF_COMPUTORS + computorIndex];
+}
+
+static bool isTickStored(unsigned int tickOffset, unsigned int computorIndex, unsigned short epoch)
+{
+    return storedComputorTick(tickOffset, computorIndex).epoch == epoch;
+}
+
+// Only call for stored ticks
+static const StoredTickEssence& storedTickEssence(unsigned int tickOffset, unsigned int computorIndex)
+{
+    return tickEssences[storedComputorTick(tickOffset, computorIndex).essence];
+}
+
+// Returns the index of the essence shared by at least quorum stored ticks of the tick, or 0 if there is none
+static unsigned int quorumTickEssence(unsigned int tickOffset, unsigned short epoch, unsigned int quorum)
+{
+    for (unsigned int essence = firstTickEssences[tickOffset]; essence; essence = tickEssences[essence].nextEssence)
+    {
+        unsigned int numberOfTicks = 0;
+        for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+        {
+            if (isTickStored(tickOffset, computorIndex, epoch) && storedComputorTick(tickOffset, computorIndex).essence == essence)
+            {
+                numberOfTicks++;
+            }
+        }
+        if (numberOfTicks >= quorum)
+        {
+            return essence;
+        }
+    }
+
+    return 0;
+}
+
+template <typename TickType>
+static bool isSameTickEssence(const StoredTickEssence& essence, const TickType& tick)
+{
+    return essence.epoch == tick.epoch
+        && essence.tick == tick.tick
+        && *((unsigned long long*)&essence.millisecond) == *((unsigned long long*)&tick.millisecond)
+        && essence.prevResourceTestingDigest == tick.prevResourceTestingDigest
+        && essence.prevSpectrumDigest == tick.prevSpectrumDigest
+        && essence.prevUniverseDigest == tick.prevUniverseDigest
+        && essence.prevComputerDigest == tick.prevComputerDigest
+        && essence.transactionDigest == tick.transactionDigest
+        && essence.expectedNextTickTransactionDigest == tick.expectedNextTickTransactionDigest;
+}
+
+// Returns the index of the essence of the tick, stored if it is new, or 0 if the computor of the tick has used up its budget of
+// unshared essences. Only call once per tick and computor.
+template <typename TickType>
+static unsigned int storeTickEssence(unsigned int tickOffset, const TickType& tick)
+{
+    ACQUIRE(tickEssencesLock);
+
+    unsigned int essence;
+    for (essence = firstTickEssences[tickOffset]; essence; essence = tickEssences[essence].nextEssence)
+    {
+        if (isSameTickEssence(tickEssences[essence], tick))
+        {
+            if (++tickEssences[essence].numberOfComputorTicks == TICK_ESSENCE_SHARING_THRESHOLD)
+            {
+                numberOfUnsharedTickEssences[tickEssences[essence].creatorComputorIndex]--;
+            }
+            break;
+        }
+    }
+    if (!essence && numberOfUnsharedTickEssences[tick.computorIndex] < maxNumberOfUnsharedTickEssences
+        && numberOfTickEssences < maxNumberOfTickEssences)
+    {
+        numberOfUnsharedTickEssences[tick.computorIndex]++;
+        essence = numberOfTickEssences++;
+        StoredTickEssence& storedEssence = tickEssences[essence];
+        storedEssence.epoch = tick.epoch;
+        storedEssence.tick = tick.tick;
+        *((unsigned long long*)&storedEssence.millisecond) = *((unsigned long long*)&tick.millisecond);
+        storedEssence.prevResourceTestingDigest = tick.prevResourceTestingDigest;
+        storedEssence.prevSpectrumDigest = tick.prevSpectrumDigest;
+        storedEssence.prevUniverseDigest = tick.prevUniverseDigest;
+        storedEssence.prevComputerDigest = tick.prevComputerDigest;
+        storedEssence.transactionDigest = tick.transactionDigest;
+        storedEssence.expectedNextTickTransactionDigest = tick.expectedNextTickTransactionDigest;
+        storedEssence.numberOfComputorTicks = 1;
+        storedEssence.creatorComputorIndex = tick.computorIndex;
+        storedEssence.nextEssence = firstTickEssences[tickOffset];
+        _mm_sfence();
+        firstTickEssences[tickOffset] = essence;
+    }
+    if (!essence)
+    {
+        numberOfUnstoredComputorTicks++;
+    }
+
+    RELEASE(tickEssencesLock);
+
+    return essence;
+}
+
+// Stores the tick of its computor unless there is no room left for its essence, the caller must make sure that the tick of the
+// computor is not stored yet and that nobody else stores it at the same time
+template <typename TickType>
+static bool storeTick(unsigned int tickOffset, const TickType& tick)
+{
+    const unsigned int essence = storeTickEssence(tickOffset, tick);
+    if (!essence)
+    {
+        return false;
+    }
+
+    StoredComputorTick& computorTick = storedComputorTick(tickOffset, tick.computorIndex);
+    computorTick.essence = essence;
+    computorTick.saltedResourceTestingDigest = tick.saltedResourceTestingDigest;
+    computorTick.saltedSpectrumDigest = tick.saltedSpectrumDigest;
+    computorTick.saltedUniverseDigest = tick.saltedUniverseDigest;
+    computorTick.saltedComputerDigest = tick.saltedComputerDigest;
+    copyMem(computorTick.signature, tick.signature, SIGNATURE_SIZE);
+    _mm_sfence();
+    computorTick.epoch = tick.epoch;
+
+    return true;
+}
+
+// Reconstructs the full tick of a computor, only call for stored ticks
+template <typename TickType>
+static void getStoredTick(unsigned int tickOffset, unsigned int computorIndex, TickType& tick)
+{
+    const StoredComputorTick& computorTick = storedComputorTick(tickOffset, computorIndex);
+    const StoredTickEssence& essence = tickEssences[computorTick.essence];
+    tick.computorIndex = computorIndex;
+    tick.epoch = essence.epoch;
+    tick.tick = essence.tick;
+    *((unsigned long long*)&tick.millisecond) = *((unsigned long long*)&essence.millisecond);
+    tick.prevResourceTestingDigest = essence.prevResourceTestingDigest;
+    tick.saltedResourceTestingDigest = computorTick.saltedResourceTestingDigest;
+    tick.prevSpectrumDigest = essence.prevSpectrumDigest;
+    tick.prevUniverseDigest = essence.prevUniverseDigest;
+    tick.prevComputerDigest = essence.prevComputerDigest;
+    tick.saltedSpectrumDigest = computorTick.saltedSpectrumDigest;
+    tick.saltedUniverseDigest = computorTick.saltedUniverseDigest;
+    tick.saltedComputerDigest = computorTick.saltedComputerDigest;
+    tick.transactionDigest = essence.transactionDigest;
+    tick.expectedNextTickTransactionDigest = essence.expectedNextTickTransactionDigest;
+    copyMem(tick.signature, computorTick.signature, SIGNATURE_SIZE);
+}
+
+// The stored ticks of all computors for a tick as seen by the tick votes
+struct StoredComputorTicks
+{
+    unsigned int tickOffset;
+
+    const m256i& transactionDigest(unsigned int computorIndex) const
+    {
+        return storedTickEssence(tickOffset, computorIndex).transactionDigest;
+    }
+
+    const m256i& expectedNextTickTransactionDigest(unsigned int computorIndex) const
+    {
+        return storedTickEssence(tickOffset, computorIndex).expectedNextTickTransactionDigest;
+    }
+};
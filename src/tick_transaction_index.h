@@ -0,0 +1,67 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/memory.h"
+
+#include "network/common_def.h"
+
+#define TICK_TRANSACTION_INDEX_SIZE (NUMBER_OF_TRANSACTIONS_PER_TICK * 2) // Must be 2^N, keeps the load factor at or below 1/2
+
+// Open-addressed map from the transaction digests of a TickData to their indices, so that a transaction is matched to its
+// slot without scanning all NUMBER_OF_TRANSACTIONS_PER_TICK digests. Slots hold the transaction index + 1, an all-zero
+// index is empty. The index only refers to the digests it was built from, it has to be rebuilt whenever they change.
+struct TickTransactionIndex
+{
+    unsigned short slots[TICK_TRANSACTION_INDEX_SIZE];
+};
+
+static_assert(NUMBER_OF_TRANSACTIONS_PER_TICK < 65536, "Transaction indices must fit into the slots of TickTransactionIndex.");
+
+static inline unsigned int tickTransactionIndexSlot(const m256i& transactionDigest)
+{
+    // Digests are K12 outputs, their low bits are uniformly distributed
+    return transactionDigest.m256i_u32[0] & (TICK_TRANSACTION_INDEX_SIZE - 1);
+}
+
+// Zero digests (empty transaction slots) are not indexed, a digest listed several times maps to its lowest index
+static void buildTickTransactionIndex(const m256i* transactionDigests, TickTransactionIndex& index)
+{
+    setMem(index.slots, sizeof(index.slots), 0);
+    for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+    {
+        if (!isZero(transactionDigests[i]))
+        {
+            unsigned int slot = tickTransactionIndexSlot(transactionDigests[i]);
+            while (index.slots[slot])
+            {
+                if (transactionDigests[index.slots[slot] - 1] == transactionDigests[i])
+                {
+                    break;
+                }
+                slot = (slot + 1) & (TICK_TRANSACTION_INDEX_SIZE - 1);
+            }
+            if (!index.slots[slot])
+            {
+                index.slots[slot] = i + 1;
+            }
+        }
+    }
+}
+
+// Returns the index of transactionDigest in transactionDigests (which index has been built from) or -1 if it is not listed
+static int findTickTransaction(const m256i* transactionDigests, const TickTransactionIndex& index, const m256i& transactionDigest)
+{
+    if (isZero(transactionDigest))
+    {
+        return -1;
+    }
+    for (unsigned int slot = tickTransactionIndexSlot(transactionDigest); index.slots[slot]; slot = (slot + 1) & (TICK_TRANSACTION_INDEX_SIZE - 1))
+    {
+        if (transactionDigests[index.slots[slot] - 1] == transactionDigest)
+        {
+            return index.slots[slot] - 1;
+        }
+    }
+
+    return -1;
+}
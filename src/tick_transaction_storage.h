@@ -0,0 +1,157 @@
+#pragma once
+
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+
+#include "network/common_def.h"
+
+#define TICK_TRANSACTIONS_CHUNK_SIZE 0x4000000ULL // Must be 2^N
+#define TICK_TRANSACTIONS_ALIGNMENT 16ULL // Must be 2^N
+#define MAX_NUMBER_OF_TICK_TRANSACTIONS_CHUNKS 1024 // Limited by the handle bits, 64 GB in total
+#define NUMBER_OF_SPARE_TICK_TRANSACTIONS_CHUNKS 2 // Allocated ahead so that processors never wait for boot services
+
+// Transactions of the ticks of an epoch, stored one after another in chunks that are allocated as the transactions arrive.
+// A transaction is referred to by a 4-byte handle (chunk index in the high bits, offset within the chunk in units of
+// TICK_TRANSACTIONS_ALIGNMENT in the low bits, 0 if missing), each tick that has transactions owns an array of
+// NUMBER_OF_TRANSACTIONS_PER_TICK handles which is allocated in the chunks as well. Stored data never moves, so it is read without
+// holding tickTransactionsLock. Chunks can only be allocated on the BSP, manageTickTransactionsChunks() keeps spare chunks ready.
+#define TICK_TRANSACTIONS_CHUNK_OFFSET_BITS 22
+static_assert((TICK_TRANSACTIONS_CHUNK_SIZE / TICK_TRANSACTIONS_ALIGNMENT) == (1ULL << TICK_TRANSACTIONS_CHUNK_OFFSET_BITS), "Chunk offsets must fill the low bits of the handles.");
+static_assert(MAX_NUMBER_OF_TICK_TRANSACTIONS_CHUNKS <= (1ULL << (32 - TICK_TRANSACTIONS_CHUNK_OFFSET_BITS)), "Chunk indices must fit into the high bits of the handles.");
+
+static volatile char tickTransactionsLock = 0;
+static unsigned char* tickTransactionsChunks[MAX_NUMBER_OF_TICK_TRANSACTIONS_CHUNKS];
+static volatile unsigned int numberOfTickTransactionsChunks = 0;
+static unsigned int currentTickTransactionsChunk = 0;
+static unsigned long long currentTickTransactionsChunkOffset = 0;
+static unsigned int* volatile* tickTransactionHandles = NULL; // Per tick, NULL if the tick has no transactions yet
+static unsigned int numberOfTickTransactionsTicks = 0;
+static unsigned long long tickTransactionsSize = 0; // Bytes used in the chunks
+
+// Only call from the BSP
+static bool manageTickTransactionsChunks()
+{
+    while (numberOfTickTransactionsChunks < MAX_NUMBER_OF_TICK_TRANSACTIONS_CHUNKS
+        && numberOfTickTransactionsChunks - currentTickTransactionsChunk <= NUMBER_OF_SPARE_TICK_TRANSACTIONS_CHUNKS)
+    {
+        void* chunk;
+        if (!allocatePool(TICK_TRANSACTIONS_CHUNK_SIZE, &chunk))
+        {
+            return false;
+        }
+        tickTransactionsChunks[numberOfTickTransactionsChunks] = (unsigned char*)chunk;
+        _mm_sfence();
+        numberOfTickTransactionsChunks = numberOfTickTransactionsChunks + 1;
+    }
+
+    return true;
+}
+
+// numberOfTicks is the number of ticks of an epoch, only call from the BSP
+static bool initTickTransactions(unsigned int numberOfTicks)
+{
+    if (!allocatePool(numberOfTicks * sizeof(unsigned int*), (void**)&tickTransactionHandles))
+    {
+        return false;
+    }
+    setMem((void*)tickTransactionHandles, numberOfTicks * sizeof(unsigned int*), 0);
+    numberOfTickTransactionsTicks = numberOfTicks;
+
+    // Handle 0 means "missing", so the chunks start with an unused unit
+    numberOfTickTransactionsChunks = 0;
+    currentTickTransactionsChunk = 0;
+    currentTickTransactionsChunkOffset = TICK_TRANSACTIONS_ALIGNMENT;
+    tickTransactionsSize = 0;
+
+    return manageTickTransactionsChunks();
+}
+
+static void deinitTickTransactions()
+{
+    for (unsigned int i = 0; i < numberOfTickTransactionsChunks; i++)
+    {
+        freePool(tickTransactionsChunks[i]);
+    }
+    numberOfTickTransactionsChunks = 0;
+    if (tickTransactionHandles)
+    {
+        freePool((void*)tickTransactionHandles);
+        tickTransactionHandles = NULL;
+    }
+}
+
+// Caller must hold tickTransactionsLock, returns 0 if all chunks are full
+static unsigned int allocateTickTransactionsSpace(unsigned long long size)
+{
+    size = (size + TICK_TRANSACTIONS_ALIGNMENT - 1) & ~(TICK_TRANSACTIONS_ALIGNMENT - 1);
+    if (currentTickTransactionsChunkOffset + size > TICK_TRANSACTIONS_CHUNK_SIZE)
+    {
+        if (currentTickTransactionsChunk + 1 >= numberOfTickTransactionsChunks)
+        {
+            return 0;
+        }
+        currentTickTransactionsChunk++;
+        currentTickTransactionsChunkOffset = 0;
+    }
+    const unsigned int handle = (currentTickTransactionsChunk << TICK_TRANSACTIONS_CHUNK_OFFSET_BITS) | (unsigned int)(currentTickTransactionsChunkOffset / TICK_TRANSACTIONS_ALIGNMENT);
+    currentTickTransactionsChunkOffset += size;
+    tickTransactionsSize += size;
+
+    return handle;
+}
+
+static inline unsigned char* tickTransactionsData(unsigned int handle)
+{
+    return &tickTransactionsChunks[handle >> TICK_TRANSACTIONS_CHUNK_OFFSET_BITS][(handle & ((1 << TICK_TRANSACTIONS_CHUNK_OFFSET_BITS) - 1)) * TICK_TRANSACTIONS_ALIGNMENT];
+}
+
+// Returns the transaction with index transactionIndex of the tick with offset tickOffset (tick - initial tick) or NULL if it is not stored
+static const unsigned char* getTickTransaction(unsigned int tickOffset, unsigned int transactionIndex)
+{
+    const unsigned int* handles = tickTransactionHandles[tickOffset];
+    if (!handles || !handles[transactionIndex])
+    {
+        return NULL;
+    }
+
+    return tickTransactionsData(handles[transactionIndex]);
+}
+
+// Stores a copy of the transaction unless the slot is already taken or all chunks are full
+static bool storeTickTransaction(unsigned int tickOffset, unsigned int transactionIndex, const void* transaction, unsigned int size)
+{
+    ACQUIRE(tickTransactionsLock);
+
+    unsigned int* handles = tickTransactionHandles[tickOffset];
+    if (!handles)
+    {
+        const unsigned int handlesHandle = allocateTickTransactionsSpace(NUMBER_OF_TRANSACTIONS_PER_TICK * sizeof(unsigned int));
+        if (!handlesHandle)
+        {
+            RELEASE(tickTransactionsLock);
+
+            return false;
+        }
+        handles = (unsigned int*)tickTransactionsData(handlesHandle);
+        setMem(handles, NUMBER_OF_TRANSACTIONS_PER_TICK * sizeof(unsigned int), 0);
+        _mm_sfence();
+        tickTransactionHandles[tickOffset] = handles;
+    }
+
+    bool stored = false;
+    if (!handles[transactionIndex])
+    {
+        const unsigned int handle = allocateTickTransactionsSpace(size);
+        if (handle)
+        {
+            copyMem(tickTransactionsData(handle), transaction, size);
+            _mm_sfence();
+            handles[transactionIndex] = handle;
+            stored = true;
+        }
+    }
+
+    RELEASE(tickTransactionsLock);
+
+    return stored;
+}
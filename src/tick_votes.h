@@ -0,0 +1,162 @@
+#pragma once
+
+#include "platform/m256.h"
+#include "platform/concurrency.h"
+#include "platform/memory.h"
+
+#include "network/common_def.h"
+
+// Votes of the computors for the transaction digest of a tick and for the expected transaction digest of the next tick, updated
+// once per computor when its tick is stored so that the tick processor knows the quorum state without rescanning the ticks.
+// Distinct digests are referred to by the computor that voted for them first, the digests themselves stay in the ticks (accessed
+// through ComputorTicks with the members transactionDigest(computorIndex) and expectedNextTickTransactionDigest(computorIndex)).
+struct TickVoteTally
+{
+    unsigned short numberOfDigests;
+    unsigned short mostPopularDigest;
+    unsigned short numberOfEmptyDigestVotes;
+    unsigned short digestVoters[NUMBER_OF_COMPUTORS];
+    unsigned short digestVotes[NUMBER_OF_COMPUTORS];
+};
+
+struct TickVotes
+{
+    unsigned short epoch; // The votes of other epochs do not count
+    unsigned short numberOfVotes;
+    TickVoteTally transactionDigests;
+    TickVoteTally expectedNextTickTransactionDigests;
+};
+
+struct TickVoteQuorum
+{
+    m256i mostPopularDigest;
+    unsigned int numberOfVotes;
+    unsigned int mostPopularDigestVotes;
+    unsigned int numberOfEmptyDigestVotes;
+};
+
+static volatile char tickVotesLock = 0;
+static TickVotes* tickVotes = NULL;
+
+// numberOfTicks is the number of ticks of an epoch
+static bool initTickVotes(unsigned int numberOfTicks)
+{
+    if (!allocatePool(numberOfTicks * sizeof(TickVotes), (void**)&tickVotes))
+    {
+        return false;
+    }
+    setMem(tickVotes, numberOfTicks * sizeof(TickVotes), 0);
+
+    return true;
+}
+
+static void deinitTickVotes()
+{
+    if (tickVotes)
+    {
+        freePool(tickVotes);
+        tickVotes = NULL;
+    }
+}
+
+template <typename ComputorTicks>
+static void addTickVote(TickVoteTally& tally, const ComputorTicks& computorTicks, unsigned int computorIndex, const m256i& (ComputorTicks::*digest)(unsigned int) const)
+{
+    const m256i& vote = (computorTicks.*digest)(computorIndex);
+    if (isZero(vote))
+    {
+        tally.numberOfEmptyDigestVotes++;
+    }
+
+    unsigned int i;
+    for (i = 0; i < tally.numberOfDigests; i++)
+    {
+        if ((computorTicks.*digest)(tally.digestVoters[i]) == vote)
+        {
+            break;
+        }
+    }
+    if (i == tally.numberOfDigests)
+    {
+        tally.digestVoters[i] = computorIndex;
+        tally.digestVotes[i] = 0;
+        tally.numberOfDigests++;
+    }
+    if (++tally.digestVotes[i] > tally.digestVotes[tally.mostPopularDigest])
+    {
+        tally.mostPopularDigest = i;
+    }
+}
+
+// computorTicks are the ticks of all computors for the tick, call once after the tick of computorIndex has been stored
+template <typename ComputorTicks>
+static void addTickVotes(unsigned int tickOffset, unsigned short epoch, const ComputorTicks& computorTicks, unsigned int computorIndex)
+{
+    ACQUIRE(tickVotesLock);
+
+    TickVotes& votes = tickVotes[tickOffset];
+    if (votes.epoch != epoch)
+    {
+        votes.numberOfVotes = 0;
+        votes.transactionDigests.numberOfDigests = 0;
+        votes.transactionDigests.mostPopularDigest = 0;
+        votes.transactionDigests.numberOfEmptyDigestVotes = 0;
+        votes.expectedNextTickTransactionDigests.numberOfDigests = 0;
+        votes.expectedNextTickTransactionDigests.mostPopularDigest = 0;
+        votes.expectedNextTickTransactionDigests.numberOfEmptyDigestVotes = 0;
+        votes.epoch = epoch;
+    }
+    votes.numberOfVotes++;
+    addTickVote(votes.transactionDigests, computorTicks, computorIndex, &ComputorTicks::transactionDigest);
+    addTickVote(votes.expectedNextTickTransactionDigests, computorTicks, computorIndex, &ComputorTicks::expectedNextTickTransactionDigest);
+
+    RELEASE(tickVotesLock);
+}
+
+// Returns the number of computors whose tick has been stored
+static unsigned int numberOfTickVotes(unsigned int tickOffset, unsigned short epoch)
+{
+    ACQUIRE(tickVotesLock);
+    const unsigned int numberOfVotes = tickVotes[tickOffset].epoch == epoch ? tickVotes[tickOffset].numberOfVotes : 0;
+    RELEASE(tickVotesLock);
+
+    return numberOfVotes;
+}
+
+template <typename ComputorTicks>
+static void getTickVoteQuorum(const TickVotes& votes, const TickVoteTally& tally, const ComputorTicks& computorTicks, const m256i& (ComputorTicks::*digest)(unsigned int) const, TickVoteQuorum& quorum)
+{
+    quorum.numberOfVotes = votes.numberOfVotes;
+    if (tally.numberOfDigests)
+    {
+        quorum.mostPopularDigest = (computorTicks.*digest)(tally.digestVoters[tally.mostPopularDigest]);
+        quorum.mostPopularDigestVotes = tally.digestVotes[tally.mostPopularDigest];
+    }
+    else
+    {
+        quorum.mostPopularDigest = _mm256_setzero_si256();
+        quorum.mostPopularDigestVotes = 0;
+    }
+    quorum.numberOfEmptyDigestVotes = tally.numberOfEmptyDigestVotes;
+}
+
+// Consistent snapshot of the quorum state of both digests of the tick, computorTicks are the ticks of all computors for the tick
+template <typename ComputorTicks>
+static void getTickVoteQuorums(unsigned int tickOffset, unsigned short epoch, const ComputorTicks& computorTicks, TickVoteQuorum& transactionDigestQuorum, TickVoteQuorum& expectedNextTickTransactionDigestQuorum)
+{
+    ACQUIRE(tickVotesLock);
+
+    const TickVotes& votes = tickVotes[tickOffset];
+    if (votes.epoch == epoch)
+    {
+        getTickVoteQuorum(votes, votes.transactionDigests, computorTicks, &ComputorTicks::transactionDigest, transactionDigestQuorum);
+        getTickVoteQuorum(votes, votes.expectedNextTickTransactionDigests, computorTicks, &ComputorTicks::expectedNextTickTransactionDigest, expectedNextTickTransactionDigestQuorum);
+    }
+    else
+    {
+        setMem(&transactionDigestQuorum, sizeof(TickVoteQuorum), 0);
+        setMem(&expectedNextTickTransactionDigestQuorum, sizeof(TickVoteQuorum), 0);
+    }
+
+    RELEASE(tickVotesLock);
+}
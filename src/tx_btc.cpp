@@ -18,11 +18,23 @@
 #include "platform/time.h"
 #include "platform/file_io.h"
 #include "platform/time_stamp_counter.h"
+#include "platform/cpu_features.h"
 
 #include "text_output.h"
 
 #include "kangaroo_twelve.h"
 #include "four_q.h"
+#include "public_key_cache.h"
+#include "shared_key_cache.h"
+#include "tick_transaction_index.h"
+#include "pending_transactions.h"
+#include "tick_transaction_storage.h"
+#include "tick_storage.h"
+#include "tick_votes.h"
+#include "tick_phase_latencies.h"
+#include "ipo_order_book.h"
+#include "parallel_for.h"
+#include "state_sync.h"
 #include "score.h"
 
 #include "network.h"
@@ -40,7 +52,6 @@
 #define CONTRACT_STATES_DEPTH 10 // Is derived from MAX_NUMBER_OF_CONTRACTS (=N)
 #define TARGET_TICK_DURATION 3000
 #define TICK_REQUESTING_PERIOD 500ULL
-#define FIRST_TICK_TRANSACTION_OFFSET sizeof(unsigned long long)
 #define ISSUANCE_RATE 1000000000000LL
 #define MAX_AMOUNT (ISSUANCE_RATE * 1000ULL)
 #define MAX_INPUT_SIZE 1024ULL
@@ -58,13 +69,13 @@
 #define PORT 21841
 #define QUORUM (NUMBER_OF_COMPUTORS * 2 / 3 + 1)
 #define SIGNATURE_SIZE 64
+#define SOLUTION_BUFFER_RELEASING_PERIOD 60000ULL
 #define SPECTRUM_CAPACITY 0x1000000ULL // Must be 2^N
 #define SPECTRUM_DEPTH 24 // Is derived from SPECTRUM_CAPACITY (=N)
 #define SYSTEM_DATA_SAVING_PERIOD 300000ULL
 #define TICK_TRANSACTIONS_PUBLICATION_OFFSET 2 // Must be only 2
 #define MIN_MINING_SOLUTIONS_PUBLICATION_OFFSET 3 // Must be 3+
 #define TIME_ACCURACY 60000
-#define TRANSACTION_SPARSENESS 7
 
 
 
@@ -277,6 +288,7 @@ typedef struct
 } Transaction;
 
 static_assert(sizeof(Transaction) == 32 + 32 + 8 + 4 + 2 + 2, "Something is wrong with the struct size.");
+static_assert(MAX_TRANSACTION_SIZE <= PENDING_TRANSACTION_BLOCK_SIZE * NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES, "Pending transactions pool cannot hold the largest transactions.");
 
 
 struct ContractIPOBid
@@ -463,18 +475,28 @@ static unsigned short numberOfOwnComputorIndices = 0;
 static unsigned short ownComputorIndices[sizeof(computorSeeds) / sizeof(computorSeeds[0])];
 static unsigned short ownComputorIndicesMapping[sizeof(computorSeeds) / sizeof(computorSeeds[0])];
 
-static Tick* ticks = NULL;
 static TickData* tickData = NULL;
+static TickTransactionIndex* tickTransactionDigestIndices = NULL; // Built from tickData when it is stored, protected by tickDataLock
 static volatile char tickDataLock = 0;
 static Tick etalonTick;
 static TickData nextTickData;
-static volatile char tickTransactionsLock = 0;
-static unsigned char* tickTransactions = NULL;
-static unsigned long long tickTransactionOffsets[MAX_NUMBER_OF_TICKS_PER_EPOCH][NUMBER_OF_TRANSACTIONS_PER_TICK];
-static unsigned long long nextTickTransactionOffset = FIRST_TICK_TRANSACTION_OFFSET;
+static TickTransactionIndex nextTickTransactionIndex;
 
-static m256i uniqueNextTickTransactionDigests[NUMBER_OF_COMPUTORS];
-static unsigned int uniqueNextTickTransactionDigestCounters[NUMBER_OF_COMPUTORS];
+static unsigned int tickTransactionSources[NUMBER_OF_TRANSACTIONS_PER_TICK * 2]; // Open-addressed spectrum indices + 1 of the sources executed in the current tick
+
+// Transactions of a tick checked against the digests of its tick data and with their sources resolved to spectrum indices ahead
+// of the execution of the tick, the bits of a transaction are valid while the digest it was checked against is the one in the
+// tick data. The transactions are prepared in parallel, 64 at a time (one word of the bitmaps) by a processor.
+struct PreparedTick
+{
+    unsigned int tick;
+    unsigned int tickOffset;
+    m256i transactionDigests[NUMBER_OF_TRANSACTIONS_PER_TICK];
+    unsigned long long verifiedTransactions[NUMBER_OF_TRANSACTIONS_PER_TICK / 64]; // Stored and matching their digests
+    unsigned long long mismatchingTransactions[NUMBER_OF_TRANSACTIONS_PER_TICK / 64]; // Stored but not matching their digests
+    int sourceIndices[NUMBER_OF_TRANSACTIONS_PER_TICK]; // -1 if the source was not in the spectrum when the transaction was prepared
+};
+static PreparedTick preparedTicks[2]; // Indexed by tick & 1, the executed tick and the one after it
 
 static void* reorgBuffer = NULL;
 
@@ -484,10 +506,6 @@ static volatile char spectrumLock = 0;
 static ::Entity* spectrum = NULL;
 static unsigned int numberOfEntities = 0;
 static unsigned int numberOfTransactions = 0;
-static volatile char entityPendingTransactionsLock = 0;
-static unsigned char* entityPendingTransactions = NULL;
-static unsigned char* entityPendingTransactionDigests = NULL;
-static unsigned int entityPendingTransactionIndices[SPECTRUM_CAPACITY];
 static unsigned long long spectrumChangeFlags[SPECTRUM_CAPACITY / (sizeof(unsigned long long) * 8)];
 static m256i* spectrumDigests = NULL;
 
@@ -507,18 +525,41 @@ static volatile char contractStateCopyLock = 0;
 static char* contractStateCopy = NULL;
 static char contractFunctionInputs[MAX_NUMBER_OF_PROCESSORS][65536];
 static char* contractFunctionOutputs[MAX_NUMBER_OF_PROCESSORS];
+static char* stateSyncResponses[MAX_NUMBER_OF_PROCESSORS];
+static m256i* stateSyncChunkTrees[MAX_NUMBER_OF_PROCESSORS];
+static unsigned char* stateSyncContractState = NULL; // The contract state assembled from the fetched pieces before it is verified
 static char executedContractInput[65536];
 static char executedContractOutput[RequestResponseHeader::max_size + 1];
 
 static volatile char tickLocks[NUMBER_OF_COMPUTORS];
+static volatile unsigned int latestQuorumTick = 0; // Latest tick with a quorum of stored ticks
+static struct
+{
+    unsigned int tick;
+    unsigned short epoch;
+    unsigned long long resourceTestingDigest;
+    m256i tickEssenceDigest;
+    m256i saltedSpectrumDigest;
+    m256i saltedUniverseDigest;
+    m256i saltedComputerDigest;
+} tickVerificationEtalon; // Verifications of earlier generations are outdated once the etalon changes
+static unsigned int tickVerificationGeneration = 1;
+static struct
+{
+    unsigned int generation;
+    unsigned int testFlags;
+    bool matchesEtalon;
+} tickVerifications[NUMBER_OF_COMPUTORS];
+static unsigned short unverifiedTickComputorIndices[NUMBER_OF_COMPUTORS];
+static m256i tickVerificationSaltedData[NUMBER_OF_COMPUTORS * 3][2];
+static m256i tickVerificationSaltedDigests[NUMBER_OF_COMPUTORS * 3];
 static bool targetNextTickDataDigestIsKnown = false;
 static unsigned int testFlags = 0;
 static m256i targetNextTickDataDigest;
 static unsigned long long tickTicks[11];
 
-static m256i releasedPublicKeys[NUMBER_OF_COMPUTORS];
-static long long releasedAmounts[NUMBER_OF_COMPUTORS];
-static unsigned int numberOfReleasedEntities;
+static IPOOrderBook ipoOrderBooks[sizeof(contractDescriptions) / sizeof(contractDescriptions[0])]; // Open while a tick takes bids
+static IPORefunds ipoRefunds;
 
 static EFI_MP_SERVICES_PROTOCOL* mpServicesProtocol;
 static unsigned int numberOfProcessors = 0;
@@ -565,6 +606,18 @@ static struct
     RequestedTickTransactions requestedTickTransactions;
 } requestedTickTransactions;
 
+static struct
+{
+    RequestResponseHeader header;
+    RequestStateDigests requestStateDigests;
+} requestedStateDigests;
+
+static struct
+{
+    RequestResponseHeader header;
+    RequestStateChunk requestStateChunk;
+} requestedStateChunk;
+
 
 
 
@@ -733,11 +786,36 @@ static bool decreaseEnergy(const int index, long long amount)
 static void enableAVX()
 {
     __writecr4(__readcr4() | 0x40000);
-    _xsetbv(_XCR_XFEATURE_ENABLED_MASK, _xgetbv(_XCR_XFEATURE_ENABLED_MASK) | (7
-#ifdef __AVX512F__
-        | 224
-#endif
-        ));
+    _xsetbv(_XCR_XFEATURE_ENABLED_MASK, _xgetbv(_XCR_XFEATURE_ENABLED_MASK) | ((7 | 224) & getSupportedXcr0()));
+}
+
+static void selectKernels()
+{
+    detectCpuFeatures();
+    selectKangarooTwelveKernels();
+    selectFourQKernels();
+    selectScoreKernels();
+
+    setText(message, L"CPU features: AVX2 ");
+    appendText(message, cpuFeatures.avx2 ? L"yes" : L"no");
+    appendText(message, L", AVX-512 ");
+    appendText(message, cpuFeatures.avx512 ? L"yes" : L"no");
+    appendText(message, L", AVX-512 VPOPCNTDQ ");
+    appendText(message, cpuFeatures.avx512Vpopcntdq ? L"yes" : L"no");
+    appendText(message, L", AVX-512 IFMA ");
+    appendText(message, cpuFeatures.avx512Ifma ? L"yes" : L"no");
+    appendText(message, L".");
+    logToConsole(message);
+    setText(message, L"Kernels: Keccak-p[1600,12] ");
+    appendText(message, KeccakP1600_Permute_12rounds == KeccakP1600_Permute_12rounds_AVX512 ? L"AVX-512" : (KeccakP1600_Permute_12rounds == KeccakP1600_Permute_12rounds_AVX2 ? L"AVX2" : L"generic"));
+    appendText(message, KangarooTwelve_Leaves4x ? L" (K12 leaves 4-way AVX2)" : L"");
+    appendText(message, L", FourQ decomposition ");
+    appendText(message, decompose == decompose_AVX512 ? L"AVX-512" : L"generic");
+    appendText(message, ecc_mul_double_tables_8x ? L" (verifyBatch 8-way AVX-512 IFMA)" : L"");
+    appendText(message, L", score popcount ");
+    appendText(message, sumNeuronInput == sumNeuronInput_AVX512 ? L"AVX-512 VPOPCNTDQ" : L"generic");
+    appendText(message, L".");
+    logToConsole(message);
 }
 
 static void getComputerDigest(m256i& digest)
@@ -754,7 +832,7 @@ static void getComputerDigest(m256i& digest)
             }
             else
             {
-                KangarooTwelve(contractStates[digestIndex], (unsigned int)size, &contractStateDigests[digestIndex], 32);
+                KangarooTwelveParallel(contractStates[digestIndex], (unsigned int)size, &contractStateDigests[digestIndex], 32);
             }
         }
     }
@@ -780,6 +858,38 @@ static void getComputerDigest(m256i& digest)
     digest = contractStateDigests[(MAX_NUMBER_OF_CONTRACTS * 2 - 1) - 1];
 }
 
+static_assert((SPECTRUM_CAPACITY >> STATE_SYNC_CHUNK_LEVEL) <= MAX_NUMBER_OF_STATE_SYNC_CHUNKS, "The spectrum has too many chunks to be synced.");
+static_assert((ASSETS_CAPACITY >> STATE_SYNC_CHUNK_LEVEL) <= MAX_NUMBER_OF_STATE_SYNC_CHUNKS, "The universe has too many chunks to be synced.");
+static_assert(MAX_NUMBER_OF_CONTRACTS <= MAX_NUMBER_OF_STATE_SYNC_CHUNKS, "The computer has too many chunks to be synced.");
+
+// Digests of the chunks of a state, the nodes of its Merkle tree at the chunk level
+static m256i* stateSyncChunkDigests(unsigned int state, unsigned int& numberOfChunks)
+{
+    switch (state)
+    {
+    case STATE_SYNC_SPECTRUM:
+    {
+        numberOfChunks = SPECTRUM_CAPACITY >> STATE_SYNC_CHUNK_LEVEL;
+
+        return &spectrumDigests[merkleLevelBeginning(SPECTRUM_CAPACITY, STATE_SYNC_CHUNK_LEVEL)];
+    }
+
+    case STATE_SYNC_UNIVERSE:
+    {
+        numberOfChunks = ASSETS_CAPACITY >> STATE_SYNC_CHUNK_LEVEL;
+
+        return &assetDigests[merkleLevelBeginning(ASSETS_CAPACITY, STATE_SYNC_CHUNK_LEVEL)];
+    }
+
+    default:
+    {
+        numberOfChunks = MAX_NUMBER_OF_CONTRACTS;
+
+        return contractStateDigests;
+    }
+    }
+}
+
 
 static void processExchangePublicPeers(Peer* peer, RequestResponseHeader* header)
 {
@@ -856,7 +966,7 @@ static void processBroadcastMessage(const unsigned long long processorNumber, Re
                         }
                         else
                         {
-                            if (!getSharedKey(computorPrivateKeys[i].m256i_u8, request->sourcePublicKey.m256i_u8, sharedKeyAndGammingNonce))
+                            if (!getCachedSharedKey(i, computorPrivateKeys[i], request->sourcePublicKey, sharedKeyAndGammingNonce))
                             {
                                 ok = false;
                             }
@@ -985,7 +1095,7 @@ static void processBroadcastTick(Peer* peer, RequestResponseHeader* header)
         request->tick.computorIndex ^= BroadcastTick::type;
         KangarooTwelve(&request->tick, sizeof(Tick) - SIGNATURE_SIZE, digest, sizeof(digest));
         request->tick.computorIndex ^= BroadcastTick::type;
-        if (verify(broadcastedComputors.broadcastComputors.computors.publicKeys[request->tick.computorIndex].m256i_u8, digest, request->tick.signature))
+        if (verifyComputorSignature(request->tick.computorIndex, broadcastedComputors.broadcastComputors.computors.publicKeys[request->tick.computorIndex], digest, request->tick.signature))
         {
             if (header->isDejavuZero())
             {
@@ -994,25 +1104,44 @@ static void processBroadcastTick(Peer* peer, RequestResponseHeader* header)
 
             ACQUIRE(tickLocks[request->tick.computorIndex]);
 
-            const unsigned int offset = ((request->tick.tick - system.initialTick) * NUMBER_OF_COMPUTORS) + request->tick.computorIndex;
-            if (ticks[offset].epoch == system.epoch)
+            const unsigned int tickOffset = request->tick.tick - system.initialTick;
+            if (isTickStored(tickOffset, request->tick.computorIndex, system.epoch))
             {
-                if (*((unsigned long long*) & request->tick.millisecond) != *((unsigned long long*) & ticks[offset].millisecond)
-                    || request->tick.prevSpectrumDigest != ticks[offset].prevSpectrumDigest
-                    || request->tick.prevUniverseDigest != ticks[offset].prevUniverseDigest
-                    || request->tick.prevComputerDigest != ticks[offset].prevComputerDigest
-                    || request->tick.saltedSpectrumDigest != ticks[offset].saltedSpectrumDigest
-                    || request->tick.saltedUniverseDigest != ticks[offset].saltedUniverseDigest
-                    || request->tick.saltedComputerDigest != ticks[offset].saltedComputerDigest
-                    || request->tick.transactionDigest != ticks[offset].transactionDigest
-                    || request->tick.expectedNextTickTransactionDigest != ticks[offset].expectedNextTickTransactionDigest)
+                Tick storedTick;
+                getStoredTick(tickOffset, request->tick.computorIndex, storedTick);
+                if (*((unsigned long long*) & request->tick.millisecond) != *((unsigned long long*) & storedTick.millisecond)
+                    || request->tick.prevSpectrumDigest != storedTick.prevSpectrumDigest
+                    || request->tick.prevUniverseDigest != storedTick.prevUniverseDigest
+                    || request->tick.prevComputerDigest != storedTick.prevComputerDigest
+                    || request->tick.saltedSpectrumDigest != storedTick.saltedSpectrumDigest
+                    || request->tick.saltedUniverseDigest != storedTick.saltedUniverseDigest
+                    || request->tick.saltedComputerDigest != storedTick.saltedComputerDigest
+                    || request->tick.transactionDigest != storedTick.transactionDigest
+                    || request->tick.expectedNextTickTransactionDigest != storedTick.expectedNextTickTransactionDigest)
                 {
                     faultyComputorFlags[request->tick.computorIndex >> 6] |= (1ULL << (request->tick.computorIndex & 63));
                 }
             }
             else
             {
-                bs->CopyMem(&ticks[offset], &request->tick, sizeof(Tick));
+                if (storeTick(tickOffset, request->tick))
+                {
+                    addTickVotes(tickOffset, system.epoch, StoredComputorTicks{ tickOffset }, request->tick.computorIndex);
+                    if (request->tick.tick > latestQuorumTick && numberOfTickVotes(tickOffset, system.epoch) >= QUORUM)
+                    {
+                        // Other processors may raise it for other computors of the tick or for later ticks at the same time
+                        long latestTick = latestQuorumTick;
+                        while ((unsigned int)latestTick < request->tick.tick)
+                        {
+                            const long replacedTick = _InterlockedCompareExchange((volatile long*)&latestQuorumTick, request->tick.tick, latestTick);
+                            if (replacedTick == latestTick)
+                            {
+                                break;
+                            }
+                            latestTick = replacedTick;
+                        }
+                    }
+                }
             }
 
             RELEASE(tickLocks[request->tick.computorIndex]);
@@ -1056,7 +1185,7 @@ static void processBroadcastFutureTickData(Peer* peer, RequestResponseHeader* he
             request->tickData.computorIndex ^= BroadcastFutureTickData::type;
             KangarooTwelve(&request->tickData, sizeof(TickData) - SIGNATURE_SIZE, digest, sizeof(digest));
             request->tickData.computorIndex ^= BroadcastFutureTickData::type;
-            if (verify(broadcastedComputors.broadcastComputors.computors.publicKeys[request->tickData.computorIndex].m256i_u8, digest, request->tickData.signature))
+            if (verifyComputorSignature(request->tickData.computorIndex, broadcastedComputors.broadcastComputors.computors.publicKeys[request->tickData.computorIndex], digest, request->tickData.signature))
             {
                 if (header->isDejavuZero())
                 {
@@ -1073,6 +1202,7 @@ static void processBroadcastFutureTickData(Peer* peer, RequestResponseHeader* he
                         if (digest == targetNextTickDataDigest)
                         {
                             bs->CopyMem(&tickData[request->tickData.tick - system.initialTick], &request->tickData, sizeof(TickData));
+                            buildTickTransactionIndex(request->tickData.transactionDigests, tickTransactionDigestIndices[request->tickData.tick - system.initialTick]);
                         }
                     }
                 }
@@ -1100,6 +1230,7 @@ static void processBroadcastFutureTickData(Peer* peer, RequestResponseHeader* he
                     else
                     {
                         bs->CopyMem(&tickData[request->tickData.tick - system.initialTick], &request->tickData, sizeof(TickData));
+                        buildTickTransactionIndex(request->tickData.transactionDigests, tickTransactionDigestIndices[request->tickData.tick - system.initialTick]);
                     }
                 }
                 RELEASE(tickDataLock);
@@ -1110,65 +1241,77 @@ static void processBroadcastFutureTickData(Peer* peer, RequestResponseHeader* he
 
 static void processBroadcastTransaction(Peer* peer, RequestResponseHeader* header)
 {
+    // The checks are ordered by cost: structure and tick range, then the source entity and the tick data of the next tick, then the signature.
+    // Transactions of unknown or empty entities could never be executed, they are dropped (and not relayed) before verifying the signature
+    // unless the tick data of the next tick lists them.
     Transaction* request = header->getPayload<Transaction>();
     if (request->amount >= 0 && request->amount <= MAX_AMOUNT
-        && request->inputSize <= MAX_INPUT_SIZE && request->inputSize == header->size() - sizeof(RequestResponseHeader) - sizeof(Transaction) - SIGNATURE_SIZE)
+        && request->inputSize <= MAX_INPUT_SIZE && request->inputSize == header->size() - sizeof(RequestResponseHeader) - sizeof(Transaction) - SIGNATURE_SIZE
+        && request->tick > system.tick)
     {
         const unsigned int transactionSize = sizeof(Transaction) + request->inputSize + SIGNATURE_SIZE;
-        unsigned char digest[32];
-        KangarooTwelve(request, transactionSize - SIGNATURE_SIZE, digest, sizeof(digest));
-        if (verify(request->sourcePublicKey.m256i_u8, digest, (((const unsigned char*)request) + sizeof(Transaction) + request->inputSize)))
+        const int spectrumIndex = ::spectrumIndex(request->sourcePublicKey);
+        const bool isFunded = spectrumIndex >= 0 && energy(spectrumIndex) > 0;
+
+        // The digest of the whole transaction (including the signature) identifies it in the pending pool and in tick data
+        m256i transactionDigest;
+        bool hasTransactionDigest = false;
+        int tickTransactionIndex = -1;
+        if (request->tick == system.tick + 1)
         {
-            if (header->isDejavuZero())
+            KangarooTwelve(request, transactionSize, &transactionDigest, sizeof(transactionDigest));
+            hasTransactionDigest = true;
+
+            ACQUIRE(tickDataLock);
+            if (request->tick == system.tick + 1
+                && tickData[request->tick - system.initialTick].epoch == system.epoch)
             {
-                enqueueResponse(NULL, header);
+                tickTransactionIndex = findTickTransaction(tickData[request->tick - system.initialTick].transactionDigests, tickTransactionDigestIndices[request->tick - system.initialTick], transactionDigest);
             }
+            RELEASE(tickDataLock);
+        }
 
-            const int spectrumIndex = ::spectrumIndex(request->sourcePublicKey);
-            if (spectrumIndex >= 0)
+        if (isFunded || tickTransactionIndex >= 0)
+        {
+            unsigned char digest[32];
+            KangarooTwelve(request, transactionSize - SIGNATURE_SIZE, digest, sizeof(digest));
+            if (verifySenderSignature(request->sourcePublicKey, digest, (((const unsigned char*)request) + sizeof(Transaction) + request->inputSize)))
             {
-                ACQUIRE(entityPendingTransactionsLock);
-
-                // Pending transactions pool follows the rule: A transaction with a higher tick overwrites previous transaction from the same address.
-                // The second filter is to avoid accident made by users/devs (setting scheduled tick too high) and get locked until end of epoch.
-                // It also makes sense that a node doesn't need to store a transaction that is scheduled on a tick that node will never reach.
-                // Notice: MAX_NUMBER_OF_TICKS_PER_EPOCH is not set globally since every node may have different TARGET_TICK_DURATION time due to memory limitation.
-                if (((Transaction*)&entityPendingTransactions[spectrumIndex * MAX_TRANSACTION_SIZE])->tick < request->tick
-                    && request->tick < system.initialTick + MAX_NUMBER_OF_TICKS_PER_EPOCH)
+                if (header->isDejavuZero())
                 {
-                    bs->CopyMem(&entityPendingTransactions[spectrumIndex * MAX_TRANSACTION_SIZE], request, transactionSize);
-                    KangarooTwelve(request, transactionSize, &entityPendingTransactionDigests[spectrumIndex * 32ULL], 32);
+                    enqueueResponse(NULL, header);
                 }
 
-                RELEASE(entityPendingTransactionsLock);
-            }
-
-            ACQUIRE(tickDataLock);
-            if (request->tick == system.tick + 1
-                && tickData[request->tick - system.initialTick].epoch == system.epoch)
-            {
-                KangarooTwelve(request, transactionSize, digest, sizeof(digest));
-                for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+                if (isFunded)
                 {
-                    if (digest == tickData[request->tick - system.initialTick].transactionDigests[i])
+                    if (!hasTransactionDigest)
                     {
-                        ACQUIRE(tickTransactionsLock);
-                        if (!tickTransactionOffsets[request->tick - system.initialTick][i])
-                        {
-                            if (nextTickTransactionOffset + transactionSize <= FIRST_TICK_TRANSACTION_OFFSET + (((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE / TRANSACTION_SPARSENESS))
-                            {
-                                tickTransactionOffsets[request->tick - system.initialTick][i] = nextTickTransactionOffset;
-                                bs->CopyMem(&tickTransactions[nextTickTransactionOffset], request, transactionSize);
-                                nextTickTransactionOffset += transactionSize;
-                            }
-                        }
-                        RELEASE(tickTransactionsLock);
+                        KangarooTwelve(request, transactionSize, &transactionDigest, sizeof(transactionDigest));
+                    }
 
-                        break;
+                    // Pending transactions pool follows the rule: A transaction with a higher tick overwrites previous transaction from the same address.
+                    // The second filter is to avoid accident made by users/devs (setting scheduled tick too high) and get locked until end of epoch.
+                    // It also makes sense that a node doesn't need to store a transaction that is scheduled on a tick that node will never reach.
+                    // Notice: MAX_NUMBER_OF_TICKS_PER_EPOCH is not set globally since every node may have different TARGET_TICK_DURATION time due to memory limitation.
+                    if (request->tick < system.initialTick + MAX_NUMBER_OF_TICKS_PER_EPOCH)
+                    {
+                        addPendingTransaction(spectrumIndex, request, transactionSize, request->tick, transactionDigest);
+                    }
+                }
+
+                if (tickTransactionIndex >= 0)
+                {
+                    // The tick may have advanced while the signature was verified
+                    ACQUIRE(tickDataLock);
+                    if (request->tick == system.tick + 1
+                        && tickData[request->tick - system.initialTick].epoch == system.epoch
+                        && transactionDigest == tickData[request->tick - system.initialTick].transactionDigests[tickTransactionIndex])
+                    {
+                        storeTickTransaction(request->tick - system.initialTick, tickTransactionIndex, request, transactionSize);
                     }
+                    RELEASE(tickDataLock);
                 }
             }
-            RELEASE(tickDataLock);
         }
     }
 }
@@ -1202,10 +1345,11 @@ static void processRequestQuorumTick(Peer* peer, RequestResponseHeader* header)
 
             if (!(request->quorumTick.voteFlags[computorIndices[index] >> 3] & (1 << (computorIndices[index] & 7))))
             {
-                const unsigned int offset = ((request->quorumTick.tick - system.initialTick) * NUMBER_OF_COMPUTORS) + computorIndices[index];
-                if (ticks[offset].epoch == system.epoch)
+                if (isTickStored(request->quorumTick.tick - system.initialTick, computorIndices[index], system.epoch))
                 {
-                    enqueueResponse(peer, sizeof(Tick), BroadcastTick::type, header->dejavu(), &ticks[offset]);
+                    Tick tick;
+                    getStoredTick(request->quorumTick.tick - system.initialTick, computorIndices[index], tick);
+                    enqueueResponse(peer, sizeof(Tick), BroadcastTick::type, header->dejavu(), &tick);
                 }
             }
 
@@ -1244,10 +1388,10 @@ static void processRequestTickTransactions(Peer* peer, RequestResponseHeader* he
         {
             const unsigned short index = random(numberOfTickTransactions);
 
+            const Transaction* transaction = (const Transaction*)getTickTransaction(request->tick - system.initialTick, tickTransactionIndices[index]);
             if (!(request->transactionFlags[tickTransactionIndices[index] >> 3] & (1 << (tickTransactionIndices[index] & 7)))
-                && tickTransactionOffsets[request->tick - system.initialTick][tickTransactionIndices[index]])
+                && transaction)
             {
-                const Transaction* transaction = (Transaction*)&tickTransactions[tickTransactionOffsets[request->tick - system.initialTick][tickTransactionIndices[index]]];
                 enqueueResponse(peer, sizeof(Transaction) + transaction->inputSize + SIGNATURE_SIZE, BROADCAST_TRANSACTION, header->dejavu(), (void*)transaction);
             }
 
@@ -1283,6 +1427,245 @@ static void processRequestCurrentTickInfo(Peer* peer, RequestResponseHeader* hea
     enqueueResponse(peer, sizeof(currentTickInfo), RESPOND_CURRENT_TICK_INFO, header->dejavu(), &currentTickInfo);
 }
 
+static void processRequestTickPhaseLatencies(Peer* peer, RequestResponseHeader* header)
+{
+    RespondTickPhaseLatencies respondTickPhaseLatencies;
+    getTickPhaseLatencies(respondTickPhaseLatencies, frequency);
+
+    enqueueResponse(peer, sizeof(respondTickPhaseLatencies), RespondTickPhaseLatencies::type, header->dejavu(), &respondTickPhaseLatencies);
+}
+
+// Both state sync responders only copy data that is already there, the digests are the ones kept up to date by the tick processor.
+// A node syncing its own states does not serve them.
+static void processRequestStateDigests(Peer* peer, const unsigned long long processorNumber, RequestResponseHeader* header)
+{
+    RequestStateDigests* request = header->getPayload<RequestStateDigests>();
+    if (request->state < NUMBER_OF_SYNCED_STATES && !stateSync.isActive)
+    {
+        RespondStateDigests* response = (RespondStateDigests*)stateSyncResponses[processorNumber];
+        bs->SetMem(response, sizeof(RespondStateDigests), 0);
+        response->state = request->state;
+        const m256i* chunkDigests = stateSyncChunkDigests(request->state, response->numberOfChunks);
+        volatile char* lock = request->state == STATE_SYNC_SPECTRUM ? &spectrumLock : (request->state == STATE_SYNC_UNIVERSE ? &universeLock : NULL);
+        if (lock)
+        {
+            ACQUIRE(*lock);
+        }
+        response->tick = system.tick;
+        bs->CopyMem(response + 1, (void*)chunkDigests, response->numberOfChunks * sizeof(m256i));
+        if (lock)
+        {
+            RELEASE(*lock);
+        }
+
+        enqueueResponse(peer, sizeof(RespondStateDigests) + response->numberOfChunks * sizeof(m256i), RespondStateDigests::type, header->dejavu(), response);
+    }
+}
+
+static void processRequestStateChunk(Peer* peer, const unsigned long long processorNumber, RequestResponseHeader* header)
+{
+    if (stateSync.isActive)
+    {
+        return;
+    }
+
+    RequestStateChunk* request = header->getPayload<RequestStateChunk>();
+    RespondStateChunk* response = (RespondStateChunk*)stateSyncResponses[processorNumber];
+    bs->SetMem(response, sizeof(RespondStateChunk), 0);
+    response->tick = system.tick;
+    response->state = request->state;
+    response->chunkIndex = request->chunkIndex;
+    response->offset = request->offset;
+    switch (request->state)
+    {
+    case STATE_SYNC_SPECTRUM:
+    {
+        if (request->chunkIndex < (SPECTRUM_CAPACITY >> STATE_SYNC_CHUNK_LEVEL) && !request->offset)
+        {
+            response->size = sizeof(::Entity) << STATE_SYNC_CHUNK_LEVEL;
+            ACQUIRE(spectrumLock);
+            bs->CopyMem(response + 1, &spectrum[((unsigned long long)request->chunkIndex) << STATE_SYNC_CHUNK_LEVEL], response->size);
+            RELEASE(spectrumLock);
+        }
+    }
+    break;
+
+    case STATE_SYNC_UNIVERSE:
+    {
+        if (request->chunkIndex < (ASSETS_CAPACITY >> STATE_SYNC_CHUNK_LEVEL) && !request->offset)
+        {
+            response->size = sizeof(Asset) << STATE_SYNC_CHUNK_LEVEL;
+            ACQUIRE(universeLock);
+            bs->CopyMem(response + 1, &assets[((unsigned long long)request->chunkIndex) << STATE_SYNC_CHUNK_LEVEL], response->size);
+            RELEASE(universeLock);
+        }
+    }
+    break;
+
+    case STATE_SYNC_COMPUTER:
+    {
+        if (request->chunkIndex < sizeof(contractDescriptions) / sizeof(contractDescriptions[0])
+            && request->offset < contractDescriptions[request->chunkIndex].stateSize)
+        {
+            const unsigned long long remainingSize = contractDescriptions[request->chunkIndex].stateSize - request->offset;
+            response->size = remainingSize < STATE_SYNC_CONTRACT_STATE_PIECE_SIZE ? (unsigned int)remainingSize : STATE_SYNC_CONTRACT_STATE_PIECE_SIZE;
+            bs->CopyMem(response + 1, contractStates[request->chunkIndex] + request->offset, response->size);
+        }
+    }
+    break;
+    }
+
+    if (response->size)
+    {
+        enqueueResponse(peer, sizeof(RespondStateChunk) + response->size, RespondStateChunk::type, header->dejavu(), response);
+    }
+}
+
+static void processRespondStateDigests(Peer* peer, RequestResponseHeader* header)
+{
+    RespondStateDigests* response = header->getPayload<RespondStateDigests>();
+    if (stateSync.isActive && response->state < NUMBER_OF_SYNCED_STATES)
+    {
+        unsigned int numberOfChunks;
+        stateSyncChunkDigests(response->state, numberOfChunks);
+        if (response->numberOfChunks == numberOfChunks
+            && header->size() == sizeof(RequestResponseHeader) + sizeof(RespondStateDigests) + numberOfChunks * sizeof(m256i))
+        {
+            setStateSyncChunkDigests(response->state, response->tick, (const m256i*)(response + 1), numberOfChunks);
+        }
+    }
+}
+
+// A fetched chunk replaces the local one as long as their digests differ and it hashes to the chunk digest of the round, chunks that
+// do not are fetched again in the next pass
+static void processRespondStateChunk(Peer* peer, const unsigned long long processorNumber, RequestResponseHeader* header)
+{
+    RespondStateChunk* response = header->getPayload<RespondStateChunk>();
+    if (response->state < NUMBER_OF_SYNCED_STATES
+        && header->size() == sizeof(RequestResponseHeader) + sizeof(RespondStateChunk) + response->size)
+    {
+        unsigned int numberOfChunks;
+        const m256i* localChunkDigests = stateSyncChunkDigests(response->state, numberOfChunks);
+        if (isStateSyncChunkMismatching(response->state, response->chunkIndex, localChunkDigests))
+        {
+            switch (response->state)
+            {
+            case STATE_SYNC_SPECTRUM:
+            {
+                if (!response->offset && response->size == sizeof(::Entity) << STATE_SYNC_CHUNK_LEVEL
+                    && isStateSyncChunkValid(response->state, response->chunkIndex, hashStateSyncChunk(stateSyncChunkTrees[processorNumber], STATE_SYNC_CHUNK_LEVEL, response + 1, sizeof(::Entity))))
+                {
+                    ACQUIRE(spectrumLock);
+                    bs->CopyMem(&spectrum[((unsigned long long)response->chunkIndex) << STATE_SYNC_CHUNK_LEVEL], response + 1, response->size);
+                    storeStateSyncChunkTree(spectrumDigests, SPECTRUM_CAPACITY, STATE_SYNC_CHUNK_LEVEL, response->chunkIndex, stateSyncChunkTrees[processorNumber]);
+                    RELEASE(spectrumLock);
+                }
+            }
+            break;
+
+            case STATE_SYNC_UNIVERSE:
+            {
+                if (!response->offset && response->size == sizeof(Asset) << STATE_SYNC_CHUNK_LEVEL
+                    && isStateSyncChunkValid(response->state, response->chunkIndex, hashStateSyncChunk(stateSyncChunkTrees[processorNumber], STATE_SYNC_CHUNK_LEVEL, response + 1, sizeof(Asset))))
+                {
+                    ACQUIRE(universeLock);
+                    bs->CopyMem(&assets[((unsigned long long)response->chunkIndex) << STATE_SYNC_CHUNK_LEVEL], response + 1, response->size);
+                    storeStateSyncChunkTree(assetDigests, ASSETS_CAPACITY, STATE_SYNC_CHUNK_LEVEL, response->chunkIndex, stateSyncChunkTrees[processorNumber]);
+                    RELEASE(universeLock);
+                }
+            }
+            break;
+
+            case STATE_SYNC_COMPUTER:
+            {
+                if (response->chunkIndex < sizeof(contractDescriptions) / sizeof(contractDescriptions[0]))
+                {
+                    const unsigned long long stateSize = contractDescriptions[response->chunkIndex].stateSize;
+                    if (response->offset < stateSize
+                        && response->size == (stateSize - response->offset < STATE_SYNC_CONTRACT_STATE_PIECE_SIZE ? stateSize - response->offset : STATE_SYNC_CONTRACT_STATE_PIECE_SIZE))
+                    {
+                        // The pieces are assembled aside, the state is hashed once as many bytes as it has have arrived and only
+                        // replaces the local one if it matches its chunk digest
+                        ACQUIRE(stateSyncLock);
+                        if (response->chunkIndex == stateSync.contractIndex)
+                        {
+                            bs->CopyMem(stateSyncContractState + response->offset, response + 1, response->size);
+                            stateSync.receivedContractStateSize += response->size;
+                            if (stateSync.receivedContractStateSize >= stateSize)
+                            {
+                                stateSync.receivedContractStateSize = 0;
+                                m256i contractStateDigest;
+                                KangarooTwelve(stateSyncContractState, (unsigned int)stateSize, &contractStateDigest, 32);
+                                if (isStateSyncChunkValid(response->state, response->chunkIndex, contractStateDigest))
+                                {
+                                    bs->CopyMem(contractStates[response->chunkIndex], stateSyncContractState, stateSize);
+                                    contractStateDigests[response->chunkIndex] = contractStateDigest;
+                                }
+                            }
+                        }
+                        RELEASE(stateSyncLock);
+                    }
+                }
+            }
+            break;
+            }
+        }
+    }
+}
+
+// Requests the chunk digests of the synced state from a peer, or the next mismatching chunks from random peers
+static void requestStateSyncData()
+{
+    const unsigned int state = stateSync.state;
+    if (state >= NUMBER_OF_SYNCED_STATES)
+    {
+        return;
+    }
+
+    if (!stateSync.areChunkDigestsKnown)
+    {
+        requestedStateDigests.header.randomizeDejavu();
+        requestedStateDigests.requestStateDigests.state = state;
+        pushToAny(&requestedStateDigests.header);
+    }
+    else
+    {
+        unsigned int numberOfChunks;
+        const m256i* localChunkDigests = stateSyncChunkDigests(state, numberOfChunks);
+        unsigned int chunkIndices[STATE_SYNC_REQUESTS_PER_PERIOD];
+        // Contract states are assembled one at a time
+        numberOfChunks = nextMismatchingStateSyncChunks(state, localChunkDigests, chunkIndices, state == STATE_SYNC_COMPUTER ? 1 : STATE_SYNC_REQUESTS_PER_PERIOD);
+        for (unsigned int i = 0; i < numberOfChunks; i++)
+        {
+            requestedStateChunk.requestStateChunk.state = state;
+            requestedStateChunk.requestStateChunk.chunkIndex = chunkIndices[i];
+            if (state == STATE_SYNC_COMPUTER)
+            {
+                if (chunkIndices[i] < sizeof(contractDescriptions) / sizeof(contractDescriptions[0]))
+                {
+                    ACQUIRE(stateSyncLock);
+                    stateSync.contractIndex = chunkIndices[i];
+                    stateSync.receivedContractStateSize = 0;
+                    RELEASE(stateSyncLock);
+
+                    for (unsigned long long offset = 0; offset < contractDescriptions[chunkIndices[i]].stateSize; offset += STATE_SYNC_CONTRACT_STATE_PIECE_SIZE)
+                    {
+                        requestedStateChunk.header.randomizeDejavu();
+                        requestedStateChunk.requestStateChunk.offset = (unsigned int)offset;
+                        pushToAny(&requestedStateChunk.header);
+                    }
+                }
+            }
+            else
+            {
+                requestedStateChunk.header.randomizeDejavu();
+                requestedStateChunk.requestStateChunk.offset = 0;
+                pushToAny(&requestedStateChunk.header);
+            }
+        }
+    }
+}
+
 static void processRequestEntity(Peer* peer, RequestResponseHeader* header)
 {
     RespondedEntity respondedEntity;
@@ -1437,6 +1820,109 @@ static void processSpecialCommand(Peer* peer, RequestResponseHeader* header)
     }
 }
 
+// Body of the parallel loop over the words of the bitmaps of a PreparedTick
+static void prepareTickTransactions(void* context, unsigned int wordIndex)
+{
+    PreparedTick& preparedTick = *((PreparedTick*)context);
+    unsigned long long verifiedTransactions = preparedTick.verifiedTransactions[wordIndex];
+    unsigned long long mismatchingTransactions = preparedTick.mismatchingTransactions[wordIndex];
+    for (unsigned int bit = 0; bit < 64; bit++)
+    {
+        const unsigned int transactionIndex = wordIndex * 64 + bit;
+        if (!((verifiedTransactions | mismatchingTransactions) & (1ULL << bit))
+            && !isZero(preparedTick.transactionDigests[transactionIndex]))
+        {
+            const Transaction* transaction = (const Transaction*)getTickTransaction(preparedTick.tickOffset, transactionIndex);
+            if (transaction)
+            {
+                unsigned char digest[32];
+                KangarooTwelve(transaction, sizeof(Transaction) + transaction->inputSize + SIGNATURE_SIZE, digest, sizeof(digest));
+                if (digest == preparedTick.transactionDigests[transactionIndex])
+                {
+                    preparedTick.sourceIndices[transactionIndex] = ::spectrumIndex(transaction->sourcePublicKey);
+                    verifiedTransactions |= (1ULL << bit);
+                }
+                else
+                {
+                    mismatchingTransactions |= (1ULL << bit);
+                }
+            }
+        }
+    }
+    preparedTick.verifiedTransactions[wordIndex] = verifiedTransactions;
+    preparedTick.mismatchingTransactions[wordIndex] = mismatchingTransactions;
+}
+
+// Keeps the bits of the transactions whose digests have not changed if the tick is the same, no loop may run over the PreparedTick
+static PreparedTick& syncPreparedTick(unsigned int tick, const m256i* transactionDigests)
+{
+    PreparedTick& preparedTick = preparedTicks[tick & 1];
+    if (preparedTick.tick != tick)
+    {
+        preparedTick.tick = tick;
+        preparedTick.tickOffset = tick - system.initialTick;
+        bs->CopyMem(preparedTick.transactionDigests, transactionDigests, sizeof(preparedTick.transactionDigests));
+        bs->SetMem(preparedTick.verifiedTransactions, sizeof(preparedTick.verifiedTransactions), 0);
+        bs->SetMem(preparedTick.mismatchingTransactions, sizeof(preparedTick.mismatchingTransactions), 0);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            if (preparedTick.transactionDigests[i] != transactionDigests[i])
+            {
+                preparedTick.transactionDigests[i] = transactionDigests[i];
+                preparedTick.verifiedTransactions[i >> 6] &= ~(1ULL << (i & 63));
+                preparedTick.mismatchingTransactions[i >> 6] &= ~(1ULL << (i & 63));
+            }
+        }
+    }
+
+    return preparedTick;
+}
+
+// Lets idle processors prepare the transactions of the tick while the tick processor is busy, finishParallelFor() ends it
+static void beginTickPreparation(const TickData& tickData)
+{
+    finishParallelFor();
+
+    beginParallelFor(prepareTickTransactions, &syncPreparedTick(tickData.tick, tickData.transactionDigests), NUMBER_OF_TRANSACTIONS_PER_TICK / 64, 1);
+}
+
+// The preparation of the executed tick (in nextTickData) if it was done for the same tick data, otherwise NULL
+static const PreparedTick* executedPreparedTick()
+{
+    const PreparedTick& preparedTick = preparedTicks[system.tick & 1];
+    if (preparedTick.tick != system.tick)
+    {
+        return NULL;
+    }
+    for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+    {
+        if (preparedTick.transactionDigests[i] != nextTickData.transactionDigests[i])
+        {
+            return NULL;
+        }
+    }
+
+    return &preparedTick;
+}
+
+// Spectrum index of the source of a transaction of the executed tick, taken from its preparation if the source was known then
+static int tickTransactionSourceIndex(const PreparedTick* preparedTick, unsigned int transactionIndex, const Transaction* transaction)
+{
+    if (preparedTick)
+    {
+        const int spectrumIndex = preparedTick->sourceIndices[transactionIndex];
+        if (spectrumIndex >= 0 && spectrum[spectrumIndex].publicKey == transaction->sourcePublicKey)
+        {
+            return spectrumIndex;
+        }
+    }
+
+    return ::spectrumIndex(transaction->sourcePublicKey);
+}
+
 static void requestProcessor(void* ProcedureArgument)
 {
     enableAVX();
@@ -1450,7 +1936,12 @@ static void requestProcessor(void* ProcedureArgument)
     {
         if (requestQueueElementTail == requestQueueElementHead)
         {
-            _mm_pause();
+            // Idle request processors hash leaves of large contract states for getComputerDigest() and prepare the next tick
+            if (!helpKangarooTwelveParallel()
+                && !helpParallelFor())
+            {
+                _mm_pause();
+            }
         }
         else
         {
@@ -1548,6 +2039,36 @@ static void requestProcessor(void* ProcedureArgument)
                 }
                 break;
 
+                case RequestTickPhaseLatencies::type:
+                {
+                    processRequestTickPhaseLatencies(peer, header);
+                }
+                break;
+
+                case RequestStateDigests::type:
+                {
+                    processRequestStateDigests(peer, processorNumber, header);
+                }
+                break;
+
+                case RespondStateDigests::type:
+                {
+                    processRespondStateDigests(peer, header);
+                }
+                break;
+
+                case RequestStateChunk::type:
+                {
+                    processRequestStateChunk(peer, processorNumber, header);
+                }
+                break;
+
+                case RespondStateChunk::type:
+                {
+                    processRespondStateChunk(peer, processorNumber, header);
+                }
+                break;
+
                 case REQUEST_ENTITY:
                 {
                     processRequestEntity(peer, header);
@@ -2064,6 +2585,24 @@ static void contractProcessor(void*)
     }
 }
 
+// Returns false if the source already has a transaction executed in the current tick
+static bool markTickTransactionSource(unsigned int spectrumIndex)
+{
+    for (unsigned int slot = ((spectrumIndex * 0x9E3779B9) >> 16) & (NUMBER_OF_TRANSACTIONS_PER_TICK * 2 - 1); ; slot = (slot + 1) & (NUMBER_OF_TRANSACTIONS_PER_TICK * 2 - 1))
+    {
+        if (!tickTransactionSources[slot])
+        {
+            tickTransactionSources[slot] = spectrumIndex + 1;
+
+            return true;
+        }
+        if (tickTransactionSources[slot] == spectrumIndex + 1)
+        {
+            return false;
+        }
+    }
+}
+
 static void processTick(unsigned long long processorNumber)
 {
     if (tickPhase < 1)
@@ -2071,12 +2610,19 @@ static void processTick(unsigned long long processorNumber)
         tickPhase = 1;
     }
 
+    unsigned long long tickPhaseSpans[NUMBER_OF_TICK_PHASES];
+    bs->SetMem(tickPhaseSpans, sizeof(tickPhaseSpans), 0);
+
 #if !IGNORE_RESOURCE_TESTING
     etalonTick.prevResourceTestingDigest = resourceTestingDigest;
 #endif
     etalonTick.prevSpectrumDigest = spectrumDigests[(SPECTRUM_CAPACITY * 2 - 1) - 1];
+    unsigned long long phaseBeginningTick = __rdtsc();
     getUniverseDigest(etalonTick.prevUniverseDigest);
+    tickPhaseSpans[TICK_PHASE_UNIVERSE_DIGEST] += __rdtsc() - phaseBeginningTick;
+    phaseBeginningTick = __rdtsc();
     getComputerDigest(etalonTick.prevComputerDigest);
+    tickPhaseSpans[TICK_PHASE_COMPUTER_DIGEST] += __rdtsc() - phaseBeginningTick;
 
     if (system.tick == system.initialTick)
     {
@@ -2095,32 +2641,81 @@ static void processTick(unsigned long long processorNumber)
         }
     }
 
+    phaseBeginningTick = __rdtsc();
     contractProcessorPhase = BEGIN_TICK;
     contractProcessorState = 1;
     while (contractProcessorState)
     {
         _mm_pause();
     }
+    tickPhaseSpans[TICK_PHASE_BEGIN_TICK] = __rdtsc() - phaseBeginningTick;
 
     ACQUIRE(tickDataLock);
     bs->CopyMem(&nextTickData, &tickData[system.tick - system.initialTick], sizeof(TickData));
     RELEASE(tickDataLock);
     if (nextTickData.epoch == system.epoch)
     {
-        bs->SetMem(entityPendingTransactionIndices, sizeof(entityPendingTransactionIndices), 0);
+        // All transactions of the tick have been checked against its digests unless the tick data has been replaced since then
+        const PreparedTick* preparedTick = executedPreparedTick();
+
+#if USE_SCORE_CACHE && !IGNORE_RESOURCE_TESTING
+        // Score the new solutions of the tick in interleaved batches, the sequential pass below gets them from the score cache
+        {
+            phaseBeginningTick = __rdtsc();
+            m256i solutionPublicKeys[MAX_SCORE_BATCH_SIZE], solutionNonces[MAX_SCORE_BATCH_SIZE];
+            unsigned int solutionScores[MAX_SCORE_BATCH_SIZE];
+            unsigned int numberOfSolutions = 0;
+            for (unsigned int transactionIndex = 0; transactionIndex < NUMBER_OF_TRANSACTIONS_PER_TICK; transactionIndex++)
+            {
+                const Transaction* transaction = (const Transaction*)getTickTransaction(system.tick - system.initialTick, transactionIndex);
+                if ((preparedTick ? (preparedTick->verifiedTransactions[transactionIndex >> 6] & (1ULL << (transactionIndex & 63))) : !isZero(nextTickData.transactionDigests[transactionIndex]))
+                    && transaction)
+                {
+                    if (transaction->destinationPublicKey == arbitratorPublicKey
+                        && !transaction->amount
+                        && transaction->inputSize == 32
+                        && !transaction->inputType
+                        && tickTransactionSourceIndex(preparedTick, transactionIndex, transaction) >= 0)
+                    {
+                        m256i data[2] = { transaction->sourcePublicKey, *(m256i*)((unsigned char*)transaction + sizeof(Transaction)) };
+                        unsigned int flagIndex;
+                        KangarooTwelve(data, sizeof(data), &flagIndex, sizeof(flagIndex));
+                        if (!(minerSolutionFlags[flagIndex >> 6] & (1ULL << (flagIndex & 63))))
+                        {
+                            solutionPublicKeys[numberOfSolutions] = data[0];
+                            solutionNonces[numberOfSolutions] = data[1];
+                            if (++numberOfSolutions == MAX_SCORE_BATCH_SIZE)
+                            {
+                                ::score.scoreBatch(processorNumber, solutionPublicKeys, solutionNonces, numberOfSolutions, solutionScores);
+                                numberOfSolutions = 0;
+                            }
+                        }
+                    }
+                }
+            }
+            if (numberOfSolutions)
+            {
+                ::score.scoreBatch(processorNumber, solutionPublicKeys, solutionNonces, numberOfSolutions, solutionScores);
+            }
+            tickPhaseSpans[TICK_PHASE_SOLUTIONS] += __rdtsc() - phaseBeginningTick;
+        }
+#endif
+
+        // IPO bids and solutions are timed on their own and taken out of the span of the transactions
+        const unsigned long long transactionsBeginningTick = __rdtsc();
+        const unsigned long long solutionsSpanBeforeTransactions = tickPhaseSpans[TICK_PHASE_SOLUTIONS];
+        bs->SetMem(tickTransactionSources, sizeof(tickTransactionSources), 0);
         for (unsigned int transactionIndex = 0; transactionIndex < NUMBER_OF_TRANSACTIONS_PER_TICK; transactionIndex++)
         {
-            if (!isZero(nextTickData.transactionDigests[transactionIndex]))
+            if (preparedTick ? (preparedTick->verifiedTransactions[transactionIndex >> 6] & (1ULL << (transactionIndex & 63))) : !isZero(nextTickData.transactionDigests[transactionIndex]))
             {
-                if (tickTransactionOffsets[system.tick - system.initialTick][transactionIndex])
+                Transaction* transaction = (Transaction*)getTickTransaction(system.tick - system.initialTick, transactionIndex);
+                if (transaction)
                 {
-                    Transaction* transaction = (Transaction*)&tickTransactions[tickTransactionOffsets[system.tick - system.initialTick][transactionIndex]];
-                    const int spectrumIndex = ::spectrumIndex(transaction->sourcePublicKey);
+                    const int spectrumIndex = tickTransactionSourceIndex(preparedTick, transactionIndex, transaction);
                     if (spectrumIndex >= 0
-                        && !entityPendingTransactionIndices[spectrumIndex])
+                        && markTickTransactionSource(spectrumIndex))
                     {
-                        entityPendingTransactionIndices[spectrumIndex] = 1;
-
                         numberOfTransactions++;
                         if (decreaseEnergy(spectrumIndex, transaction->amount))
                         {
@@ -2148,6 +2743,7 @@ static void processTick(unsigned long long processorNumber)
                                 {
                                     if (system.epoch < contractDescriptions[executedContractIndex].constructionEpoch)
                                     {
+                                        const unsigned long long ipoBidBeginningTick = __rdtsc();
                                         if (!transaction->amount
                                             && transaction->inputSize == sizeof(ContractIPOBid))
                                         {
@@ -2161,76 +2757,37 @@ static void processTick(unsigned long long processorNumber)
                                                     const QuTransfer quTransfer = { transaction->sourcePublicKey , _mm256_setzero_si256() , amount };
                                                     logQuTransfer(quTransfer);
 
-                                                    numberOfReleasedEntities = 0;
-                                                    IPO* ipo = (IPO*)contractStates[executedContractIndex];
+                                                    IPOOrderBook& orderBook = ipoOrderBooks[executedContractIndex];
+                                                    if (!orderBook.isOpen)
+                                                    {
+                                                        openIPOOrderBook(orderBook, *((IPO*)contractStates[executedContractIndex]));
+                                                    }
                                                     for (unsigned int i = 0; i < contractIPOBid->quantity; i++)
                                                     {
-                                                        if (contractIPOBid->price <= ipo->prices[NUMBER_OF_COMPUTORS - 1])
+                                                        const IPOBid& lowestBid = lowestIPOBid(orderBook);
+                                                        if (contractIPOBid->price <= lowestBid.price)
                                                         {
-                                                            unsigned int j;
-                                                            for (j = 0; j < numberOfReleasedEntities; j++)
-                                                            {
-                                                                if (transaction->sourcePublicKey == releasedPublicKeys[j])
-                                                                {
-                                                                    break;
-                                                                }
-                                                            }
-                                                            if (j == numberOfReleasedEntities)
-                                                            {
-                                                                releasedPublicKeys[numberOfReleasedEntities] = transaction->sourcePublicKey;
-                                                                releasedAmounts[numberOfReleasedEntities++] = contractIPOBid->price;
-                                                            }
-                                                            else
-                                                            {
-                                                                releasedAmounts[j] += contractIPOBid->price;
-                                                            }
+                                                            addIPORefund(ipoRefunds, transaction->sourcePublicKey, contractIPOBid->price);
                                                         }
                                                         else
                                                         {
-                                                            unsigned int j;
-                                                            for (j = 0; j < numberOfReleasedEntities; j++)
-                                                            {
-                                                                if (ipo->publicKeys[NUMBER_OF_COMPUTORS - 1] == releasedPublicKeys[j])
-                                                                {
-                                                                    break;
-                                                                }
-                                                            }
-                                                            if (j == numberOfReleasedEntities)
-                                                            {
-                                                                releasedPublicKeys[numberOfReleasedEntities] = ipo->publicKeys[NUMBER_OF_COMPUTORS - 1];
-                                                                releasedAmounts[numberOfReleasedEntities++] = ipo->prices[NUMBER_OF_COMPUTORS - 1];
-                                                            }
-                                                            else
-                                                            {
-                                                                releasedAmounts[j] += ipo->prices[NUMBER_OF_COMPUTORS - 1];
-                                                            }
-
-                                                            ipo->publicKeys[NUMBER_OF_COMPUTORS - 1] = transaction->sourcePublicKey;
-                                                            ipo->prices[NUMBER_OF_COMPUTORS - 1] = contractIPOBid->price;
-                                                            j = NUMBER_OF_COMPUTORS - 1;
-                                                            while (j
-                                                                && ipo->prices[j - 1] < ipo->prices[j])
-                                                            {
-                                                                const m256i tmpPublicKey = ipo->publicKeys[j - 1];
-                                                                const long long tmpPrice = ipo->prices[j - 1];
-                                                                ipo->publicKeys[j - 1] = ipo->publicKeys[j];
-                                                                ipo->prices[j - 1] = ipo->prices[j];
-                                                                ipo->publicKeys[j] = tmpPublicKey;
-                                                                ipo->prices[j--] = tmpPrice;
-                                                            }
+                                                            addIPORefund(ipoRefunds, lowestBid.publicKey, lowestBid.price);
+                                                            replaceLowestIPOBid(orderBook, transaction->sourcePublicKey, contractIPOBid->price);
 
                                                             contractStateChangeFlags[executedContractIndex >> 6] |= (1ULL << (executedContractIndex & 63));
                                                         }
                                                     }
-                                                    for (unsigned int i = 0; i < numberOfReleasedEntities; i++)
+                                                    for (unsigned int i = 0; i < ipoRefunds.numberOfRefunds; i++)
                                                     {
-                                                        increaseEnergy(releasedPublicKeys[i], releasedAmounts[i]);
-                                                        const QuTransfer quTransfer = { _mm256_setzero_si256() , releasedPublicKeys[i] , releasedAmounts[i] };
+                                                        increaseEnergy(ipoRefunds.publicKeys[i], ipoRefunds.amounts[i]);
+                                                        const QuTransfer quTransfer = { _mm256_setzero_si256() , ipoRefunds.publicKeys[i] , ipoRefunds.amounts[i] };
                                                         logQuTransfer(quTransfer);
                                                     }
+                                                    clearIPORefunds(ipoRefunds);
                                                 }
                                             }
                                         }
+                                        tickPhaseSpans[TICK_PHASE_IPO_BIDS] += __rdtsc() - ipoBidBeginningTick;
                                     }
                                     else
                                     {
@@ -2253,6 +2810,7 @@ static void processTick(unsigned long long processorNumber)
                                 {
                                     if (transaction->destinationPublicKey == arbitratorPublicKey)
                                     {
+                                        const unsigned long long solutionBeginningTick = __rdtsc();
                                         if (!transaction->amount
                                             && transaction->inputSize == 32
                                             && !transaction->inputType)
@@ -2427,6 +2985,7 @@ static void processTick(unsigned long long processorNumber)
                                                 }
                                             }
                                         }
+                                        tickPhaseSpans[TICK_PHASE_SOLUTIONS] += __rdtsc() - solutionBeginningTick;
                                     }
                                 }
                             }
@@ -2442,15 +3001,30 @@ static void processTick(unsigned long long processorNumber)
                 }
             }
         }
+        tickPhaseSpans[TICK_PHASE_TRANSACTIONS] = __rdtsc() - transactionsBeginningTick - tickPhaseSpans[TICK_PHASE_IPO_BIDS] - (tickPhaseSpans[TICK_PHASE_SOLUTIONS] - solutionsSpanBeforeTransactions);
+
+        // The IPO states get the bids of the tick in sorted order before they are hashed
+        phaseBeginningTick = __rdtsc();
+        for (unsigned int contractIndex = 1; contractIndex < sizeof(contractDescriptions) / sizeof(contractDescriptions[0]); contractIndex++)
+        {
+            if (ipoOrderBooks[contractIndex].isOpen)
+            {
+                closeIPOOrderBook(ipoOrderBooks[contractIndex], *((IPO*)contractStates[contractIndex]));
+            }
+        }
+        tickPhaseSpans[TICK_PHASE_IPO_BIDS] += __rdtsc() - phaseBeginningTick;
     }
 
+    phaseBeginningTick = __rdtsc();
     contractProcessorPhase = END_TICK;
     contractProcessorState = 1;
     while (contractProcessorState)
     {
         _mm_pause();
     }
+    tickPhaseSpans[TICK_PHASE_END_TICK] = __rdtsc() - phaseBeginningTick;
 
+    phaseBeginningTick = __rdtsc();
     unsigned int digestIndex;
     for (digestIndex = 0; digestIndex < SPECTRUM_CAPACITY; digestIndex++)
     {
@@ -2478,10 +3052,17 @@ static void processTick(unsigned long long processorNumber)
         numberOfLeafs >>= 1;
     }
     spectrumChangeFlags[0] = 0;
+    tickPhaseSpans[TICK_PHASE_SPECTRUM_DIGEST] = __rdtsc() - phaseBeginningTick;
 
     etalonTick.saltedSpectrumDigest = spectrumDigests[(SPECTRUM_CAPACITY * 2 - 1) - 1];
+    phaseBeginningTick = __rdtsc();
     getUniverseDigest(etalonTick.saltedUniverseDigest);
+    tickPhaseSpans[TICK_PHASE_UNIVERSE_DIGEST] += __rdtsc() - phaseBeginningTick;
+    phaseBeginningTick = __rdtsc();
     getComputerDigest(etalonTick.saltedComputerDigest);
+    tickPhaseSpans[TICK_PHASE_COMPUTER_DIGEST] += __rdtsc() - phaseBeginningTick;
+
+    phaseBeginningTick = __rdtsc();
 
     for (unsigned int i = 0; i < numberOfOwnComputorIndices; i++)
     {
@@ -2519,37 +3100,41 @@ static void processTick(unsigned long long processorNumber)
                     timelockPreimage[2] = etalonTick.saltedComputerDigest;
                     KangarooTwelve(timelockPreimage, sizeof(timelockPreimage), &broadcastedFutureTickData.tickData.timelock, sizeof(broadcastedFutureTickData.tickData.timelock));
 
-                    unsigned int numberOfEntityPendingTransactionIndices;
-                    for (numberOfEntityPendingTransactionIndices = 0; numberOfEntityPendingTransactionIndices < SPECTRUM_CAPACITY; numberOfEntityPendingTransactionIndices++)
-                    {
-                        entityPendingTransactionIndices[numberOfEntityPendingTransactionIndices] = numberOfEntityPendingTransactionIndices;
-                    }
-                    unsigned int j = 0;
-                    while (j < NUMBER_OF_TRANSACTIONS_PER_TICK && numberOfEntityPendingTransactionIndices)
+                    // Reservoir sampling picks a uniformly random subset of the pending transactions of the tick if there are too many
+                    const unsigned int publishedTick = system.tick + TICK_TRANSACTIONS_PUBLICATION_OFFSET;
+                    unsigned int selectedPendingTransactions[NUMBER_OF_TRANSACTIONS_PER_TICK];
+                    unsigned int numberOfCandidates = 0;
+                    ACQUIRE(pendingTransactionsLock);
+                    for (unsigned int index = firstPendingTransaction(publishedTick); index != NO_PENDING_TRANSACTION; index = pendingTransactions[index].next)
                     {
-                        const unsigned int index = random(numberOfEntityPendingTransactionIndices);
-
-                        const Transaction* pendingTransaction = ((Transaction*)&entityPendingTransactions[entityPendingTransactionIndices[index] * MAX_TRANSACTION_SIZE]);
-                        if (pendingTransaction->tick == system.tick + TICK_TRANSACTIONS_PUBLICATION_OFFSET)
+                        if (pendingTransactions[index].tick == publishedTick)
                         {
-                            const unsigned int transactionSize = sizeof(Transaction) + pendingTransaction->inputSize + SIGNATURE_SIZE;
-                            if (nextTickTransactionOffset + transactionSize <= FIRST_TICK_TRANSACTION_OFFSET + (((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE / TRANSACTION_SPARSENESS))
+                            if (numberOfCandidates < NUMBER_OF_TRANSACTIONS_PER_TICK)
                             {
-                                ACQUIRE(tickTransactionsLock);
-                                if (nextTickTransactionOffset + transactionSize <= FIRST_TICK_TRANSACTION_OFFSET + (((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE / TRANSACTION_SPARSENESS))
+                                selectedPendingTransactions[numberOfCandidates] = index;
+                            }
+                            else
+                            {
+                                const unsigned int selectionIndex = random(numberOfCandidates + 1);
+                                if (selectionIndex < NUMBER_OF_TRANSACTIONS_PER_TICK)
                                 {
-                                    tickTransactionOffsets[pendingTransaction->tick - system.initialTick][j] = nextTickTransactionOffset;
-                                    bs->CopyMem(&tickTransactions[nextTickTransactionOffset], (void*)pendingTransaction, transactionSize);
-                                    broadcastedFutureTickData.tickData.transactionDigests[j] = &entityPendingTransactionDigests[entityPendingTransactionIndices[index] * 32ULL];
-                                    j++;
-                                    nextTickTransactionOffset += transactionSize;
+                                    selectedPendingTransactions[selectionIndex] = index;
                                 }
-                                RELEASE(tickTransactionsLock);
                             }
+                            numberOfCandidates++;
                         }
-
-                        entityPendingTransactionIndices[index] = entityPendingTransactionIndices[--numberOfEntityPendingTransactionIndices];
                     }
+                    unsigned int j = 0;
+                    for (unsigned int k = 0; k < numberOfCandidates && k < NUMBER_OF_TRANSACTIONS_PER_TICK; k++)
+                    {
+                        const Transaction* pendingTransaction = (const Transaction*)pendingTransactionData(selectedPendingTransactions[k]);
+                        if (storeTickTransaction(pendingTransaction->tick - system.initialTick, j, pendingTransaction, pendingTransactions[selectedPendingTransactions[k]].size))
+                        {
+                            broadcastedFutureTickData.tickData.transactionDigests[j] = pendingTransactions[selectedPendingTransactions[k]].digest;
+                            j++;
+                        }
+                    }
+                    RELEASE(pendingTransactionsLock);
                     for (; j < NUMBER_OF_TRANSACTIONS_PER_TICK; j++)
                     {
                         broadcastedFutureTickData.tickData.transactionDigests[j] = _mm256_setzero_si256();
@@ -2633,6 +3218,9 @@ static void processTick(unsigned long long processorNumber)
             }
         }
     }
+    tickPhaseSpans[TICK_PHASE_TICK_ASSEMBLY] = __rdtsc() - phaseBeginningTick;
+
+    recordTickPhaseLatencies(system.tick, tickPhaseSpans);
 }
 
 static void endEpoch()
@@ -2654,31 +3242,14 @@ static void endEpoch()
             int issuanceIndex, ownershipIndex, possessionIndex;
             if (finalPrice)
             {
-                m256i zero = _mm256_setzero_si256();
-                issueAsset(zero, (char*)contractDescriptions[contractIndex].assetName, 0, CONTRACT_ASSET_UNIT_OF_MEASUREMENT, NUMBER_OF_COMPUTORS, QX_CONTRACT_INDEX, &issuanceIndex, &ownershipIndex, &possessionIndex);
-            }
-            numberOfReleasedEntities = 0;
-            for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
-            {
-                if (ipo->prices[i] > finalPrice)
-                {
-                    unsigned int j;
-                    for (j = 0; j < numberOfReleasedEntities; j++)
-                    {
-                        if (ipo->publicKeys[i] == releasedPublicKeys[j])
-                        {
-                            break;
-                        }
-                    }
-                    if (j == numberOfReleasedEntities)
-                    {
-                        releasedPublicKeys[numberOfReleasedEntities] = ipo->publicKeys[i];
-                        releasedAmounts[numberOfReleasedEntities++] = ipo->prices[i] - finalPrice;
-                    }
-                    else
-                    {
-                        releasedAmounts[j] += (ipo->prices[i] - finalPrice);
-                    }
+                m256i zero = _mm256_setzero_si256();
+                issueAsset(zero, (char*)contractDescriptions[contractIndex].assetName, 0, CONTRACT_ASSET_UNIT_OF_MEASUREMENT, NUMBER_OF_COMPUTORS, QX_CONTRACT_INDEX, &issuanceIndex, &ownershipIndex, &possessionIndex);
+            }
+            for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+            {
+                if (ipo->prices[i] > finalPrice)
+                {
+                    addIPORefund(ipoRefunds, ipo->publicKeys[i], ipo->prices[i] - finalPrice);
                 }
                 if (finalPrice)
                 {
@@ -2686,12 +3257,13 @@ static void endEpoch()
                     transferShareOwnershipAndPossession(ownershipIndex, possessionIndex, ipo->publicKeys[i], 1, &destinationOwnershipIndex, &destinationPossessionIndex, true);
                 }
             }
-            for (unsigned int i = 0; i < numberOfReleasedEntities; i++)
+            for (unsigned int i = 0; i < ipoRefunds.numberOfRefunds; i++)
             {
-                increaseEnergy(releasedPublicKeys[i], releasedAmounts[i]);
-                const QuTransfer quTransfer = { _mm256_setzero_si256() , releasedPublicKeys[i] , releasedAmounts[i] };
+                increaseEnergy(ipoRefunds.publicKeys[i], ipoRefunds.amounts[i]);
+                const QuTransfer quTransfer = { _mm256_setzero_si256() , ipoRefunds.publicKeys[i] , ipoRefunds.amounts[i] };
                 logQuTransfer(quTransfer);
             }
+            clearIPORefunds(ipoRefunds);
 
             contract0State->contractFeeReserves[contractIndex] = finalPrice * NUMBER_OF_COMPUTORS;
         }
@@ -2818,6 +3390,14 @@ static void endEpoch()
 
     assetsEndEpoch(reorgBuffer);
 
+    clearSharedKeyCache();
+
+    reindexPendingTransactions([](const unsigned char* transaction) { return ::spectrumIndex(((const Transaction*)transaction)->sourcePublicKey); });
+    finishParallelFor();
+    preparedTicks[0].tick = 0;
+    preparedTicks[1].tick = 0;
+    resetTickStorage();
+
     system.epoch++;
     system.initialTick = system.tick;
     systemMustBeSaved = true;
@@ -2847,6 +3427,108 @@ static void endEpoch()
     numberOfOwnComputorIndices = 0;
 }
 
+// Looks for a tick around the tick of the sync round whose quorum confirms the synced states as the states before the tick. The tick processing resumes
+// with the verification of the tick before it, which is done with the quorum essence of that tick like the verification of any
+// processed tick.
+static bool adoptStateSyncTick(unsigned int& latestProcessedTick)
+{
+    m256i spectrumDigest, universeDigest, computerDigest;
+    ACQUIRE(spectrumLock);
+    spectrumDigest = updateStateSyncRoot(spectrumDigests, SPECTRUM_CAPACITY, STATE_SYNC_CHUNK_LEVEL);
+    RELEASE(spectrumLock);
+    ACQUIRE(universeLock);
+    universeDigest = updateStateSyncRoot(assetDigests, ASSETS_CAPACITY, STATE_SYNC_CHUNK_LEVEL);
+    RELEASE(universeLock);
+    computerDigest = updateStateSyncRoot(contractStateDigests, MAX_NUMBER_OF_CONTRACTS, 0);
+
+    // The peers have taken their digests before or after the states of their current tick were digested
+    for (unsigned int tick = stateSync.tick + 1; tick > system.tick + 1 && tick >= stateSync.tick; tick--)
+    {
+        const unsigned int essence = quorumTickEssence(tick - system.initialTick, system.epoch, QUORUM);
+        if (!essence
+            || tickEssences[essence].prevSpectrumDigest != spectrumDigest
+            || tickEssences[essence].prevUniverseDigest != universeDigest
+            || tickEssences[essence].prevComputerDigest != computerDigest)
+        {
+            continue;
+        }
+        const unsigned int previousEssence = quorumTickEssence(tick - 1 - system.initialTick, system.epoch, QUORUM);
+        if (!previousEssence)
+        {
+            continue;
+        }
+
+        bool tickDataSuits;
+        ACQUIRE(tickDataLock);
+        TickData& previousTickData = tickData[tick - 1 - system.initialTick];
+        if (isZero(tickEssences[previousEssence].transactionDigest))
+        {
+            previousTickData.epoch = 0;
+            tickDataSuits = true;
+        }
+        else if (previousTickData.epoch != system.epoch)
+        {
+            tickDataSuits = false;
+        }
+        else
+        {
+            m256i transactionDigest;
+            KangarooTwelve(&previousTickData, sizeof(TickData), &transactionDigest, 32);
+            tickDataSuits = (transactionDigest == tickEssences[previousEssence].transactionDigest);
+        }
+        RELEASE(tickDataLock);
+        if (!tickDataSuits)
+        {
+            continue;
+        }
+
+        const StoredTickEssence& previousTickEssence = tickEssences[previousEssence];
+        system.tick = tick - 1;
+        latestProcessedTick = system.tick;
+        resourceTestingDigest = tickEssences[essence].prevResourceTestingDigest;
+        etalonTick.tick = system.tick;
+        *((unsigned long long*) & etalonTick.millisecond) = *((unsigned long long*) & previousTickEssence.millisecond);
+        etalonTick.prevResourceTestingDigest = previousTickEssence.prevResourceTestingDigest;
+        etalonTick.prevSpectrumDigest = previousTickEssence.prevSpectrumDigest;
+        etalonTick.prevUniverseDigest = previousTickEssence.prevUniverseDigest;
+        etalonTick.prevComputerDigest = previousTickEssence.prevComputerDigest;
+        etalonTick.saltedSpectrumDigest = spectrumDigest;
+        etalonTick.saltedUniverseDigest = universeDigest;
+        etalonTick.saltedComputerDigest = computerDigest;
+
+        ACQUIRE(spectrumLock);
+        numberOfEntities = 0;
+        for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
+        {
+            if (spectrum[i].incomingAmount - spectrum[i].outgoingAmount)
+            {
+                numberOfEntities++;
+            }
+        }
+        RELEASE(spectrumLock);
+
+        reindexPendingTransactions([](const unsigned char* transaction) { return ::spectrumIndex(((const Transaction*)transaction)->sourcePublicKey); });
+        removePendingTransactionsBeforeTick(system.tick + 1);
+        preparedTicks[0].tick = 0;
+        preparedTicks[1].tick = 0;
+
+        testFlags = 0;
+        tickPhase = 0;
+        ::tickNumberOfComputors = 0;
+        ::tickTotalNumberOfComputors = 0;
+        targetNextTickDataDigestIsKnown = false;
+        numberOfNextTickTransactions = 0;
+        numberOfKnownNextTickTransactions = 0;
+        tickTicks[sizeof(tickTicks) / sizeof(tickTicks[0]) - 1] = __rdtsc();
+
+        endStateSync();
+
+        return true;
+    }
+
+    return false;
+}
+
 static void tickProcessor(void*)
 {
     enableAVX();
@@ -2855,148 +3537,86 @@ static void tickProcessor(void*)
     mpServicesProtocol->WhoAmI(mpServicesProtocol, &processorNumber);
 
     unsigned int latestProcessedTick = 0;
+    removePendingTransactionsBeforeTick(system.tick + 1);
     while (!shutDownNode)
     {
         const unsigned long long curTimeTick = __rdtsc();
 
-        if (broadcastedComputors.broadcastComputors.computors.epoch == system.epoch)
+        if (stateSync.isActive)
         {
+            // Ticks are not processed while the states are synced
+            if (stateSync.isConverged && latestQuorumTick > stateSync.tick + 1 && !adoptStateSyncTick(latestProcessedTick))
             {
-                const unsigned int baseOffset = (system.tick + 1 - system.initialTick) * NUMBER_OF_COMPUTORS;
-                unsigned int futureTickTotalNumberOfComputors = 0;
-                for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
-                {
-                    if (ticks[baseOffset + i].epoch == system.epoch)
-                    {
-                        futureTickTotalNumberOfComputors++;
-                    }
-                }
-                ::futureTickTotalNumberOfComputors = futureTickTotalNumberOfComputors;
+                repeatStateSyncRound();
             }
+        }
+        else if (latestQuorumTick > system.tick + STATE_SYNC_TICK_LAG)
+        {
+            // Replaying the missed ticks would take longer than fetching the states they lead to
+            finishParallelFor();
+            beginStateSync();
+        }
+        else if (broadcastedComputors.broadcastComputors.computors.epoch == system.epoch)
+        {
+            futureTickTotalNumberOfComputors = numberOfTickVotes(system.tick + 1 - system.initialTick, system.epoch);
 
             if (system.tick - system.initialTick < MAX_NUMBER_OF_TICKS_PER_EPOCH - 1)
             {
                 if (system.tick > latestProcessedTick)
                 {
+                    // The next tick is prepared by idle processors while this one is executed
+                    ACQUIRE(tickDataLock);
+                    if (tickData[system.tick + 1 - system.initialTick].epoch == system.epoch)
+                    {
+                        beginTickPreparation(tickData[system.tick + 1 - system.initialTick]);
+                    }
+                    RELEASE(tickDataLock);
+
                     processTick(processorNumber);
 
                     latestProcessedTick = system.tick;
                 }
 
-                if (futureTickTotalNumberOfComputors > NUMBER_OF_COMPUTORS - QUORUM)
                 {
-                    const unsigned int baseOffset = (system.tick + 1 - system.initialTick) * NUMBER_OF_COMPUTORS;
-                    unsigned int numberOfEmptyNextTickTransactionDigest = 0;
-                    unsigned int numberOfUniqueNextTickTransactionDigests = 0;
-                    for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
-                    {
-                        if (ticks[baseOffset + i].epoch == system.epoch)
-                        {
-                            unsigned int j;
-                            for (j = 0; j < numberOfUniqueNextTickTransactionDigests; j++)
-                            {
-                                if (ticks[baseOffset + i].transactionDigest == uniqueNextTickTransactionDigests[j])
-                                {
-                                    break;
-                                }
-                            }
-                            if (j == numberOfUniqueNextTickTransactionDigests)
-                            {
-                                uniqueNextTickTransactionDigests[numberOfUniqueNextTickTransactionDigests] = ticks[baseOffset + i].transactionDigest;
-                                uniqueNextTickTransactionDigestCounters[numberOfUniqueNextTickTransactionDigests++] = 1;
-                            }
-                            else
-                            {
-                                uniqueNextTickTransactionDigestCounters[j]++;
-                            }
-
-                            if (isZero(ticks[baseOffset + i].transactionDigest))
-                            {
-                                numberOfEmptyNextTickTransactionDigest++;
-                            }
-                        }
-                    }
-                    unsigned int mostPopularUniqueNextTickTransactionDigestIndex = 0, totalUniqueNextTickTransactionDigestCounter = uniqueNextTickTransactionDigestCounters[0];
-                    for (unsigned int i = 1; i < numberOfUniqueNextTickTransactionDigests; i++)
+                    TickVoteQuorum transactionDigestQuorum, expectedNextTickTransactionDigestQuorum;
+                    getTickVoteQuorums(system.tick + 1 - system.initialTick, system.epoch, StoredComputorTicks{ system.tick + 1 - system.initialTick }, transactionDigestQuorum, expectedNextTickTransactionDigestQuorum);
+                    if (transactionDigestQuorum.numberOfVotes > NUMBER_OF_COMPUTORS - QUORUM)
                     {
-                        if (uniqueNextTickTransactionDigestCounters[i] > uniqueNextTickTransactionDigestCounters[mostPopularUniqueNextTickTransactionDigestIndex])
+                        if (transactionDigestQuorum.mostPopularDigestVotes >= QUORUM)
                         {
-                            mostPopularUniqueNextTickTransactionDigestIndex = i;
+                            targetNextTickDataDigest = transactionDigestQuorum.mostPopularDigest;
+                            targetNextTickDataDigestIsKnown = true;
+                            testFlags |= 1024;
                         }
-                        totalUniqueNextTickTransactionDigestCounter += uniqueNextTickTransactionDigestCounters[i];
-                    }
-                    if (uniqueNextTickTransactionDigestCounters[mostPopularUniqueNextTickTransactionDigestIndex] >= QUORUM)
-                    {
-                        targetNextTickDataDigest = uniqueNextTickTransactionDigests[mostPopularUniqueNextTickTransactionDigestIndex];
-                        targetNextTickDataDigestIsKnown = true;
-                        testFlags |= 1024;
-                    }
-                    else
-                    {
-                        if (numberOfEmptyNextTickTransactionDigest > NUMBER_OF_COMPUTORS - QUORUM
-                            || uniqueNextTickTransactionDigestCounters[mostPopularUniqueNextTickTransactionDigestIndex] + (NUMBER_OF_COMPUTORS - totalUniqueNextTickTransactionDigestCounter) < QUORUM)
+                        else
                         {
-                            targetNextTickDataDigest = _mm256_setzero_si256();
-                            targetNextTickDataDigestIsKnown = true;
-                            testFlags |= 2048;
+                            if (transactionDigestQuorum.numberOfEmptyDigestVotes > NUMBER_OF_COMPUTORS - QUORUM
+                                || transactionDigestQuorum.mostPopularDigestVotes + (NUMBER_OF_COMPUTORS - transactionDigestQuorum.numberOfVotes) < QUORUM)
+                            {
+                                targetNextTickDataDigest = _mm256_setzero_si256();
+                                targetNextTickDataDigestIsKnown = true;
+                                testFlags |= 2048;
+                            }
                         }
                     }
                 }
 
                 if (!targetNextTickDataDigestIsKnown)
                 {
-                    const unsigned int baseOffset = (system.tick - system.initialTick) * NUMBER_OF_COMPUTORS;
-                    unsigned int numberOfEmptyNextTickTransactionDigest = 0;
-                    unsigned int numberOfUniqueNextTickTransactionDigests = 0;
-                    for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
-                    {
-                        if (ticks[baseOffset + i].epoch == system.epoch)
-                        {
-                            unsigned int j;
-                            for (j = 0; j < numberOfUniqueNextTickTransactionDigests; j++)
-                            {
-                                if (ticks[baseOffset + i].expectedNextTickTransactionDigest == uniqueNextTickTransactionDigests[j])
-                                {
-                                    break;
-                                }
-                            }
-                            if (j == numberOfUniqueNextTickTransactionDigests)
-                            {
-                                uniqueNextTickTransactionDigests[numberOfUniqueNextTickTransactionDigests] = ticks[baseOffset + i].expectedNextTickTransactionDigest;
-                                uniqueNextTickTransactionDigestCounters[numberOfUniqueNextTickTransactionDigests++] = 1;
-                            }
-                            else
-                            {
-                                uniqueNextTickTransactionDigestCounters[j]++;
-                            }
-
-                            if (isZero(ticks[baseOffset + i].expectedNextTickTransactionDigest))
-                            {
-                                numberOfEmptyNextTickTransactionDigest++;
-                            }
-                        }
-                    }
-                    if (numberOfUniqueNextTickTransactionDigests)
+                    TickVoteQuorum transactionDigestQuorum, expectedNextTickTransactionDigestQuorum;
+                    getTickVoteQuorums(system.tick - system.initialTick, system.epoch, StoredComputorTicks{ system.tick - system.initialTick }, transactionDigestQuorum, expectedNextTickTransactionDigestQuorum);
+                    if (expectedNextTickTransactionDigestQuorum.numberOfVotes)
                     {
-                        unsigned int mostPopularUniqueNextTickTransactionDigestIndex = 0, totalUniqueNextTickTransactionDigestCounter = uniqueNextTickTransactionDigestCounters[0];
-                        for (unsigned int i = 1; i < numberOfUniqueNextTickTransactionDigests; i++)
-                        {
-                            if (uniqueNextTickTransactionDigestCounters[i] > uniqueNextTickTransactionDigestCounters[mostPopularUniqueNextTickTransactionDigestIndex])
-                            {
-                                mostPopularUniqueNextTickTransactionDigestIndex = i;
-                            }
-                            totalUniqueNextTickTransactionDigestCounter += uniqueNextTickTransactionDigestCounters[i];
-                        }
-                        if (uniqueNextTickTransactionDigestCounters[mostPopularUniqueNextTickTransactionDigestIndex] >= QUORUM)
+                        if (expectedNextTickTransactionDigestQuorum.mostPopularDigestVotes >= QUORUM)
                         {
-                            targetNextTickDataDigest = uniqueNextTickTransactionDigests[mostPopularUniqueNextTickTransactionDigestIndex];
+                            targetNextTickDataDigest = expectedNextTickTransactionDigestQuorum.mostPopularDigest;
                             targetNextTickDataDigestIsKnown = true;
                             testFlags |= 4096;
                         }
                         else
                         {
-                            if (numberOfEmptyNextTickTransactionDigest > NUMBER_OF_COMPUTORS - QUORUM
-                                || uniqueNextTickTransactionDigestCounters[mostPopularUniqueNextTickTransactionDigestIndex] + (NUMBER_OF_COMPUTORS - totalUniqueNextTickTransactionDigestCounter) < QUORUM)
+                            if (expectedNextTickTransactionDigestQuorum.numberOfEmptyDigestVotes > NUMBER_OF_COMPUTORS - QUORUM
+                                || expectedNextTickTransactionDigestQuorum.mostPopularDigestVotes + (NUMBER_OF_COMPUTORS - expectedNextTickTransactionDigestQuorum.numberOfVotes) < QUORUM)
                             {
                                 targetNextTickDataDigest = _mm256_setzero_si256();
                                 targetNextTickDataDigestIsKnown = true;
@@ -3008,6 +3628,7 @@ static void tickProcessor(void*)
 
                 ACQUIRE(tickDataLock);
                 bs->CopyMem(&nextTickData, &tickData[system.tick + 1 - system.initialTick], sizeof(TickData));
+                bs->CopyMem(&nextTickTransactionIndex, &tickTransactionDigestIndices[system.tick + 1 - system.initialTick], sizeof(TickTransactionIndex));
                 RELEASE(tickDataLock);
                 if (nextTickData.epoch == system.epoch)
                 {
@@ -3070,21 +3691,8 @@ static void tickProcessor(void*)
                 }
                 if (!tickDataSuits)
                 {
-                    unsigned int tickTotalNumberOfComputors = 0;
-                    const unsigned int baseOffset = (system.tick - system.initialTick) * NUMBER_OF_COMPUTORS;
-                    for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
-                    {
-                        ACQUIRE(tickLocks[i]);
-
-                        if (ticks[baseOffset + i].epoch == system.epoch)
-                        {
-                            tickTotalNumberOfComputors++;
-                        }
-
-                        RELEASE(tickLocks[i]);
-                    }
                     ::tickNumberOfComputors = 0;
-                    ::tickTotalNumberOfComputors = tickTotalNumberOfComputors;
+                    ::tickTotalNumberOfComputors = numberOfTickVotes(system.tick - system.initialTick, system.epoch);
                     if (testFlags & 1) testFlags |= 512;
                 }
                 else
@@ -3101,74 +3709,42 @@ static void tickProcessor(void*)
                     {
                         nextTickTransactionsSemaphore = 1;
                         bs->SetMem(requestedTickTransactions.requestedTickTransactions.transactionFlags, sizeof(requestedTickTransactions.requestedTickTransactions.transactionFlags), 0);
+                        // Idle processors help with the transactions the preparation during the execution of the tick has not covered
+                        finishParallelFor();
+                        PreparedTick& preparedTick = syncPreparedTick(system.tick + 1, nextTickData.transactionDigests);
+                        parallelFor(prepareTickTransactions, &preparedTick, NUMBER_OF_TRANSACTIONS_PER_TICK / 64, 1);
                         unsigned long long unknownTransactions[NUMBER_OF_TRANSACTIONS_PER_TICK / 64];
-                        bs->SetMem(unknownTransactions, sizeof(unknownTransactions), 0);
+                        bs->CopyMem(unknownTransactions, preparedTick.mismatchingTransactions, sizeof(unknownTransactions));
                         for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
                         {
                             if (!isZero(nextTickData.transactionDigests[i]))
                             {
                                 numberOfNextTickTransactions++;
-
-                                ACQUIRE(tickTransactionsLock);
-                                if (tickTransactionOffsets[system.tick + 1 - system.initialTick][i])
-                                {
-                                    const Transaction* transaction = (Transaction*)&tickTransactions[tickTransactionOffsets[system.tick + 1 - system.initialTick][i]];
-                                    unsigned char digest[32];
-                                    KangarooTwelve(transaction, sizeof(Transaction) + transaction->inputSize + SIGNATURE_SIZE, digest, sizeof(digest));
-                                    if (digest == nextTickData.transactionDigests[i])
-                                    {
-                                        numberOfKnownNextTickTransactions++;
-                                    }
-                                    else
-                                    {
-                                        unknownTransactions[i >> 6] |= (1ULL << (i & 63));
-                                    }
-                                }
-                                RELEASE(tickTransactionsLock);
                             }
                         }
+                        for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK / 64; i++)
+                        {
+                            numberOfKnownNextTickTransactions += (unsigned int)__popcnt64(preparedTick.verifiedTransactions[i]);
+                        }
                         if (numberOfKnownNextTickTransactions != numberOfNextTickTransactions)
                         {
                             const unsigned int nextTick = system.tick + 1;
-                            for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
+                            ACQUIRE(pendingTransactionsLock);
+                            for (unsigned int index = firstPendingTransaction(nextTick); index != NO_PENDING_TRANSACTION; index = pendingTransactions[index].next)
                             {
-                                Transaction* pendingTransaction = (Transaction*)&entityPendingTransactions[i * MAX_TRANSACTION_SIZE];
-                                if (pendingTransaction->tick == nextTick)
+                                if (pendingTransactions[index].tick == nextTick)
                                 {
-                                    ACQUIRE(entityPendingTransactionsLock);
-
-                                    for (unsigned int j = 0; j < NUMBER_OF_TRANSACTIONS_PER_TICK; j++)
+                                    const int j = findTickTransaction(nextTickData.transactionDigests, nextTickTransactionIndex, pendingTransactions[index].digest);
+                                    if (j >= 0 && (unknownTransactions[j >> 6] & (1ULL << (j & 63))))
                                     {
-                                        if (unknownTransactions[j >> 6] & (1ULL << (j & 63)))
-                                        {
-                                            if (&entityPendingTransactionDigests[i * 32ULL] == nextTickData.transactionDigests[j])
-                                            {
-                                                unsigned char transactionBuffer[MAX_TRANSACTION_SIZE];
-                                                const unsigned int transactionSize = sizeof(Transaction) + pendingTransaction->inputSize + SIGNATURE_SIZE;
-                                                bs->CopyMem(transactionBuffer, (void*)pendingTransaction, transactionSize);
+                                        storeTickTransaction(nextTick - system.initialTick, j, pendingTransactionData(index), pendingTransactions[index].size);
 
-                                                pendingTransaction = (Transaction*)transactionBuffer;
-                                                ACQUIRE(tickTransactionsLock);
-                                                if (!tickTransactionOffsets[pendingTransaction->tick - system.initialTick][j])
-                                                {
-                                                    if (nextTickTransactionOffset + transactionSize <= FIRST_TICK_TRANSACTION_OFFSET + (((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE / TRANSACTION_SPARSENESS))
-                                                    {
-                                                        tickTransactionOffsets[pendingTransaction->tick - system.initialTick][j] = nextTickTransactionOffset;
-                                                        bs->CopyMem(&tickTransactions[nextTickTransactionOffset], pendingTransaction, transactionSize);
-                                                        nextTickTransactionOffset += transactionSize;
-                                                    }
-                                                }
-                                                RELEASE(tickTransactionsLock);
-
-                                                numberOfKnownNextTickTransactions++;
-                                                unknownTransactions[j >> 6] &= ~(1ULL << (j & 63));
-                                            }
-                                        }
+                                        numberOfKnownNextTickTransactions++;
+                                        unknownTransactions[j >> 6] &= ~(1ULL << (j & 63));
                                     }
-
-                                    RELEASE(entityPendingTransactionsLock);
                                 }
                             }
+                            RELEASE(pendingTransactionsLock);
 
                             for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
                             {
@@ -3274,82 +3850,125 @@ static void tickProcessor(void*)
                         tickEssence.transactionDigest = etalonTick.transactionDigest;
                         KangarooTwelve(&tickEssence, sizeof(TickEssence), &etalonTickEssenceDigest, 32);
 
-                        const unsigned int baseOffset = (system.tick - system.initialTick) * NUMBER_OF_COMPUTORS;
+                        const unsigned int tickOffset = system.tick - system.initialTick;
 
-                        unsigned int tickNumberOfComputors = 0, tickTotalNumberOfComputors = 0;
+                        if (tickVerificationEtalon.tick != system.tick
+                            || tickVerificationEtalon.epoch != system.epoch
+                            || tickVerificationEtalon.resourceTestingDigest != resourceTestingDigest
+                            || tickVerificationEtalon.tickEssenceDigest != etalonTickEssenceDigest
+                            || tickVerificationEtalon.saltedSpectrumDigest != etalonTick.saltedSpectrumDigest
+                            || tickVerificationEtalon.saltedUniverseDigest != etalonTick.saltedUniverseDigest
+                            || tickVerificationEtalon.saltedComputerDigest != etalonTick.saltedComputerDigest)
+                        {
+                            tickVerificationEtalon.tick = system.tick;
+                            tickVerificationEtalon.epoch = system.epoch;
+                            tickVerificationEtalon.resourceTestingDigest = resourceTestingDigest;
+                            tickVerificationEtalon.tickEssenceDigest = etalonTickEssenceDigest;
+                            tickVerificationEtalon.saltedSpectrumDigest = etalonTick.saltedSpectrumDigest;
+                            tickVerificationEtalon.saltedUniverseDigest = etalonTick.saltedUniverseDigest;
+                            tickVerificationEtalon.saltedComputerDigest = etalonTick.saltedComputerDigest;
+                            tickVerificationGeneration++;
+                        }
+
+                        // Ticks are written once, after their lock has been taken once they can be read without it
+                        unsigned int numberOfUnverifiedTicks = 0;
                         for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
                         {
                             ACQUIRE(tickLocks[i]);
-
-                            const Tick* tick = &ticks[baseOffset + i];
-                            if (tick->epoch == system.epoch)
+                            if (isTickStored(tickOffset, i, system.epoch) && tickVerifications[i].generation != tickVerificationGeneration)
                             {
-                                tickTotalNumberOfComputors++;
+                                unverifiedTickComputorIndices[numberOfUnverifiedTicks] = i;
+                                tickVerificationSaltedData[numberOfUnverifiedTicks * 3][0] = broadcastedComputors.broadcastComputors.computors.publicKeys[i];
+                                tickVerificationSaltedData[numberOfUnverifiedTicks * 3][1] = etalonTick.saltedSpectrumDigest;
+                                tickVerificationSaltedData[numberOfUnverifiedTicks * 3 + 1][0] = broadcastedComputors.broadcastComputors.computors.publicKeys[i];
+                                tickVerificationSaltedData[numberOfUnverifiedTicks * 3 + 1][1] = etalonTick.saltedUniverseDigest;
+                                tickVerificationSaltedData[numberOfUnverifiedTicks * 3 + 2][0] = broadcastedComputors.broadcastComputors.computors.publicKeys[i];
+                                tickVerificationSaltedData[numberOfUnverifiedTicks * 3 + 2][1] = etalonTick.saltedComputerDigest;
+                                numberOfUnverifiedTicks++;
+                            }
+                            RELEASE(tickLocks[i]);
+                        }
+                        KangarooTwelve64To32Batch(tickVerificationSaltedData, tickVerificationSaltedDigests, numberOfUnverifiedTicks * 3);
 
-                                m256i saltedData[2];
-                                m256i saltedDigest;
-                                saltedData[0] = broadcastedComputors.broadcastComputors.computors.publicKeys[tick->computorIndex];
+                        // The ticks of honest computors share their stored essence, which is then only hashed once
+                        unsigned int matchingTickEssence = 0;
+                        for (unsigned int i = 0; i < numberOfUnverifiedTicks; i++)
+                        {
+                            const StoredComputorTick* tick = &storedComputorTick(tickOffset, unverifiedTickComputorIndices[i]);
+                            const StoredTickEssence* essence = &tickEssences[tick->essence];
+                            bool matchesEtalon = false;
+                            unsigned int flags = 0;
 #if !IGNORE_RESOURCE_TESTING
-                                saltedData[1].m256i_u64[0] = resourceTestingDigest;
-                                KangarooTwelve(saltedData, 32 + sizeof(resourceTestingDigest), &saltedDigest, sizeof(resourceTestingDigest));
-                                if (tick->saltedResourceTestingDigest == saltedDigest.m256i_u64[0])
+                            m256i saltedData[2];
+                            m256i saltedDigest;
+                            saltedData[0] = broadcastedComputors.broadcastComputors.computors.publicKeys[unverifiedTickComputorIndices[i]];
+                            saltedData[1].m256i_u64[0] = resourceTestingDigest;
+                            KangarooTwelve(saltedData, 32 + sizeof(resourceTestingDigest), &saltedDigest, sizeof(resourceTestingDigest));
+                            if (tick->saltedResourceTestingDigest == saltedDigest.m256i_u64[0])
 #endif
+                            {
+                                if (tick->saltedSpectrumDigest != tickVerificationSaltedDigests[i * 3])
                                 {
-                                    saltedData[1] = etalonTick.saltedSpectrumDigest;
-                                    KangarooTwelve64To32(saltedData, &saltedDigest);
-                                    if (tick->saltedSpectrumDigest == saltedDigest)
+                                    flags = 2;
+                                }
+                                else if (tick->saltedUniverseDigest != tickVerificationSaltedDigests[i * 3 + 1])
+                                {
+                                    flags = 4;
+                                }
+                                else if (tick->saltedComputerDigest != tickVerificationSaltedDigests[i * 3 + 2])
+                                {
+                                    flags = 8;
+                                }
+                                else if (tick->essence == matchingTickEssence)
+                                {
+                                    matchesEtalon = true;
+                                }
+                                else
+                                {
+                                    *((unsigned long long*) & tickEssence.millisecond) = *((unsigned long long*) & essence->millisecond);
+                                    tickEssence.prevSpectrumDigest = essence->prevSpectrumDigest;
+                                    tickEssence.prevUniverseDigest = essence->prevUniverseDigest;
+                                    tickEssence.prevComputerDigest = essence->prevComputerDigest;
+                                    tickEssence.transactionDigest = essence->transactionDigest;
+                                    m256i tickEssenceDigest;
+                                    KangarooTwelve(&tickEssence, sizeof(TickEssence), &tickEssenceDigest, 32);
+                                    if (tickEssenceDigest == etalonTickEssenceDigest)
                                     {
-                                        saltedData[1] = etalonTick.saltedUniverseDigest;
-                                        KangarooTwelve64To32(saltedData, &saltedDigest);
-                                        if (tick->saltedUniverseDigest == saltedDigest)
-                                        {
-                                            saltedData[1] = etalonTick.saltedComputerDigest;
-                                            KangarooTwelve64To32(saltedData, &saltedDigest);
-                                            if (tick->saltedComputerDigest == saltedDigest)
-                                            {
-                                                *((unsigned long long*) & tickEssence.millisecond) = *((unsigned long long*) & tick->millisecond);
-                                                tickEssence.prevSpectrumDigest = tick->prevSpectrumDigest;
-                                                tickEssence.prevUniverseDigest = tick->prevUniverseDigest;
-                                                tickEssence.prevComputerDigest = tick->prevComputerDigest;
-                                                tickEssence.transactionDigest = tick->transactionDigest;
-                                                m256i tickEssenceDigest;
-                                                KangarooTwelve(&tickEssence, sizeof(TickEssence), &tickEssenceDigest, 32);
-                                                if (tickEssenceDigest == etalonTickEssenceDigest)
-                                                {
-                                                    tickNumberOfComputors++;
-                                                }
-                                                else
-                                                {
-                                                    if (*((unsigned long long*) & tick->millisecond) != *((unsigned long long*) & etalonTick.millisecond))
-                                                        testFlags |= 16;
-                                                    if (tick->prevSpectrumDigest != etalonTick.prevSpectrumDigest)
-                                                        testFlags |= 32;
-                                                    if (tick->prevUniverseDigest != etalonTick.prevUniverseDigest)
-                                                        testFlags |= 64;
-                                                    if (tick->prevComputerDigest != etalonTick.prevComputerDigest)
-                                                        testFlags |= 128;
-                                                    if (tick->transactionDigest != etalonTick.transactionDigest)
-                                                        testFlags |= 256;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                testFlags |= 8;
-                                            }
-                                        }
-                                        else
-                                        {
-                                            testFlags |= 4;
-                                        }
+                                        matchesEtalon = true;
+                                        matchingTickEssence = tick->essence;
                                     }
                                     else
                                     {
-                                        testFlags |= 2;
+                                        if (*((unsigned long long*) & essence->millisecond) != *((unsigned long long*) & etalonTick.millisecond))
+                                            flags |= 16;
+                                        if (essence->prevSpectrumDigest != etalonTick.prevSpectrumDigest)
+                                            flags |= 32;
+                                        if (essence->prevUniverseDigest != etalonTick.prevUniverseDigest)
+                                            flags |= 64;
+                                        if (essence->prevComputerDigest != etalonTick.prevComputerDigest)
+                                            flags |= 128;
+                                        if (essence->transactionDigest != etalonTick.transactionDigest)
+                                            flags |= 256;
                                     }
                                 }
                             }
+                            tickVerifications[unverifiedTickComputorIndices[i]].matchesEtalon = matchesEtalon;
+                            tickVerifications[unverifiedTickComputorIndices[i]].testFlags = flags;
+                            tickVerifications[unverifiedTickComputorIndices[i]].generation = tickVerificationGeneration;
+                        }
 
-                            RELEASE(tickLocks[i]);
+                        unsigned int tickNumberOfComputors = 0, tickTotalNumberOfComputors = 0;
+                        for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+                        {
+                            if (tickVerifications[i].generation == tickVerificationGeneration)
+                            {
+                                tickTotalNumberOfComputors++;
+                                if (tickVerifications[i].matchesEtalon)
+                                {
+                                    tickNumberOfComputors++;
+                                }
+                                testFlags |= tickVerifications[i].testFlags;
+                            }
                         }
                         ::tickNumberOfComputors = tickNumberOfComputors;
                         ::tickTotalNumberOfComputors = tickTotalNumberOfComputors;
@@ -3469,6 +4088,8 @@ static void tickProcessor(void*)
 
                                     system.tick++;
 
+                                    removePendingTransactionsBeforeTick(system.tick + 1);
+
                                     testFlags = 0;
 
                                     tickPhase = 0;
@@ -3585,11 +4206,7 @@ static void saveSystem()
 static bool initialize()
 {
     enableAVX();
-
-#ifdef __AVX512F__
-    initAVX512KangarooTwelveConstants();
-    initAVX512FourQConstants();
-#endif
+    selectKernels();
 
     for (unsigned int contractIndex = 0; contractIndex < sizeof(contractDescriptions) / sizeof(contractDescriptions[0]); contractIndex++)
     {
@@ -3601,6 +4218,8 @@ static bool initialize()
     for (unsigned int processorIndex = 0; processorIndex < MAX_NUMBER_OF_PROCESSORS; processorIndex++)
     {
         contractFunctionOutputs[processorIndex] = NULL;
+        stateSyncResponses[processorIndex] = NULL;
+        stateSyncChunkTrees[processorIndex] = NULL;
     }
 
     getPublicKeyFromIdentity((const unsigned char*)OPERATOR, operatorPublicKey.m256i_u8);
@@ -3625,6 +4244,8 @@ static bool initialize()
 
     bs->SetMem((void*)tickLocks, sizeof(tickLocks), 0);
     bs->SetMem(&tickTicks, sizeof(tickTicks), 0);
+    initIPORefunds(ipoRefunds);
+    initTickPhaseLatencies();
 
     bs->SetMem(processors, sizeof(processors), 0);
     bs->SetMem(peers, sizeof(peers), 0);
@@ -3648,34 +4269,49 @@ static bool initialize()
     requestedTickTransactions.header.setSize<sizeof(requestedTickTransactions)>();
     requestedTickTransactions.header.setType(REQUEST_TICK_TRANSACTIONS);
     requestedTickTransactions.requestedTickTransactions.tick = 0;
+    requestedStateDigests.header.setSize<sizeof(requestedStateDigests)>();
+    requestedStateDigests.header.setType(RequestStateDigests::type);
+    requestedStateChunk.header.setSize<sizeof(requestedStateChunk)>();
+    requestedStateChunk.header.setType(RequestStateChunk::type);
+    bs->SetMem(&requestedStateChunk.requestStateChunk, sizeof(requestedStateChunk.requestStateChunk), 0);
 
     if (!initFilesystem())
         return false;
 
     EFI_STATUS status;
     {
-        if (status = bs->AllocatePool(EfiRuntimeServicesData, ((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_COMPUTORS * sizeof(Tick), (void**)&ticks))
+        if (!initTickStorage(MAX_NUMBER_OF_TICKS_PER_EPOCH))
         {
-            logStatusToConsole(L"EFI_BOOT_SERVICES.AllocatePool() fails", status, __LINE__);
+            logToConsole(L"Cannot allocate the tick store!");
+
+            return false;
+        }
+        if (!initTickVotes(MAX_NUMBER_OF_TICKS_PER_EPOCH))
+        {
+            logToConsole(L"Cannot allocate the tick votes!");
 
             return false;
         }
-        bs->SetMem(ticks, ((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_COMPUTORS * sizeof(Tick), 0);
         if ((status = bs->AllocatePool(EfiRuntimeServicesData, ((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * sizeof(TickData), (void**)&tickData))
-            || (status = bs->AllocatePool(EfiRuntimeServicesData, FIRST_TICK_TRANSACTION_OFFSET + (((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE / TRANSACTION_SPARSENESS), (void**)&tickTransactions))
-            || (status = bs->AllocatePool(EfiRuntimeServicesData, SPECTRUM_CAPACITY * MAX_TRANSACTION_SIZE, (void**)&entityPendingTransactions))
-            || (status = bs->AllocatePool(EfiRuntimeServicesData, SPECTRUM_CAPACITY * 32ULL, (void**)&entityPendingTransactionDigests)))
+            || (status = bs->AllocatePool(EfiRuntimeServicesData, ((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * sizeof(TickTransactionIndex), (void**)&tickTransactionDigestIndices)))
         {
             logStatusToConsole(L"EFI_BOOT_SERVICES.AllocatePool() fails", status, __LINE__);
 
             return false;
         }
         bs->SetMem(tickData, ((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * sizeof(TickData), 0);
-        bs->SetMem(tickTransactions, FIRST_TICK_TRANSACTION_OFFSET + (((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE / TRANSACTION_SPARSENESS), 0);
-        bs->SetMem(tickTransactionOffsets, sizeof(tickTransactionOffsets), 0);
-        for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
+        bs->SetMem(tickTransactionDigestIndices, ((unsigned long long)MAX_NUMBER_OF_TICKS_PER_EPOCH) * sizeof(TickTransactionIndex), 0);
+        if (!initTickTransactions(MAX_NUMBER_OF_TICKS_PER_EPOCH))
+        {
+            logToConsole(L"Cannot allocate the tick transactions store!");
+
+            return false;
+        }
+        if (!initPendingTransactions(SPECTRUM_CAPACITY, MAX_NUMBER_OF_TICKS_PER_EPOCH))
         {
-            ((Transaction*)&entityPendingTransactions[i * MAX_TRANSACTION_SIZE])->tick = 0;
+            logToConsole(L"Cannot allocate the pending transactions pool!");
+
+            return false;
         }
 
         if (status = bs->AllocatePool(EfiRuntimeServicesData, SPECTRUM_CAPACITY * sizeof(::Entity) >= ASSETS_CAPACITY * sizeof(Asset) ? SPECTRUM_CAPACITY * sizeof(::Entity) : ASSETS_CAPACITY * sizeof(Asset), (void**)&reorgBuffer))
@@ -3697,6 +4333,12 @@ static bool initialize()
         if (!initAssets())
             return false;
 
+        if (!initPublicKeyCache())
+            return false;
+
+        if (!initSharedKeyCache())
+            return false;
+
         for (unsigned int contractIndex = 0; contractIndex < sizeof(contractDescriptions) / sizeof(contractDescriptions[0]); contractIndex++)
         {
             unsigned long long size = contractDescriptions[contractIndex].stateSize;
@@ -3717,13 +4359,29 @@ static bool initialize()
         bs->SetMem(contractStateChangeFlags, MAX_NUMBER_OF_CONTRACTS / 8, 0xFF);
         for (unsigned int processorIndex = 0; processorIndex < MAX_NUMBER_OF_PROCESSORS; processorIndex++)
         {
-            if (status = bs->AllocatePool(EfiRuntimeServicesData, RequestResponseHeader::max_size - sizeof(RequestResponseHeader), (void**)&contractFunctionOutputs[processorIndex]))
+            if ((status = bs->AllocatePool(EfiRuntimeServicesData, RequestResponseHeader::max_size - sizeof(RequestResponseHeader), (void**)&contractFunctionOutputs[processorIndex]))
+                || (status = bs->AllocatePool(EfiRuntimeServicesData, sizeof(RespondStateChunk) + STATE_SYNC_CONTRACT_STATE_PIECE_SIZE, (void**)&stateSyncResponses[processorIndex]))
+                || (status = bs->AllocatePool(EfiRuntimeServicesData, ((2ULL << STATE_SYNC_CHUNK_LEVEL) - 1) * sizeof(m256i), (void**)&stateSyncChunkTrees[processorIndex])))
             {
                 logStatusToConsole(L"EFI_BOOT_SERVICES.AllocatePool() fails", status, __LINE__);
 
                 return false;
             }
         }
+        unsigned long long maxContractStateSize = 0;
+        for (unsigned int contractIndex = 0; contractIndex < sizeof(contractDescriptions) / sizeof(contractDescriptions[0]); contractIndex++)
+        {
+            if (contractDescriptions[contractIndex].stateSize > maxContractStateSize)
+            {
+                maxContractStateSize = contractDescriptions[contractIndex].stateSize;
+            }
+        }
+        if (status = bs->AllocatePool(EfiRuntimeServicesData, maxContractStateSize, (void**)&stateSyncContractState))
+        {
+            logStatusToConsole(L"EFI_BOOT_SERVICES.AllocatePool() fails", status, __LINE__);
+
+            return false;
+        }
 
         if (!initLogging())
             return false;
@@ -3856,6 +4514,7 @@ static bool initialize()
             logToConsole(message);
         }
 
+        score.initMemory();
         score.loadScoreCache(system.epoch);
         score.initMiningData();
 
@@ -3940,6 +4599,8 @@ static void deinitialize()
         root->Close(root);
     }
 
+    score.freeMemory();
+
     if (spectrumDigests)
     {
         bs->FreePool(spectrumDigests);
@@ -3951,6 +4612,10 @@ static void deinitialize()
 
     deinitAssets();
 
+    deinitPublicKeyCache();
+
+    deinitSharedKeyCache();
+
     if (reorgBuffer)
     {
         bs->FreePool(reorgBuffer);
@@ -3964,6 +4629,18 @@ static void deinitialize()
         {
             bs->FreePool(contractFunctionOutputs[processorIndex]);
         }
+        if (stateSyncResponses[processorIndex])
+        {
+            bs->FreePool(stateSyncResponses[processorIndex]);
+        }
+        if (stateSyncChunkTrees[processorIndex])
+        {
+            bs->FreePool(stateSyncChunkTrees[processorIndex]);
+        }
+    }
+    if (stateSyncContractState)
+    {
+        bs->FreePool(stateSyncContractState);
     }
     if (contractStateCopy)
     {
@@ -3981,26 +4658,18 @@ static void deinitialize()
         }
     }
 
-    if (entityPendingTransactionDigests)
-    {
-        bs->FreePool(entityPendingTransactionDigests);
-    }
-    if (entityPendingTransactions)
-    {
-        bs->FreePool(entityPendingTransactions);
-    }
-    if (tickTransactions)
+    deinitPendingTransactions();
+    deinitTickTransactions();
+    if (tickTransactionDigestIndices)
     {
-        bs->FreePool(tickTransactions);
+        bs->FreePool(tickTransactionDigestIndices);
     }
     if (tickData)
     {
         bs->FreePool(tickData);
     }
-    if (ticks)
-    {
-        bs->FreePool(ticks);
-    }
+    deinitTickVotes();
+    deinitTickStorage();
 
     if (minerSolutionFlags)
     {
@@ -4163,14 +4832,6 @@ static void logInfo()
     }
     logToConsole(message);
 
-    unsigned int numberOfPendingTransactions = 0;
-    for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
-    {
-        if (((Transaction*)&entityPendingTransactions[i * MAX_TRANSACTION_SIZE])->tick > system.tick)
-        {
-            numberOfPendingTransactions++;
-        }
-    }
     if (nextTickTransactionsSemaphore)
     {
         setText(message, L"?");
@@ -4212,8 +4873,21 @@ static void logInfo()
         appendText(message, L".) ");
     }
     appendNumber(message, numberOfPendingTransactions, TRUE);
-    appendText(message, L" pending transactions.");
+    appendText(message, L" pending transactions");
+    if (numberOfRejectedPendingTransactions)
+    {
+        appendText(message, L" (");
+        appendNumber(message, numberOfRejectedPendingTransactions, TRUE);
+        appendText(message, L" rejected for lack of room)");
+    }
+    appendText(message, L".");
     logToConsole(message);
+    if (numberOfUnstoredComputorTicks)
+    {
+        setNumber(message, numberOfUnstoredComputorTicks, TRUE);
+        appendText(message, L" computor ticks could not be stored, their computors have used up their room for tick essences.");
+        logToConsole(message);
+    }
 
     unsigned int filledRequestQueueBufferSize = (requestQueueBufferHead >= requestQueueBufferTail) ? (requestQueueBufferHead - requestQueueBufferTail) : (REQUEST_QUEUE_BUFFER_SIZE - (requestQueueBufferTail - requestQueueBufferHead));
     unsigned int filledResponseQueueBufferSize = (responseQueueBufferHead >= responseQueueBufferTail) ? (responseQueueBufferHead - responseQueueBufferTail) : (RESPONSE_QUEUE_BUFFER_SIZE - (responseQueueBufferTail - responseQueueBufferHead));
@@ -4593,6 +5267,7 @@ EFI_STATUS efi_main(EFI_HANDLE imageHandle, EFI_SYSTEM_TABLE* systemTable)
 
             unsigned long long clockTick = 0, systemDataSavingTick = 0, loggingTick = 0, peerRefreshingTick = 0, tickRequestingTick = 0;
             unsigned int tickRequestingIndicator = 0, futureTickRequestingIndicator = 0;
+            bool tickTransactionsChunksAreExhausted = false;
             while (!shutDownNode)
             {
                 if (criticalSituation == 1)
@@ -4609,6 +5284,14 @@ EFI_STATUS efi_main(EFI_HANDLE imageHandle, EFI_SYSTEM_TABLE* systemTable)
                     updateTime();
                 }
 
+                score.manageSolutionBuffers(curTimeTick, SOLUTION_BUFFER_RELEASING_PERIOD * frequency / 1000);
+
+                if (!manageTickTransactionsChunks() && !tickTransactionsChunksAreExhausted)
+                {
+                    logToConsole(L"Cannot allocate more memory for tick transactions!");
+                    tickTransactionsChunksAreExhausted = true;
+                }
+
                 if (contractProcessorState == 1)
                 {
                     contractProcessorState = 2;
@@ -4712,11 +5395,9 @@ EFI_STATUS efi_main(EFI_HANDLE imageHandle, EFI_SYSTEM_TABLE* systemTable)
                         requestedQuorumTick.header.randomizeDejavu();
                         requestedQuorumTick.requestQuorumTick.quorumTick.tick = system.tick;
                         bs->SetMem(&requestedQuorumTick.requestQuorumTick.quorumTick.voteFlags, sizeof(requestedQuorumTick.requestQuorumTick.quorumTick.voteFlags), 0);
-                        const unsigned int baseOffset = (system.tick - system.initialTick) * NUMBER_OF_COMPUTORS;
                         for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
                         {
-                            const Tick* tick = &ticks[baseOffset + i];
-                            if (tick->epoch == system.epoch)
+                            if (isTickStored(system.tick - system.initialTick, i, system.epoch))
                             {
                                 requestedQuorumTick.requestQuorumTick.quorumTick.voteFlags[i >> 3] |= (1 << (i & 7));
                             }
@@ -4729,11 +5410,9 @@ EFI_STATUS efi_main(EFI_HANDLE imageHandle, EFI_SYSTEM_TABLE* systemTable)
                         requestedQuorumTick.header.randomizeDejavu();
                         requestedQuorumTick.requestQuorumTick.quorumTick.tick = system.tick + 1;
                         bs->SetMem(&requestedQuorumTick.requestQuorumTick.quorumTick.voteFlags, sizeof(requestedQuorumTick.requestQuorumTick.quorumTick.voteFlags), 0);
-                        const unsigned int baseOffset = (system.tick + 1 - system.initialTick) * NUMBER_OF_COMPUTORS;
                         for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
                         {
-                            const Tick* tick = &ticks[baseOffset + i];
-                            if (tick->epoch == system.epoch)
+                            if (isTickStored(system.tick + 1 - system.initialTick, i, system.epoch))
                             {
                                 requestedQuorumTick.requestQuorumTick.quorumTick.voteFlags[i >> 3] |= (1 << (i & 7));
                             }
@@ -4763,6 +5442,11 @@ EFI_STATUS efi_main(EFI_HANDLE imageHandle, EFI_SYSTEM_TABLE* systemTable)
 
                         requestedTickTransactions.requestedTickTransactions.tick = 0;
                     }
+
+                    if (stateSync.isActive)
+                    {
+                        requestStateSyncData();
+                    }
                 }
 
                 const unsigned short responseQueueElementHead = ::responseQueueElementHead;
@@ -4839,6 +5523,24 @@ EFI_STATUS efi_main(EFI_HANDLE imageHandle, EFI_SYSTEM_TABLE* systemTable)
                     }
                     tickerLoopNumerator = 0;
                     tickerLoopDenominator = 0;
+
+                    if (stateSync.isActive)
+                    {
+                        setText(message, L"State sync round ");
+                        appendNumber(message, stateSync.numberOfRounds, TRUE);
+                        appendText(message, L" (tick ");
+                        appendNumber(message, stateSync.tick, TRUE);
+                        appendText(message, L"): state ");
+                        appendNumber(message, stateSync.state, FALSE);
+                        appendText(message, L", chunk ");
+                        appendNumber(message, stateSync.nextChunk, TRUE);
+                        appendText(message, L"/");
+                        appendNumber(message, stateSync.numberOfChunks, TRUE);
+                        appendText(message, L". Latest tick with a quorum = ");
+                        appendNumber(message, latestQuorumTick, TRUE);
+                        appendText(message, L".");
+                        logToConsole(message);
+                    }
                 }
                 else
                 {
@@ -0,0 +1,268 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/platform/m256.h"
+#include "../src/kangaroo_twelve.h"
+#include "../src/four_q.h"
+
+
+static void initFourQTest()
+{
+    detectCpuFeatures();
+    selectKangarooTwelveKernels();
+    selectFourQKernels();
+}
+
+// Signed digests from a set of deterministic seeds, every seventh entry is valid and the others are broken in different ways
+struct SignatureSet
+{
+    static constexpr unsigned int size = 70;
+    unsigned char publicKeys[size][32];
+    unsigned char digests[size][32];
+    unsigned char signatures[size][64];
+    const unsigned char* publicKeyPointers[size];
+    const unsigned char* digestPointers[size];
+    const unsigned char* signaturePointers[size];
+
+    SignatureSet()
+    {
+        for (unsigned int i = 0; i < size; i++)
+        {
+            unsigned char seed[56];
+            for (unsigned int j = 0; j < 55; j++)
+            {
+                seed[j] = 'a' + (i * 7 + j * 13) % 26;
+            }
+            seed[55] = 0;
+            unsigned char subseed[32], privateKey[32];
+            EXPECT_TRUE(getSubseed(seed, subseed));
+            getPrivateKey(subseed, privateKey);
+            getPublicKey(privateKey, publicKeys[i]);
+            KangarooTwelve(seed, 55, digests[i], 32);
+            sign(subseed, publicKeys[i], digests[i], signatures[i]);
+
+            switch (i % 7)
+            {
+            case 1: signatures[i][3] ^= 1; break; // R
+            case 2: signatures[i][40] ^= 4; break; // s
+            case 3: digests[i][0] ^= 1; break;
+            case 4: publicKeys[i][2] ^= 1; break;
+            case 5: signatures[i][63] = 1; break; // s out of range
+            case 6: publicKeys[i][15] |= 0x80; break; // bit 128 of the public key
+            }
+
+            publicKeyPointers[i] = publicKeys[i];
+            digestPointers[i] = digests[i];
+            signaturePointers[i] = signatures[i];
+        }
+    }
+};
+
+TEST(TestCoreFourQ, SignVerify) {
+    initFourQTest();
+    SignatureSet set;
+    for (unsigned int i = 0; i < set.size; i++)
+    {
+        EXPECT_EQ(verify(set.publicKeys[i], set.digests[i], set.signatures[i]), i % 7 == 0);
+    }
+}
+
+TEST(TestCoreFourQ, VerifyBatchMatchesVerify) {
+    initFourQTest();
+    SignatureSet set;
+
+    // Batch sizes below, equal to and above VERIFY_BATCH_SIZE
+    const unsigned int batchSizes[] = { 1, 5, VERIFY_BATCH_SIZE, VERIFY_BATCH_SIZE + 3, set.size };
+    for (unsigned int batchSize : batchSizes)
+    {
+        bool results[set.size];
+        const bool allValid = verifyBatch(set.publicKeyPointers, set.digestPointers, set.signaturePointers, batchSize, results);
+        bool expectedAllValid = true;
+        for (unsigned int i = 0; i < batchSize; i++)
+        {
+            const bool expected = verify(set.publicKeys[i], set.digests[i], set.signatures[i]);
+            EXPECT_EQ(results[i], expected);
+            expectedAllValid &= expected;
+        }
+        EXPECT_EQ(allValid, expectedAllValid);
+    }
+
+    // Only valid signatures
+    const unsigned char* publicKeys[set.size / 7];
+    const unsigned char* digests[set.size / 7];
+    const unsigned char* signatures[set.size / 7];
+    for (unsigned int i = 0; i < set.size / 7; i++)
+    {
+        publicKeys[i] = set.publicKeys[i * 7];
+        digests[i] = set.digests[i * 7];
+        signatures[i] = set.signatures[i * 7];
+    }
+    bool results[set.size / 7];
+    EXPECT_TRUE(verifyBatch(publicKeys, digests, signatures, set.size / 7, results));
+    for (unsigned int i = 0; i < set.size / 7; i++)
+    {
+        EXPECT_TRUE(results[i]);
+    }
+}
+
+TEST(TestCoreFourQ, VerifyWithCachedKeyMatchesVerify) {
+    initFourQTest();
+    SignatureSet set;
+    VerificationKey key;
+    for (unsigned int i = 0; i < set.size; i++)
+    {
+        prepareVerificationKey(set.publicKeys[i], key);
+        EXPECT_EQ(verifyWithCachedKey(key, set.digests[i], set.signatures[i]), verify(set.publicKeys[i], set.digests[i], set.signatures[i]));
+
+        // A prepared key is reused for other messages of the same key
+        const unsigned int j = i - i % 7;
+        EXPECT_EQ(verifyWithCachedKey(key, set.digests[j], set.signatures[j]), verify(set.publicKeys[i], set.digests[j], set.signatures[j]));
+    }
+}
+
+TARGET_AVX512_IFMA static void fp2ArithmeticLockstep(f2elm_t* a, f2elm_t* b, f2elm_t* products, f2elm_t* squares, f2elm_t* differences)
+{
+    unsigned long long aAddresses[8], bAddresses[8];
+    for (unsigned int lane = 0; lane < 8; lane++)
+    {
+        aAddresses[lane] = (unsigned long long)&a[lane];
+        bAddresses[lane] = (unsigned long long)&b[lane];
+    }
+    f2elm_8x_t a8, b8, c8;
+    fp2load1271_8x(_mm512_loadu_si512(aAddresses), a8);
+    fp2load1271_8x(_mm512_loadu_si512(bAddresses), b8);
+
+    fp2mul1271_8x(a8, b8, c8);
+    fp2store1271_8x(c8, 8, products);
+    fp2sqr1271_8x(a8, c8);
+    fp2store1271_8x(c8, 8, squares);
+    fp2sub1271_8x(a8, b8, c8);
+    fp2store1271_8x(c8, 8, differences);
+}
+
+TEST(TestCoreFourQ, LockstepFieldArithmeticMatchesScalar) {
+    initFourQTest();
+    if (!cpuFeatures.avx512Ifma)
+    {
+        GTEST_SKIP() << "AVX-512 IFMA is not supported";
+    }
+
+    // Random elements below 2^127 and the edge cases 0, 1, p-1, p and 2^127-2^64
+    f2elm_t a[8], b[8];
+    unsigned long long x = 0x243F6A8885A308D3;
+    for (unsigned int round = 0; round < 64; round++)
+    {
+        for (unsigned int lane = 0; lane < 8; lane++)
+        {
+            for (unsigned int i = 0; i < 2; i++)
+            {
+                for (unsigned int j = 0; j < 2; j++)
+                {
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    a[lane][i][j] = x;
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    b[lane][i][j] = x;
+                }
+                a[lane][i][1] &= 0x7FFFFFFFFFFFFFFF;
+                b[lane][i][1] &= 0x7FFFFFFFFFFFFFFF;
+            }
+        }
+        if (!round)
+        {
+            const unsigned long long edgeCases[5][2] = { { 0, 0 }, { 1, 0 }, { 0xFFFFFFFFFFFFFFFE, 0x7FFFFFFFFFFFFFFF }, { 0xFFFFFFFFFFFFFFFF, 0x7FFFFFFFFFFFFFFF }, { 0, 0x7FFFFFFFFFFFFFFF } };
+            for (unsigned int lane = 0; lane < 8; lane++)
+            {
+                for (unsigned int i = 0; i < 2; i++)
+                {
+                    a[lane][i][0] = edgeCases[(lane + i) % 5][0];
+                    a[lane][i][1] = edgeCases[(lane + i) % 5][1];
+                    b[lane][i][0] = edgeCases[(lane * 3 + i) % 5][0];
+                    b[lane][i][1] = edgeCases[(lane * 3 + i) % 5][1];
+                }
+            }
+        }
+
+        f2elm_t products[8], squares[8], differences[8];
+        fp2ArithmeticLockstep(a, b, products, squares, differences);
+        for (unsigned int lane = 0; lane < 8; lane++)
+        {
+            f2elm_t expected;
+            fp2mul1271(a[lane], b[lane], expected);
+            mod1271(expected[0]);
+            mod1271(expected[1]);
+            EXPECT_EQ(memcmp(products[lane], expected, sizeof(expected)), 0) << "round " << round << ", lane " << lane;
+            fp2sqr1271(a[lane], expected);
+            mod1271(expected[0]);
+            mod1271(expected[1]);
+            EXPECT_EQ(memcmp(squares[lane], expected, sizeof(expected)), 0) << "round " << round << ", lane " << lane;
+            fp2sub1271(a[lane], b[lane], expected);
+            mod1271(expected[0]);
+            mod1271(expected[1]);
+            EXPECT_EQ(memcmp(differences[lane], expected, sizeof(expected)), 0) << "round " << round << ", lane " << lane;
+        }
+    }
+}
+
+TEST(TestCoreFourQ, LockstepDoubleScalarMultiplicationMatchesScalar) {
+    initFourQTest();
+    if (!ecc_mul_double_tables_8x)
+    {
+        GTEST_SKIP() << "AVX-512 IFMA is not supported";
+    }
+
+    // Valid public keys and scalars of the signature set, the digests serve as l
+    SignatureSet set;
+    static point_extproj_precomp_t tables[8][4][4];
+    point_extproj_precomp_t (*tablePointers[8])[4];
+    unsigned long long* k[8];
+    unsigned long long* l[8];
+    unsigned long long hashes[8][8];
+    for (unsigned int lane = 0; lane < 8; lane++)
+    {
+        const unsigned int i = lane * 7;
+        point_t A;
+        ASSERT_TRUE(decode(set.publicKeys[i], A));
+        ASSERT_TRUE(ecc_precomp_double_tables(A, tables[lane]));
+        tablePointers[lane] = tables[lane];
+        k[lane] = (unsigned long long*)(set.signatures[i] + 32);
+        KangarooTwelve(set.digests[i], 32, hashes[lane], 64);
+        l[lane] = hashes[lane];
+    }
+
+    for (unsigned int numberOfLanes = 1; numberOfLanes <= 8; numberOfLanes++)
+    {
+        point_extproj_t T[8];
+        ecc_mul_double_tables_8x(k, l, tablePointers, numberOfLanes, T);
+        for (unsigned int lane = 0; lane < numberOfLanes; lane++)
+        {
+            point_extproj_t expectedT;
+            point_t R, expectedR;
+            ecc_mul_double_tables(k[lane], l[lane], tables[lane], expectedT);
+            eccnorm(expectedT, expectedR);
+            eccnorm(T[lane], R);
+            EXPECT_EQ(memcmp(R, expectedR, sizeof(R)), 0) << "lane " << lane << " of " << numberOfLanes;
+        }
+    }
+}
+
+TEST(TestCoreFourQ, VerifyBatchMatchesVerifyWithoutLockstep) {
+    initFourQTest();
+    if (!ecc_mul_double_tables_8x)
+    {
+        GTEST_SKIP() << "AVX-512 IFMA is not supported";
+    }
+
+    SignatureSet set;
+    bool lockstepResults[set.size], scalarResults[set.size];
+    const bool lockstepAllValid = verifyBatch(set.publicKeyPointers, set.digestPointers, set.signaturePointers, set.size, lockstepResults);
+    ecc_mul_double_tables_8x = NULL;
+    const bool scalarAllValid = verifyBatch(set.publicKeyPointers, set.digestPointers, set.signaturePointers, set.size, scalarResults);
+    selectFourQKernels();
+    EXPECT_EQ(lockstepAllValid, scalarAllValid);
+    for (unsigned int i = 0; i < set.size; i++)
+    {
+        EXPECT_EQ(lockstepResults[i], scalarResults[i]);
+        EXPECT_EQ(lockstepResults[i], i % 7 == 0);
+    }
+}
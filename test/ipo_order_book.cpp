@@ -0,0 +1,135 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/ipo_order_book.h"
+
+
+struct TestIPO
+{
+    m256i publicKeys[NUMBER_OF_COMPUTORS];
+    long long prices[NUMBER_OF_COMPUTORS];
+};
+
+static TestIPO ipo, expectedIPO;
+static IPOOrderBook orderBook;
+static IPORefunds refunds;
+
+static m256i expectedRefundPublicKeys[NUMBER_OF_COMPUTORS];
+static long long expectedRefundAmounts[NUMBER_OF_COMPUTORS];
+static unsigned int numberOfExpectedRefunds;
+
+static void addExpectedRefund(const m256i& publicKey, long long amount)
+{
+    unsigned int j;
+    for (j = 0; j < numberOfExpectedRefunds; j++)
+    {
+        if (publicKey == expectedRefundPublicKeys[j])
+        {
+            break;
+        }
+    }
+    if (j == numberOfExpectedRefunds)
+    {
+        expectedRefundPublicKeys[numberOfExpectedRefunds] = publicKey;
+        expectedRefundAmounts[numberOfExpectedRefunds++] = amount;
+    }
+    else
+    {
+        expectedRefundAmounts[j] += amount;
+    }
+}
+
+// A bid sorted into the arrays the way the tick processor used to do it
+static void addExpectedBid(const m256i& publicKey, long long price, unsigned short quantity)
+{
+    numberOfExpectedRefunds = 0;
+    for (unsigned int i = 0; i < quantity; i++)
+    {
+        if (price <= expectedIPO.prices[NUMBER_OF_COMPUTORS - 1])
+        {
+            addExpectedRefund(publicKey, price);
+        }
+        else
+        {
+            addExpectedRefund(expectedIPO.publicKeys[NUMBER_OF_COMPUTORS - 1], expectedIPO.prices[NUMBER_OF_COMPUTORS - 1]);
+            expectedIPO.publicKeys[NUMBER_OF_COMPUTORS - 1] = publicKey;
+            expectedIPO.prices[NUMBER_OF_COMPUTORS - 1] = price;
+            unsigned int j = NUMBER_OF_COMPUTORS - 1;
+            while (j
+                && expectedIPO.prices[j - 1] < expectedIPO.prices[j])
+            {
+                const m256i tmpPublicKey = expectedIPO.publicKeys[j - 1];
+                const long long tmpPrice = expectedIPO.prices[j - 1];
+                expectedIPO.publicKeys[j - 1] = expectedIPO.publicKeys[j];
+                expectedIPO.prices[j - 1] = expectedIPO.prices[j];
+                expectedIPO.publicKeys[j] = tmpPublicKey;
+                expectedIPO.prices[j--] = tmpPrice;
+            }
+        }
+    }
+}
+
+static void addBid(const m256i& publicKey, long long price, unsigned short quantity)
+{
+    if (!orderBook.isOpen)
+    {
+        openIPOOrderBook(orderBook, ipo);
+    }
+    for (unsigned int i = 0; i < quantity; i++)
+    {
+        const IPOBid& lowestBid = lowestIPOBid(orderBook);
+        if (price <= lowestBid.price)
+        {
+            addIPORefund(refunds, publicKey, price);
+        }
+        else
+        {
+            addIPORefund(refunds, lowestBid.publicKey, lowestBid.price);
+            replaceLowestIPOBid(orderBook, publicKey, price);
+        }
+    }
+}
+
+TEST(TestCoreIPOOrderBook, MatchesSortedArrays) {
+    initIPORefunds(refunds);
+    setMem(&ipo, sizeof(ipo), 0);
+    setMem(&expectedIPO, sizeof(expectedIPO), 0);
+
+    // Few bidders and prices so that bids often tie and refunds merge
+    unsigned long long x = 0x123456789ABCDEF;
+    for (unsigned int tick = 0; tick < 40; tick++)
+    {
+        const unsigned int numberOfBids = 1 + tick % 7 * 20;
+        for (unsigned int i = 0; i < numberOfBids; i++)
+        {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            const m256i publicKey(x % 50 + 1, 0, 0, 0);
+            const long long price = 1 + (x >> 8) % (10 + tick * 3);
+            const unsigned short quantity = (unsigned short)(1 + (x >> 20) % ((x >> 40) & 1 ? NUMBER_OF_COMPUTORS : 20));
+
+            addExpectedBid(publicKey, price, quantity);
+            addBid(publicKey, price, quantity);
+
+            ASSERT_EQ(refunds.numberOfRefunds, numberOfExpectedRefunds);
+            for (unsigned int j = 0; j < numberOfExpectedRefunds; j++)
+            {
+                EXPECT_TRUE(refunds.publicKeys[j] == expectedRefundPublicKeys[j]);
+                EXPECT_EQ(refunds.amounts[j], expectedRefundAmounts[j]);
+            }
+            clearIPORefunds(refunds);
+            for (unsigned int j = 0; j < IPO_REFUNDS_HASH_MAP_SIZE; j++)
+            {
+                ASSERT_EQ(refunds.refundIndices[j], 0);
+            }
+        }
+
+        closeIPOOrderBook(orderBook, ipo);
+        EXPECT_FALSE(orderBook.isOpen);
+        for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+        {
+            ASSERT_EQ(ipo.prices[i], expectedIPO.prices[i]) << "tick " << tick << ", position " << i;
+            ASSERT_TRUE(ipo.publicKeys[i] == expectedIPO.publicKeys[i]) << "tick " << tick << ", position " << i;
+        }
+    }
+}
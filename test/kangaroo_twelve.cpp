@@ -0,0 +1,170 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include "../src/platform/m256.h"
+#include "../src/kangaroo_twelve.h"
+
+
+TEST(TestCoreKangarooTwelve, KernelsMatch) {
+    detectCpuFeatures();
+    if (!cpuFeatures.avx512)
+    {
+        GTEST_SKIP() << "AVX-512 is not supported";
+    }
+    initAVX512KangarooTwelveConstants();
+
+    static unsigned char input[3 * K12_chunkSize + 1000];
+    for (unsigned int i = 0; i < sizeof(input); i++)
+    {
+        input[i] = (unsigned char)(i * 31 + (i >> 8));
+    }
+
+    unsigned char genericState[200], avx512State[200];
+    copyMem(genericState, input, sizeof(genericState));
+    copyMem(avx512State, input, sizeof(avx512State));
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        KeccakP1600_Permute_12rounds_Generic(genericState);
+        KeccakP1600_Permute_12rounds_AVX512(avx512State);
+        EXPECT_EQ(memcmp(genericState, avx512State, sizeof(genericState)), 0);
+    }
+
+    unsigned char genericOutput[32], avx512Output[32];
+    KangarooTwelve64To32_Generic(input, genericOutput);
+    KangarooTwelve64To32_AVX512(input, avx512Output);
+    EXPECT_EQ(memcmp(genericOutput, avx512Output, sizeof(genericOutput)), 0);
+
+    // Short, block-aligned, chunk-aligned and multi-chunk inputs
+    const unsigned int lengths[] = { 0, 1, 64, 167, 168, 169, 1000, K12_chunkSize, K12_chunkSize + 1, 2 * K12_chunkSize + 168, sizeof(input) };
+    for (unsigned int length : lengths)
+    {
+        KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_Generic;
+        KeccakP1600_AbsorbBlocks = KeccakP1600_AbsorbBlocks_Generic;
+        KangarooTwelve(input, length, genericOutput, sizeof(genericOutput));
+        KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_AVX512;
+        KeccakP1600_AbsorbBlocks = KeccakP1600_AbsorbBlocks_AVX512;
+        KangarooTwelve(input, length, avx512Output, sizeof(avx512Output));
+        EXPECT_EQ(memcmp(genericOutput, avx512Output, sizeof(genericOutput)), 0);
+    }
+    KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_Generic;
+    KeccakP1600_AbsorbBlocks = KeccakP1600_AbsorbBlocks_Generic;
+}
+
+TEST(TestCoreKangarooTwelve, AVX2KernelsMatch) {
+    detectCpuFeatures();
+    if (!cpuFeatures.avx2)
+    {
+        GTEST_SKIP() << "AVX2 is not supported";
+    }
+    KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_Generic;
+    KeccakP1600_AbsorbBlocks = KeccakP1600_AbsorbBlocks_Generic;
+
+    static unsigned char input[10 * K12_chunkSize + 1000];
+    for (unsigned int i = 0; i < sizeof(input); i++)
+    {
+        input[i] = (unsigned char)(i * 29 + (i >> 9));
+    }
+
+    // Single state and 4 states side by side, lane i of state j is element j of lanes[i]
+    unsigned char genericStates[4][200], avx2State[200];
+    __m256i lanes[25];
+    for (unsigned int j = 0; j < 4; j++)
+    {
+        copyMem(genericStates[j], input + j * 200, 200);
+        for (unsigned int i = 0; i < 25; i++)
+        {
+            ((unsigned long long*)&lanes[i])[j] = ((unsigned long long*)genericStates[j])[i];
+        }
+    }
+    copyMem(avx2State, genericStates[0], sizeof(avx2State));
+    for (unsigned int k = 0; k < 10; k++)
+    {
+        KeccakP1600_Permute_12rounds_AVX2(avx2State);
+        KeccakP1600_Permute_12rounds_4x(lanes);
+        for (unsigned int j = 0; j < 4; j++)
+        {
+            KeccakP1600_Permute_12rounds_Generic(genericStates[j]);
+            for (unsigned int i = 0; i < 25; i++)
+            {
+                EXPECT_EQ(((unsigned long long*)&lanes[i])[j], ((unsigned long long*)genericStates[j])[i]);
+            }
+        }
+        EXPECT_EQ(memcmp(genericStates[0], avx2State, sizeof(avx2State)), 0);
+    }
+
+    // The 4-leaf path kicks in from 5 chunks on (the first chunk is absorbed by the final node)
+    const unsigned int lengths[] = { 0, 1, 168, 1000, K12_chunkSize + 1, 4 * K12_chunkSize + 1, 5 * K12_chunkSize, 5 * K12_chunkSize + 1, 6 * K12_chunkSize - 1, 9 * K12_chunkSize, 9 * K12_chunkSize + 168, sizeof(input) };
+    for (unsigned int length : lengths)
+    {
+        unsigned char genericOutput[32], avx2Output[32];
+        KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_Generic;
+        KangarooTwelve_Leaves4x = NULL;
+        KangarooTwelve(input, length, genericOutput, sizeof(genericOutput));
+        KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_AVX2;
+        KangarooTwelve_Leaves4x = KangarooTwelve_Leaves_4x;
+        KangarooTwelve(input, length, avx2Output, sizeof(avx2Output));
+        EXPECT_EQ(memcmp(genericOutput, avx2Output, sizeof(genericOutput)), 0);
+    }
+    KeccakP1600_Permute_12rounds = KeccakP1600_Permute_12rounds_Generic;
+    KangarooTwelve_Leaves4x = NULL;
+
+    // Batches of 64-byte inputs, with and without a tail that is hashed one by one
+    unsigned char genericOutputs[11 * 32], avx2Outputs[11 * 32];
+    for (unsigned int i = 0; i < 11; i++)
+    {
+        KangarooTwelve64To32_Generic(input + i * 64, genericOutputs + i * 32);
+    }
+    for (unsigned int numberOfInputs : { 4, 8, 11 })
+    {
+        KangarooTwelve64To32x4 = KangarooTwelve64To32_4x;
+        setMem(avx2Outputs, sizeof(avx2Outputs), 0);
+        KangarooTwelve64To32Batch(input, avx2Outputs, numberOfInputs);
+        EXPECT_EQ(memcmp(genericOutputs, avx2Outputs, numberOfInputs * 32), 0);
+    }
+    KangarooTwelve64To32x4 = NULL;
+}
+
+TEST(TestCoreKangarooTwelve, ParallelMatchesSequential) {
+    detectCpuFeatures();
+    selectKangarooTwelveKernels();
+
+    const unsigned int inputSize = (2 * K12_PARALLEL_WINDOW + 7) * K12_chunkSize + 1000;
+    unsigned char* input = new unsigned char[inputSize];
+    for (unsigned int i = 0; i < inputSize; i++)
+    {
+        input[i] = (unsigned char)(i * 41 + (i >> 13));
+    }
+
+    volatile bool stopHelping = false;
+    std::thread helpers[3];
+    for (auto& helper : helpers)
+    {
+        helper = std::thread([&stopHelping]()
+            {
+                while (!stopHelping)
+                {
+                    helpKangarooTwelveParallel();
+                }
+            });
+    }
+
+    // Below the threshold, exactly one window, windows plus a partial last leaf, and whole windows plus the extra 0x00 leaf
+    const unsigned int lengths[] = { 1000, 9 * K12_chunkSize, (K12_PARALLEL_WINDOW + 1) * K12_chunkSize, (K12_PARALLEL_WINDOW + 1) * K12_chunkSize + 1, (2 * K12_PARALLEL_WINDOW + 1) * K12_chunkSize, inputSize };
+    for (unsigned int length : lengths)
+    {
+        unsigned char sequentialOutput[32], parallelOutput[32];
+        KangarooTwelve(input, length, sequentialOutput, sizeof(sequentialOutput));
+        KangarooTwelveParallel(input, length, parallelOutput, sizeof(parallelOutput));
+        EXPECT_EQ(memcmp(sequentialOutput, parallelOutput, sizeof(sequentialOutput)), 0);
+    }
+
+    stopHelping = true;
+    for (auto& helper : helpers)
+    {
+        helper.join();
+    }
+    delete[] input;
+}
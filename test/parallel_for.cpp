@@ -0,0 +1,79 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/parallel_for.h"
+
+#include <thread>
+
+
+#define TEST_NUMBER_OF_INDICES 10000
+#define TEST_NUMBER_OF_HELPERS 3
+
+static volatile long long runs[TEST_NUMBER_OF_INDICES];
+static volatile char stopHelpers = 0;
+
+static void countRun(void* context, unsigned int index)
+{
+    _InterlockedIncrement64(&runs[index]);
+    _InterlockedIncrement64((volatile long long*)context);
+}
+
+static void helper()
+{
+    while (!stopHelpers)
+    {
+        if (!helpParallelFor())
+        {
+            _mm_pause();
+        }
+    }
+}
+
+TEST(TestCoreParallelFor, RunsEveryIndexOnce) {
+    EXPECT_FALSE(helpParallelFor());
+
+    std::thread helpers[TEST_NUMBER_OF_HELPERS];
+    for (unsigned int i = 0; i < TEST_NUMBER_OF_HELPERS; i++)
+    {
+        helpers[i] = std::thread(helper);
+    }
+
+    for (unsigned int round = 0; round < 20; round++)
+    {
+        for (unsigned int i = 0; i < TEST_NUMBER_OF_INDICES; i++)
+        {
+            runs[i] = 0;
+        }
+        const unsigned int numberOfIndices = TEST_NUMBER_OF_INDICES - round * 97;
+        volatile long long numberOfRuns = 0;
+        if (round & 1)
+        {
+            // Helpers start on the loop while the processor that began it is busy
+            beginParallelFor(countRun, (void*)&numberOfRuns, numberOfIndices, 1 + round);
+            std::this_thread::yield();
+            finishParallelFor();
+        }
+        else
+        {
+            parallelFor(countRun, (void*)&numberOfRuns, numberOfIndices, 1 + round);
+        }
+
+        // All iterations are done once the loop is finished
+        EXPECT_EQ(numberOfRuns, numberOfIndices);
+        for (unsigned int i = 0; i < TEST_NUMBER_OF_INDICES; i++)
+        {
+            EXPECT_EQ(runs[i], i < numberOfIndices ? 1 : 0) << "round " << round << ", index " << i;
+        }
+    }
+
+    // Finishing without a loop does nothing
+    finishParallelFor();
+
+    stopHelpers = 1;
+    for (unsigned int i = 0; i < TEST_NUMBER_OF_HELPERS; i++)
+    {
+        helpers[i].join();
+    }
+    EXPECT_EQ(parallelForJob.numberOfHelpers, 0);
+}
@@ -0,0 +1,200 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/pending_transactions.h"
+
+
+#define TEST_NUMBER_OF_SOURCES 1024
+#define TEST_NUMBER_OF_TICK_LISTS 16
+
+static void initPendingTransactionsTest()
+{
+    static bool initialized = false;
+    if (!initialized)
+    {
+        ASSERT_TRUE(initPendingTransactions(TEST_NUMBER_OF_SOURCES, TEST_NUMBER_OF_TICK_LISTS));
+        initialized = true;
+    }
+    clearPendingTransactions();
+    removePendingTransactionsBeforeTick(100);
+}
+
+// Fake transaction of size bytes whose bytes encode source and tick
+static void fillTransaction(unsigned char* transaction, unsigned int size, unsigned int sourceIndex, unsigned int tick)
+{
+    for (unsigned int i = 0; i < size; i++)
+    {
+        transaction[i] = (unsigned char)(sourceIndex * 31 + tick * 7 + i);
+    }
+}
+
+static unsigned int countPendingTransactions(unsigned int tick)
+{
+    unsigned int count = 0;
+    for (unsigned int index = firstPendingTransaction(tick); index != NO_PENDING_TRANSACTION; index = pendingTransactions[index].next)
+    {
+        if (pendingTransactions[index].tick == tick)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+TEST(TestCorePendingTransactions, HigherTickReplacesOlder) {
+    initPendingTransactionsTest();
+
+    unsigned char transaction[1024];
+    const m256i digest(1, 2, 3, 4);
+    fillTransaction(transaction, 200, 5, 105);
+    EXPECT_TRUE(addPendingTransaction(5, transaction, 200, 105, digest));
+    EXPECT_FALSE(addPendingTransaction(5, transaction, 200, 105, digest));
+    EXPECT_FALSE(addPendingTransaction(5, transaction, 200, 104, digest));
+    EXPECT_EQ(numberOfPendingTransactions, 1);
+
+    fillTransaction(transaction, 700, 5, 108);
+    EXPECT_TRUE(addPendingTransaction(5, transaction, 700, 108, digest));
+    EXPECT_EQ(numberOfPendingTransactions, 1);
+    EXPECT_EQ(countPendingTransactions(105), 0);
+    EXPECT_EQ(countPendingTransactions(108), 1);
+
+    const unsigned int index = pendingTransactionsBySource[5];
+    ASSERT_NE(index, NO_PENDING_TRANSACTION);
+    EXPECT_EQ(pendingTransactions[index].size, 700);
+    EXPECT_TRUE(pendingTransactions[index].digest == digest);
+    EXPECT_EQ(memcmp(pendingTransactionData(index), transaction, 700), 0);
+
+    // Ticks before the oldest tick and beyond the tick lists are rejected
+    EXPECT_FALSE(addPendingTransaction(6, transaction, 200, 99, digest));
+    EXPECT_FALSE(addPendingTransaction(6, transaction, 200, 100 + TEST_NUMBER_OF_TICK_LISTS, digest));
+    EXPECT_FALSE(addPendingTransaction(TEST_NUMBER_OF_SOURCES, transaction, 200, 101, digest));
+}
+
+TEST(TestCorePendingTransactions, TicksAreRemovedAndBlocksReused) {
+    initPendingTransactionsTest();
+
+    unsigned char transaction[1024];
+    for (unsigned int sourceIndex = 0; sourceIndex < TEST_NUMBER_OF_SOURCES; sourceIndex++)
+    {
+        const unsigned int tick = 100 + sourceIndex % 8;
+        const unsigned int size = 144 + (sourceIndex * 37) % 800;
+        fillTransaction(transaction, size, sourceIndex, tick);
+        EXPECT_TRUE(addPendingTransaction(sourceIndex, transaction, size, tick, m256i(sourceIndex, 0, 0, 1)));
+    }
+    EXPECT_EQ(numberOfPendingTransactions, TEST_NUMBER_OF_SOURCES);
+    for (unsigned int tick = 100; tick < 108; tick++)
+    {
+        EXPECT_EQ(countPendingTransactions(tick), TEST_NUMBER_OF_SOURCES / 8);
+    }
+
+    const unsigned long long arenaEnd = pendingTransactionsArenaEnd;
+    removePendingTransactionsBeforeTick(104);
+    EXPECT_EQ(numberOfPendingTransactions, TEST_NUMBER_OF_SOURCES / 2);
+    EXPECT_EQ(countPendingTransactions(103), 0);
+    EXPECT_EQ(countPendingTransactions(104), TEST_NUMBER_OF_SOURCES / 8);
+
+    // The same transactions for later ticks fit into the freed blocks
+    for (unsigned int sourceIndex = 0; sourceIndex < TEST_NUMBER_OF_SOURCES; sourceIndex++)
+    {
+        if (sourceIndex % 8 < 4)
+        {
+            const unsigned int tick = 110 + sourceIndex % 4;
+            const unsigned int size = 144 + (sourceIndex * 37) % 800;
+            fillTransaction(transaction, size, sourceIndex, tick);
+            EXPECT_TRUE(addPendingTransaction(sourceIndex, transaction, size, tick, m256i(sourceIndex, 0, 0, 2)));
+        }
+    }
+    EXPECT_EQ(pendingTransactionsArenaEnd, arenaEnd);
+    EXPECT_EQ(numberOfPendingTransactions, TEST_NUMBER_OF_SOURCES);
+
+    for (unsigned int sourceIndex = 0; sourceIndex < TEST_NUMBER_OF_SOURCES; sourceIndex++)
+    {
+        const unsigned int index = pendingTransactionsBySource[sourceIndex];
+        ASSERT_NE(index, NO_PENDING_TRANSACTION);
+        const unsigned int tick = sourceIndex % 8 < 4 ? 110 + sourceIndex % 4 : 100 + sourceIndex % 8;
+        const unsigned int size = 144 + (sourceIndex * 37) % 800;
+        EXPECT_EQ(pendingTransactions[index].tick, tick);
+        fillTransaction(transaction, size, sourceIndex, tick);
+        EXPECT_EQ(memcmp(pendingTransactionData(index), transaction, size), 0) << "source " << sourceIndex;
+    }
+}
+
+TEST(TestCorePendingTransactions, ReindexMovesAndDropsSources) {
+    initPendingTransactionsTest();
+
+    unsigned char transaction[256];
+    for (unsigned int sourceIndex = 0; sourceIndex < 64; sourceIndex++)
+    {
+        fillTransaction(transaction, sizeof(transaction), sourceIndex, 101);
+        transaction[0] = (unsigned char)sourceIndex;
+        EXPECT_TRUE(addPendingTransaction(sourceIndex, transaction, sizeof(transaction), 101, m256i(sourceIndex, 0, 0, 3)));
+    }
+
+    // Odd sources are gone, even sources move to the reversed index
+    reindexPendingTransactions([](const unsigned char* transaction) { return (transaction[0] & 1) ? -1 : (int)(TEST_NUMBER_OF_SOURCES - 1 - transaction[0]); });
+    EXPECT_EQ(numberOfPendingTransactions, 32);
+    EXPECT_EQ(countPendingTransactions(101), 32);
+    for (unsigned int sourceIndex = 0; sourceIndex < 64; sourceIndex++)
+    {
+        EXPECT_EQ(pendingTransactionsBySource[sourceIndex], NO_PENDING_TRANSACTION);
+        const unsigned int index = pendingTransactionsBySource[TEST_NUMBER_OF_SOURCES - 1 - sourceIndex];
+        if (sourceIndex & 1)
+        {
+            EXPECT_EQ(index, NO_PENDING_TRANSACTION);
+        }
+        else
+        {
+            ASSERT_NE(index, NO_PENDING_TRANSACTION);
+            EXPECT_EQ(pendingTransactionData(index)[0], sourceIndex);
+        }
+    }
+}
+
+TEST(TestCorePendingTransactions, FullPoolEvictsFarthestTicks) {
+    // Enough sources to fill the arena with transactions of the largest size class
+    const unsigned int maxTransactionSize = PENDING_TRANSACTION_BLOCK_SIZE * NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES;
+    const unsigned int numberOfFillingSources = (unsigned int)(PENDING_TRANSACTIONS_ARENA_SIZE / maxTransactionSize);
+    initPendingTransactionsTest();
+    deinitPendingTransactions();
+    ASSERT_TRUE(initPendingTransactions(numberOfFillingSources + 2, TEST_NUMBER_OF_TICK_LISTS));
+    removePendingTransactionsBeforeTick(100);
+
+    unsigned char transaction[PENDING_TRANSACTION_BLOCK_SIZE * NUMBER_OF_PENDING_TRANSACTION_SIZE_CLASSES];
+    for (unsigned int sourceIndex = 0; sourceIndex < numberOfFillingSources; sourceIndex++)
+    {
+        ASSERT_TRUE(addPendingTransaction(sourceIndex, transaction, maxTransactionSize, 100 + TEST_NUMBER_OF_TICK_LISTS - 1 - sourceIndex % 2, m256i(sourceIndex, 0, 0, 4)));
+    }
+    EXPECT_EQ(pendingTransactionsArenaEnd, PENDING_TRANSACTIONS_ARENA_SIZE);
+
+    // A small transaction for an earlier tick takes a part of the block of an evicted transaction of the farthest tick
+    const unsigned int source = numberOfFillingSources;
+    fillTransaction(transaction, 200, source, 101);
+    EXPECT_TRUE(addPendingTransaction(source, transaction, 200, 101, m256i(source, 0, 0, 5)));
+    EXPECT_EQ(numberOfPendingTransactions, numberOfFillingSources);
+    EXPECT_EQ(countPendingTransactions(100 + TEST_NUMBER_OF_TICK_LISTS - 1), numberOfFillingSources / 2 - 1);
+    EXPECT_EQ(countPendingTransactions(100 + TEST_NUMBER_OF_TICK_LISTS - 2), numberOfFillingSources / 2);
+    EXPECT_EQ(numberOfRejectedPendingTransactions, 0);
+
+    // Another small one fits into the rest of the split block without evicting
+    fillTransaction(transaction, 200, source + 1, 102);
+    EXPECT_TRUE(addPendingTransaction(source + 1, transaction, 200, 102, m256i(source + 1, 0, 0, 5)));
+    EXPECT_EQ(numberOfPendingTransactions, numberOfFillingSources + 1);
+
+    // Nothing is evicted for a transaction of the farthest tick, the previous transaction of its source stays
+    EXPECT_FALSE(addPendingTransaction(source, transaction, maxTransactionSize, 100 + TEST_NUMBER_OF_TICK_LISTS - 1, m256i(source, 0, 0, 6)));
+    EXPECT_EQ(numberOfRejectedPendingTransactions, 1);
+    const unsigned int index = pendingTransactionsBySource[source];
+    ASSERT_NE(index, NO_PENDING_TRANSACTION);
+    EXPECT_EQ(pendingTransactions[index].tick, 101);
+    fillTransaction(transaction, 200, source, 101);
+    EXPECT_EQ(memcmp(pendingTransactionData(index), transaction, 200), 0);
+
+    // A large transaction for an earlier tick evicts from the farthest tick first
+    EXPECT_TRUE(addPendingTransaction(source, transaction, maxTransactionSize, 103, m256i(source, 0, 0, 7)));
+    EXPECT_EQ(countPendingTransactions(100 + TEST_NUMBER_OF_TICK_LISTS - 1), numberOfFillingSources / 2 - 2);
+    EXPECT_EQ(countPendingTransactions(100 + TEST_NUMBER_OF_TICK_LISTS - 2), numberOfFillingSources / 2);
+
+    deinitPendingTransactions();
+    ASSERT_TRUE(initPendingTransactions(TEST_NUMBER_OF_SOURCES, TEST_NUMBER_OF_TICK_LISTS));
+}
@@ -2,6 +2,8 @@
 
 #include "gtest/gtest.h"
 
+#include <vector>
+
 // current optimized implementation
 #include "../src/score.h"
 
@@ -25,7 +27,7 @@ struct ScoreTester
         dataLength, infoLength,
         numberOfInputNeurons, numberOfOutputNeurons,
         maxInputDuration, maxOutputDuration,
-        maxNumberOfProcessors, solutionBufferCount
+        solutionBufferCount
     > ScoreFuncOpt;
     typedef ScoreReferenceImplementation<
         dataLength, infoLength,
@@ -41,15 +43,16 @@ struct ScoreTester
     {
         score = new ScoreFuncOpt;
         score_ref_impl = new ScoreFuncRef;
-        score->initMiningData();
+        score->initMemory();
+        // Same seed as the reference implementation uses
+        score->initMiningData(m256i(((unsigned long long)RANDOM_SEED7 << 56) | ((unsigned long long)RANDOM_SEED6 << 48) | ((unsigned long long)RANDOM_SEED5 << 40) | ((unsigned long long)RANDOM_SEED4 << 32)
+            | ((unsigned long long)RANDOM_SEED3 << 24) | ((unsigned long long)RANDOM_SEED2 << 16) | ((unsigned long long)RANDOM_SEED1 << 8) | RANDOM_SEED0, 0, 0, 0));
         score_ref_impl->initMiningData();
-#if USE_SCORE_CACHE
-        score->initEmptyScoreCache();
-#endif
     }
 
     ~ScoreTester()
     {
+        score->freeMemory();
         delete score;
         delete score_ref_impl;
     }
@@ -61,6 +64,23 @@ struct ScoreTester
         std::cout << "current score() returns " << current << ", reference score() returns " << reference << std::endl;
         return current == reference;
     }
+
+    // Score n solutions with scoreBatch() and compare each result with the single-solution path and the reference
+    bool batch(const unsigned long long processorNumber, const m256i* publicKeys, const m256i* nonces, unsigned int n)
+    {
+        std::vector<unsigned int> current(n);
+        score->scoreBatch(processorNumber, publicKeys, nonces, n, current.data());
+        bool result = true;
+        for (unsigned int i = 0; i < n; i++)
+        {
+            unsigned int single = (*score)(processorNumber, publicKeys[i], nonces[i]);
+            m256i publicKey = publicKeys[i], nonce = nonces[i];
+            unsigned int reference = (*score_ref_impl)(processorNumber, publicKey.m256i_u8, nonce.m256i_u8);
+            std::cout << "current scoreBatch()[" << i << "] returns " << current[i] << ", score() returns " << single << ", reference score() returns " << reference << std::endl;
+            result = result && current[i] == single && current[i] == reference;
+        }
+        return result;
+    }
 };
 
 
@@ -163,3 +183,83 @@ TEST(TestTxBtcScoreFunction, Length1200InputNeurons1000OutputNeurons1200Duration
     > test_score;
     runCommonTests(test_score);
 }
+
+TEST(TestTxBtcScoreFunction, BatchMatchesSingleSolution) {
+    ScoreTester<
+        DATA_LENGTH, INFO_LENGTH,
+        NUMBER_OF_INPUT_NEURONS, NUMBER_OF_OUTPUT_NEURONS,
+        MAX_INPUT_DURATION, MAX_OUTPUT_DURATION,
+        MAX_NUMBER_OF_PROCESSORS,
+        1 // SET BUFFER TO 1 TO DETECT MEMORY OVERFLOW
+    > test_score;
+
+    // More solutions than MAX_SCORE_BATCH_SIZE to cover a full and a partial group
+    const m256i publicKeys[] = {
+        m256i(13969805098858910392ULL, 14472806656575993870ULL, 10205949277524717274ULL, 9139973247135990472ULL),
+        m256i(17764101523024620815ULL, 13444759684604467162ULL, 5205156473815387573ULL, 13260540040653911245ULL),
+        m256i(14789280547522027434ULL, 15979653773010502977ULL, 6616468095151646068ULL, 3853325349953461025ULL),
+        m256i(15507048083185325046ULL, 5419387135591449337ULL, 17612106885624953580ULL, 10150797730536211684ULL),
+        m256i(16469956954252377972ULL, 10616469325737600748ULL, 17234552708406882866ULL, 17603684088088319074ULL),
+        m256i(12225014192899428857ULL, 17723599372023570709ULL, 14273664843035611268ULL, 4222530050421664529ULL),
+    };
+    const m256i nonces[] = {
+        m256i(2606487637113200640ULL, 2267452027856879938ULL, 14495402921700380246ULL, 16315779787892001110ULL),
+        m256i(2719505187280522860ULL, 796569317027170745ULL, 1472067853669192224ULL, 17746228003132033809ULL),
+        m256i(1363327481582396135ULL, 152218635184973474ULL, 12932262167270620348ULL, 4723831151589758153ULL),
+        m256i(7282604761236241613ULL, 7487819921911970082ULL, 9774240096691834870ULL, 13218191714229610846ULL),
+        m256i(3101639521896790862ULL, 17674129317330307249ULL, 1333479429610156792ULL, 12048337933776378280ULL),
+        m256i(1722890237550299331ULL, 1409575367906677222ULL, 5258749978518149321ULL, 5534507432662726693ULL),
+    };
+    static_assert(sizeof(publicKeys) / sizeof(publicKeys[0]) > MAX_SCORE_BATCH_SIZE, "Not enough solutions");
+    EXPECT_TRUE(test_score.batch(0, publicKeys, nonces, sizeof(publicKeys) / sizeof(publicKeys[0])));
+
+    // Batches smaller than MAX_SCORE_BATCH_SIZE consist of a partial group only
+    for (unsigned int n = 1; n < MAX_SCORE_BATCH_SIZE; n++)
+    {
+        EXPECT_TRUE(test_score.batch(1, &publicKeys[n], &nonces[n], n)) << "batch of " << n;
+    }
+}
+
+TEST(TestTxBtcScoreFunction, NeuronInputKernelsMatch) {
+    ScoreTester<
+        DATA_LENGTH, INFO_LENGTH,
+        NUMBER_OF_INPUT_NEURONS, NUMBER_OF_OUTPUT_NEURONS,
+        MAX_INPUT_DURATION, MAX_OUTPUT_DURATION,
+        MAX_NUMBER_OF_PROCESSORS,
+        1 // SET BUFFER TO 1 TO DETECT MEMORY OVERFLOW
+    > test_score;
+
+    unsigned long long positive[80], negative[80], neurons[80];
+    random(m256i(1, 2, 3, 4).m256i_u8, m256i(5, 6, 7, 8).m256i_u8, (unsigned char*)positive, sizeof(positive));
+    random(m256i(1, 2, 3, 4).m256i_u8, m256i(9, 10, 11, 12).m256i_u8, (unsigned char*)negative, sizeof(negative));
+    random(m256i(1, 2, 3, 4).m256i_u8, m256i(13, 14, 15, 16).m256i_u8, (unsigned char*)neurons, sizeof(neurons));
+    const m256i publicKey(13969805098858910392ULL, 14472806656575993870ULL, 10205949277524717274ULL, 9139973247135990472ULL);
+    const m256i nonce(2606487637113200640ULL, 2267452027856879938ULL, 14495402921700380246ULL, 16315779787892001110ULL);
+
+    // Run with the kernel picked for this CPU first, then with the AVX-512 path disabled
+    detectCpuFeatures();
+    const bool avx512Vpopcntdq = cpuFeatures.avx512Vpopcntdq;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (pass)
+        {
+            cpuFeatures.avx512Vpopcntdq = false;
+        }
+        selectScoreKernels();
+        EXPECT_EQ(sumNeuronInput, cpuFeatures.avx512Vpopcntdq ? sumNeuronInput_AVX512 : sumNeuronInput_Generic);
+        std::cout << "sumNeuronInput uses the " << (sumNeuronInput == sumNeuronInput_AVX512 ? "AVX-512" : "generic") << " kernel" << std::endl;
+
+        for (unsigned int numberOfWords = 0; numberOfWords <= 80; numberOfWords++)
+        {
+            EXPECT_EQ(sumNeuronInput(positive, negative, neurons, numberOfWords), sumNeuronInput_Generic(positive, negative, neurons, numberOfWords));
+        }
+        EXPECT_TRUE(test_score.batch(0, &publicKey, &nonce, 1));
+    }
+    if (!avx512Vpopcntdq)
+    {
+        std::cout << "AVX-512 VPOPCNTDQ is not supported, only the generic kernel was tested" << std::endl;
+    }
+
+    cpuFeatures.avx512Vpopcntdq = avx512Vpopcntdq;
+    selectScoreKernels();
+}
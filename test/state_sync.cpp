@@ -0,0 +1,192 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/state_sync.h"
+
+
+#define TEST_NUMBER_OF_LEAVES 1024
+#define TEST_CHUNK_LEVEL 4
+
+static unsigned char leaves[TEST_NUMBER_OF_LEAVES * 64];
+static m256i expectedTree[TEST_NUMBER_OF_LEAVES * 2 - 1];
+static m256i tree[TEST_NUMBER_OF_LEAVES * 2 - 1];
+static m256i chunkTree[(2 << TEST_CHUNK_LEVEL) - 1];
+
+// The tree built leaf by leaf and node by node the way the tick processor does it
+static void buildExpectedTree(unsigned int leafSize)
+{
+    unsigned int digestIndex;
+    for (digestIndex = 0; digestIndex < TEST_NUMBER_OF_LEAVES; digestIndex++)
+    {
+        KangarooTwelve(&leaves[digestIndex * leafSize], leafSize, &expectedTree[digestIndex], 32);
+    }
+    unsigned int previousLevelBeginning = 0;
+    unsigned int numberOfLeafs = TEST_NUMBER_OF_LEAVES;
+    while (numberOfLeafs > 1)
+    {
+        for (unsigned int i = 0; i < numberOfLeafs; i += 2)
+        {
+            KangarooTwelve64To32(&expectedTree[previousLevelBeginning + i], &expectedTree[digestIndex++]);
+        }
+        previousLevelBeginning += numberOfLeafs;
+        numberOfLeafs >>= 1;
+    }
+}
+
+TEST(TestCoreStateSync, ChunksRebuildTree) {
+    for (unsigned int leafSize = 48; leafSize <= 64; leafSize += 16)
+    {
+        for (unsigned int i = 0; i < sizeof(leaves); i++)
+        {
+            leaves[i] = (unsigned char)(i * 13 + (i >> 7) + leafSize);
+        }
+        buildExpectedTree(leafSize);
+
+        setMem(tree, sizeof(tree), 0);
+        const unsigned int numberOfChunks = TEST_NUMBER_OF_LEAVES >> TEST_CHUNK_LEVEL;
+        for (unsigned int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++)
+        {
+            const m256i& chunkDigest = hashStateSyncChunk(chunkTree, TEST_CHUNK_LEVEL, &leaves[(chunkIndex << TEST_CHUNK_LEVEL) * leafSize], leafSize);
+            EXPECT_TRUE(chunkDigest == expectedTree[merkleLevelBeginning(TEST_NUMBER_OF_LEAVES, TEST_CHUNK_LEVEL) + chunkIndex]);
+            storeStateSyncChunkTree(tree, TEST_NUMBER_OF_LEAVES, TEST_CHUNK_LEVEL, chunkIndex, chunkTree);
+            EXPECT_TRUE(tree[merkleLevelBeginning(TEST_NUMBER_OF_LEAVES, TEST_CHUNK_LEVEL) + chunkIndex] == chunkDigest);
+        }
+        EXPECT_TRUE(updateStateSyncRoot(tree, TEST_NUMBER_OF_LEAVES, TEST_CHUNK_LEVEL) == expectedTree[TEST_NUMBER_OF_LEAVES * 2 - 2]);
+        for (unsigned int i = 0; i < TEST_NUMBER_OF_LEAVES * 2 - 1; i++)
+        {
+            ASSERT_TRUE(tree[i] == expectedTree[i]) << "leaf size " << leafSize << ", node " << i;
+        }
+
+        // Leaves as chunks of a single leaf, like the contract states of the computer
+        EXPECT_TRUE(updateStateSyncRoot(tree, TEST_NUMBER_OF_LEAVES, 0) == expectedTree[TEST_NUMBER_OF_LEAVES * 2 - 2]);
+    }
+}
+
+TEST(TestCoreStateSync, PassesOverMismatchingChunks) {
+    static m256i localChunkDigests[NUMBER_OF_SYNCED_STATES][64];
+    static m256i fetchedChunkDigests[64];
+    for (unsigned int i = 0; i < 64; i++)
+    {
+        fetchedChunkDigests[i] = m256i(i, 1, 2, 3);
+    }
+
+    beginStateSync();
+    EXPECT_TRUE(stateSync.isActive);
+    EXPECT_EQ(stateSync.numberOfRounds, 1);
+
+    unsigned int chunkIndices[4];
+    for (unsigned int state = 0; state < NUMBER_OF_SYNCED_STATES; state++)
+    {
+        for (unsigned int i = 0; i < 64; i++)
+        {
+            localChunkDigests[state][i] = (i % 10 == state) ? m256i(i, 0, 0, 0) : fetchedChunkDigests[i];
+        }
+        const unsigned int numberOfChunks = state == STATE_SYNC_COMPUTER ? 32 : 64;
+
+        // Nothing is found until the digests of the state have arrived, the digests of other states are ignored
+        EXPECT_EQ(nextMismatchingStateSyncChunks(state, localChunkDigests[state], chunkIndices, 4), 0);
+        setStateSyncChunkDigests(state + 1, 100, fetchedChunkDigests, numberOfChunks);
+        EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+        setStateSyncChunkDigests(state, 100, fetchedChunkDigests, numberOfChunks);
+        ASSERT_TRUE(stateSync.areChunkDigestsKnown);
+        EXPECT_EQ(stateSync.tick, 100);
+
+        // The pass ends once all chunks are compared, the state stays as long as mismatching chunks were found
+        unsigned int expectedChunk = state;
+        unsigned int numberOfFoundChunks = 0;
+        do
+        {
+            const unsigned int n = nextMismatchingStateSyncChunks(state, localChunkDigests[state], chunkIndices, 4);
+            for (unsigned int i = 0; i < n; i++)
+            {
+                EXPECT_EQ(chunkIndices[i], expectedChunk);
+                EXPECT_TRUE(isStateSyncChunkMismatching(state, chunkIndices[i], localChunkDigests[state]));
+                EXPECT_TRUE(isStateSyncChunkValid(state, chunkIndices[i], fetchedChunkDigests[chunkIndices[i]]));
+                EXPECT_FALSE(isStateSyncChunkValid(state, chunkIndices[i], localChunkDigests[state][chunkIndices[i]]));
+                expectedChunk += 10;
+            }
+            numberOfFoundChunks += n;
+        } while (stateSync.nextChunk);
+        EXPECT_EQ(numberOfFoundChunks, (numberOfChunks - state + 9) / 10);
+        EXPECT_EQ(stateSync.state, state);
+        EXPECT_TRUE(stateSync.areChunkDigestsKnown);
+
+        // Fetched chunks repair the state, the next pass finds them matching and moves on to the next state
+        for (unsigned int i = 0; i < numberOfChunks; i++)
+        {
+            localChunkDigests[state][i] = fetchedChunkDigests[i];
+        }
+        EXPECT_FALSE(isStateSyncChunkMismatching(state, state, localChunkDigests[state]));
+        EXPECT_EQ(nextMismatchingStateSyncChunks(state, localChunkDigests[state], chunkIndices, 4), 0);
+        EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+        EXPECT_EQ(stateSync.state, state + 1);
+        EXPECT_EQ(stateSync.isConverged, state + 1 == NUMBER_OF_SYNCED_STATES);
+    }
+
+    // Late digests are ignored once the round has converged
+    setStateSyncChunkDigests(STATE_SYNC_COMPUTER, 100, fetchedChunkDigests, 32);
+    EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+
+    repeatStateSyncRound();
+    EXPECT_FALSE(stateSync.isConverged);
+    EXPECT_EQ(stateSync.state, STATE_SYNC_SPECTRUM);
+    EXPECT_EQ(stateSync.tick, 0);
+    EXPECT_EQ(stateSync.numberOfRounds, 2);
+
+    endStateSync();
+    EXPECT_FALSE(stateSync.isActive);
+    setStateSyncChunkDigests(STATE_SYNC_SPECTRUM, 100, fetchedChunkDigests, 64);
+    EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+}
+
+TEST(TestCoreStateSync, KeepsAllStatesAtTheTickOfTheRound) {
+    static m256i localChunkDigests[64];
+    static m256i fetchedChunkDigests[64];
+    for (unsigned int i = 0; i < 64; i++)
+    {
+        localChunkDigests[i] = m256i(i, 0, 0, 0);
+        fetchedChunkDigests[i] = m256i(i, 1, 2, 3);
+    }
+    unsigned int chunkIndices[64];
+
+    beginStateSync();
+    setStateSyncChunkDigests(STATE_SYNC_SPECTRUM, 100, fetchedChunkDigests, 64);
+    EXPECT_EQ(stateSync.tick, 100);
+    EXPECT_EQ(nextMismatchingStateSyncChunks(STATE_SYNC_SPECTRUM, localChunkDigests, chunkIndices, 64), 64);
+    for (unsigned int i = 0; i < 64; i++)
+    {
+        localChunkDigests[i] = fetchedChunkDigests[i];
+    }
+    EXPECT_EQ(nextMismatchingStateSyncChunks(STATE_SYNC_SPECTRUM, localChunkDigests, chunkIndices, 64), 0);
+    EXPECT_EQ(nextMismatchingStateSyncChunks(STATE_SYNC_SPECTRUM, localChunkDigests, chunkIndices, 64), 0);
+    EXPECT_EQ(stateSync.state, STATE_SYNC_UNIVERSE);
+
+    // Digests of an earlier tick are ignored, digests of a later one begin a new round at the spectrum
+    setStateSyncChunkDigests(STATE_SYNC_UNIVERSE, 99, fetchedChunkDigests, 64);
+    EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+    EXPECT_EQ(stateSync.state, STATE_SYNC_UNIVERSE);
+    setStateSyncChunkDigests(STATE_SYNC_UNIVERSE, 101, fetchedChunkDigests, 64);
+    EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+    EXPECT_EQ(stateSync.state, STATE_SYNC_SPECTRUM);
+    EXPECT_EQ(stateSync.tick, 0);
+    EXPECT_EQ(stateSync.numberOfRounds, 2);
+
+    // A pass that repairs no chunk begins a new round, the peers no longer have the chunks of the tick of the round
+    setStateSyncChunkDigests(STATE_SYNC_SPECTRUM, 101, fetchedChunkDigests, 64);
+    EXPECT_EQ(stateSync.tick, 101);
+    localChunkDigests[5] = m256i(5, 0, 0, 0);
+    localChunkDigests[7] = m256i(7, 0, 0, 0);
+    EXPECT_EQ(nextMismatchingStateSyncChunks(STATE_SYNC_SPECTRUM, localChunkDigests, chunkIndices, 64), 2);
+    EXPECT_TRUE(stateSync.areChunkDigestsKnown);
+    localChunkDigests[5] = fetchedChunkDigests[5];
+    EXPECT_EQ(nextMismatchingStateSyncChunks(STATE_SYNC_SPECTRUM, localChunkDigests, chunkIndices, 64), 1);
+    EXPECT_TRUE(stateSync.areChunkDigestsKnown);
+    EXPECT_EQ(nextMismatchingStateSyncChunks(STATE_SYNC_SPECTRUM, localChunkDigests, chunkIndices, 64), 1);
+    EXPECT_FALSE(stateSync.areChunkDigestsKnown);
+    EXPECT_EQ(stateSync.state, STATE_SYNC_SPECTRUM);
+    EXPECT_EQ(stateSync.tick, 0);
+    EXPECT_EQ(stateSync.numberOfRounds, 3);
+
+    endStateSync();
+}
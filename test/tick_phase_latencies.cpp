@@ -0,0 +1,77 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/tick_phase_latencies.h"
+
+#include <algorithm>
+
+
+TEST(TestCoreTickPhaseLatencies, BucketsCoverSpans) {
+    unsigned long long x = 0x9E3779B97F4A7C15;
+    for (unsigned int i = 0; i < 100000; i++)
+    {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        const unsigned long long span = i < 1000 ? i : x >> (x & 63);
+        const unsigned int bucket = tickPhaseLatencyBucket(span);
+        ASSERT_LT(bucket, NUMBER_OF_TICK_PHASE_LATENCY_BUCKETS);
+        EXPECT_LE(span, tickPhaseLatencyBucketLimit(bucket));
+        if (bucket)
+        {
+            EXPECT_GT(span, tickPhaseLatencyBucketLimit(bucket - 1));
+        }
+        // A bucket is at most a quarter of its spans wide
+        EXPECT_LE(tickPhaseLatencyBucketLimit(bucket) - span, span / 4);
+    }
+    EXPECT_EQ(tickPhaseLatencyBucketLimit(tickPhaseLatencyBucket(0xFFFFFFFFFFFFFFFF)), 0xFFFFFFFFFFFFFFFF);
+}
+
+TEST(TestCoreTickPhaseLatencies, PercentilesOfLatestTicks) {
+    initTickPhaseLatencies();
+
+    // Spans are given in microseconds by using 1000000 TSC ticks per second
+    RespondTickPhaseLatencies response;
+    getTickPhaseLatencies(response, 1000000);
+    EXPECT_EQ(response.numberOfTicks, 0);
+    EXPECT_EQ(response.phases[TICK_PHASE_END_TICK].max, 0);
+
+    // Old ticks with large spans leave the window
+    unsigned long long spans[NUMBER_OF_TICK_PHASES];
+    for (unsigned int tick = 0; tick < TICK_PHASE_LATENCY_WINDOW; tick++)
+    {
+        for (unsigned int phase = 0; phase < NUMBER_OF_TICK_PHASES; phase++)
+        {
+            spans[phase] = 1000000;
+        }
+        recordTickPhaseLatencies(tick, spans);
+    }
+    for (unsigned int tick = TICK_PHASE_LATENCY_WINDOW; tick < TICK_PHASE_LATENCY_WINDOW * 3; tick++)
+    {
+        for (unsigned int phase = 0; phase < NUMBER_OF_TICK_PHASES; phase++)
+        {
+            // 1000 distinct spans per window, the phases differ by a factor
+            spans[phase] = (1 + tick % 1000) * (phase + 1);
+        }
+        recordTickPhaseLatencies(tick, spans);
+    }
+
+    getTickPhaseLatencies(response, 1000000);
+    EXPECT_EQ(response.tick, TICK_PHASE_LATENCY_WINDOW * 3 - 1);
+    EXPECT_EQ(response.numberOfTicks, TICK_PHASE_LATENCY_WINDOW);
+    for (unsigned int phase = 0; phase < NUMBER_OF_TICK_PHASES; phase++)
+    {
+        unsigned long long windowSpans[TICK_PHASE_LATENCY_WINDOW];
+        for (unsigned int i = 0; i < TICK_PHASE_LATENCY_WINDOW; i++)
+        {
+            windowSpans[i] = (1 + (TICK_PHASE_LATENCY_WINDOW * 2 + i) % 1000) * (phase + 1);
+        }
+        std::sort(windowSpans, windowSpans + TICK_PHASE_LATENCY_WINDOW);
+        const unsigned long long p50 = windowSpans[(TICK_PHASE_LATENCY_WINDOW * 50 + 99) / 100 - 1];
+        const unsigned long long p99 = windowSpans[(TICK_PHASE_LATENCY_WINDOW * 99 + 99) / 100 - 1];
+        EXPECT_EQ(response.phases[phase].max, windowSpans[TICK_PHASE_LATENCY_WINDOW - 1]);
+        EXPECT_GE(response.phases[phase].p50, p50);
+        EXPECT_LE(response.phases[phase].p50, p50 + p50 / 4);
+        EXPECT_GE(response.phases[phase].p99, p99);
+        EXPECT_LE(response.phases[phase].p99, p99 + p99 / 4);
+    }
+}
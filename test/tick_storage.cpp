@@ -0,0 +1,146 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/network/tick.h"
+#include "../src/tick_storage.h"
+
+
+#define TEST_NUMBER_OF_TICKS 8
+
+static void makeTick(Tick& tick, unsigned short epoch, unsigned int tickOffset, unsigned int computorIndex, unsigned int essenceVariant)
+{
+    setMem(&tick, sizeof(Tick), 0);
+    tick.computorIndex = computorIndex;
+    tick.epoch = epoch;
+    tick.tick = 1000 + tickOffset;
+    tick.millisecond = essenceVariant;
+    tick.second = 1;
+    tick.month = 2;
+    tick.year = 24;
+    tick.prevResourceTestingDigest = tickOffset * 3;
+    tick.saltedResourceTestingDigest = computorIndex * 5 + 1;
+    tick.prevSpectrumDigest = m256i(tickOffset, 1, 0, epoch);
+    tick.prevUniverseDigest = m256i(tickOffset, 2, 0, epoch);
+    tick.prevComputerDigest = m256i(tickOffset, 3, 0, epoch);
+    tick.saltedSpectrumDigest = m256i(computorIndex, 4, 0, tickOffset);
+    tick.saltedUniverseDigest = m256i(computorIndex, 5, 0, tickOffset);
+    tick.saltedComputerDigest = m256i(computorIndex, 6, 0, tickOffset);
+    tick.transactionDigest = m256i(tickOffset, 7, essenceVariant, epoch);
+    tick.expectedNextTickTransactionDigest = m256i(tickOffset, 8, 0, epoch);
+    for (unsigned int i = 0; i < SIGNATURE_SIZE; i++)
+    {
+        tick.signature[i] = (unsigned char)(computorIndex * 7 + tickOffset * 11 + i);
+    }
+}
+
+TEST(TestCoreTickStorage, StoreDeduplicatesEssences) {
+    ASSERT_TRUE(initTickStorage(TEST_NUMBER_OF_TICKS));
+
+    for (unsigned int tickOffset = 0; tickOffset < TEST_NUMBER_OF_TICKS; tickOffset++)
+    {
+        for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+        {
+            EXPECT_FALSE(isTickStored(tickOffset, computorIndex, 1));
+            if ((computorIndex + tickOffset) % 5)
+            {
+                // Most computors agree, a few of them send one of two other essences
+                Tick tick;
+                makeTick(tick, 1, tickOffset, computorIndex, computorIndex % 3 ? 0 : 1 + computorIndex % 2);
+                EXPECT_TRUE(storeTick(tickOffset, tick));
+            }
+        }
+    }
+    EXPECT_EQ(numberOfTickEssences, 1 + TEST_NUMBER_OF_TICKS * 3);
+
+    for (unsigned int tickOffset = 0; tickOffset < TEST_NUMBER_OF_TICKS; tickOffset++)
+    {
+        const StoredComputorTicks computorTicks = { tickOffset };
+        for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+        {
+            if ((computorIndex + tickOffset) % 5)
+            {
+                ASSERT_TRUE(isTickStored(tickOffset, computorIndex, 1));
+                EXPECT_FALSE(isTickStored(tickOffset, computorIndex, 2));
+                Tick expectedTick, tick;
+                makeTick(expectedTick, 1, tickOffset, computorIndex, computorIndex % 3 ? 0 : 1 + computorIndex % 2);
+                setMem(&tick, sizeof(Tick), 0);
+                getStoredTick(tickOffset, computorIndex, tick);
+                EXPECT_EQ(memcmp(&tick, &expectedTick, sizeof(Tick)), 0) << "tick " << tickOffset << ", computor " << computorIndex;
+                EXPECT_TRUE(computorTicks.transactionDigest(computorIndex) == expectedTick.transactionDigest);
+                EXPECT_TRUE(computorTicks.expectedNextTickTransactionDigest(computorIndex) == expectedTick.expectedNextTickTransactionDigest);
+            }
+            else
+            {
+                EXPECT_FALSE(isTickStored(tickOffset, computorIndex, 1));
+            }
+        }
+    }
+
+    // The ticks of the previous epoch are missing after a reset
+    resetTickStorage();
+    EXPECT_EQ(numberOfTickEssences, 1);
+    for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+    {
+        EXPECT_FALSE(isTickStored(0, computorIndex, 2));
+    }
+
+    // Every computor may send its own essence as long as its budget of unshared essences lasts
+    for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+    {
+        Tick tick;
+        makeTick(tick, 2, 0, computorIndex, computorIndex);
+        EXPECT_TRUE(storeTick(0, tick));
+        EXPECT_TRUE(isTickStored(0, computorIndex, 2));
+    }
+    EXPECT_EQ(numberOfTickEssences, 1 + NUMBER_OF_COMPUTORS);
+
+    deinitTickStorage();
+}
+
+TEST(TestCoreTickStorage, FaultyComputorsOnlyUseUpTheirOwnRoom) {
+    const unsigned int numberOfTicks = MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES * 4;
+    ASSERT_TRUE(initTickStorage(numberOfTicks));
+    EXPECT_EQ(maxNumberOfUnsharedTickEssences, MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES);
+
+    // The faulty computors send their own essence for every tick before the honest ones send theirs
+    const unsigned int numberOfFaultyComputors = NUMBER_OF_COMPUTORS - (NUMBER_OF_COMPUTORS * 2 / 3 + 1);
+    for (unsigned int tickOffset = 0; tickOffset < numberOfTicks; tickOffset++)
+    {
+        for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+        {
+            Tick tick;
+            makeTick(tick, 1, tickOffset, computorIndex, computorIndex < numberOfFaultyComputors ? 1 + computorIndex : 0);
+            EXPECT_EQ(storeTick(tickOffset, tick), computorIndex >= numberOfFaultyComputors || tickOffset < MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES)
+                << "tick " << tickOffset << ", computor " << computorIndex;
+        }
+        EXPECT_NE(quorumTickEssence(tickOffset, 1, NUMBER_OF_COMPUTORS - numberOfFaultyComputors), 0);
+    }
+    EXPECT_EQ(numberOfUnstoredComputorTicks, numberOfFaultyComputors * (numberOfTicks - MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES));
+    EXPECT_EQ(numberOfTickEssences, 1 + numberOfFaultyComputors * MIN_NUMBER_OF_UNSHARED_TICK_ESSENCES + numberOfTicks);
+    EXPECT_LT(numberOfTickEssences, maxNumberOfTickEssences);
+
+    deinitTickStorage();
+}
+
+TEST(TestCoreTickStorage, FindsQuorumEssence) {
+    ASSERT_TRUE(initTickStorage(TEST_NUMBER_OF_TICKS));
+
+    // Two thirds of the computors plus one agree on tick 1, the others send another essence and nobody sends tick 2
+    const unsigned int quorum = NUMBER_OF_COMPUTORS * 2 / 3 + 1;
+    for (unsigned int computorIndex = 0; computorIndex < NUMBER_OF_COMPUTORS; computorIndex++)
+    {
+        Tick tick;
+        makeTick(tick, 1, 1, computorIndex, computorIndex < quorum ? 0 : 1);
+        EXPECT_TRUE(storeTick(1, tick));
+    }
+
+    const unsigned int essence = quorumTickEssence(1, 1, quorum);
+    ASSERT_NE(essence, 0);
+    EXPECT_TRUE(tickEssences[essence].transactionDigest == m256i(1, 7, 0, 1));
+    EXPECT_EQ(quorumTickEssence(1, 1, quorum + 1), 0);
+    EXPECT_EQ(quorumTickEssence(1, 2, quorum), 0);
+    EXPECT_EQ(quorumTickEssence(2, 1, 1), 0);
+
+    deinitTickStorage();
+}
@@ -0,0 +1,60 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/tick_transaction_index.h"
+
+
+// Finds every listed digest at its index, misses unlisted and zero digests, also with colliding slots and empty transaction slots
+TEST(TestCoreTickTransactionIndex, FindMatchesLinearScan) {
+    static m256i transactionDigests[NUMBER_OF_TRANSACTIONS_PER_TICK];
+    static TickTransactionIndex index;
+    unsigned long long x = 0x13198A2E03707344;
+    for (unsigned int round = 0; round < 4; round++)
+    {
+        for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            for (unsigned int j = 0; j < 4; j++)
+            {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                transactionDigests[i].m256i_u64[j] = x;
+            }
+            if (round == 1 && i % 3)
+            {
+                transactionDigests[i] = _mm256_setzero_si256(); // Sparse tick
+            }
+            if (round == 2)
+            {
+                transactionDigests[i].m256i_u32[0] = 7; // All digests share the first slot
+            }
+        }
+        if (round == 3)
+        {
+            transactionDigests[900] = transactionDigests[100]; // Lowest index of a duplicate wins, like in a linear scan
+        }
+
+        buildTickTransactionIndex(transactionDigests, index);
+        for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            int expected = -1;
+            if (!isZero(transactionDigests[i]))
+            {
+                for (unsigned int j = 0; j < NUMBER_OF_TRANSACTIONS_PER_TICK; j++)
+                {
+                    if (transactionDigests[j] == transactionDigests[i])
+                    {
+                        expected = j;
+
+                        break;
+                    }
+                }
+            }
+            EXPECT_EQ(findTickTransaction(transactionDigests, index, transactionDigests[i]), expected) << "round " << round << ", transaction " << i;
+
+            m256i unlistedDigest = transactionDigests[i];
+            unlistedDigest.m256i_u64[3] ^= 1;
+            EXPECT_EQ(findTickTransaction(transactionDigests, index, unlistedDigest), -1) << "round " << round << ", transaction " << i;
+        }
+        EXPECT_EQ(findTickTransaction(transactionDigests, index, m256i(0, 0, 0, 0)), -1);
+    }
+}
@@ -0,0 +1,60 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/tick_transaction_storage.h"
+
+
+#define TEST_NUMBER_OF_TICKS 256
+
+static void fillTransaction(unsigned char* transaction, unsigned int size, unsigned int tickOffset, unsigned int transactionIndex)
+{
+    for (unsigned int i = 0; i < size; i++)
+    {
+        transaction[i] = (unsigned char)(tickOffset * 13 + transactionIndex * 7 + i);
+    }
+}
+
+TEST(TestCoreTickTransactionStorage, StoreAcrossChunks) {
+    ASSERT_TRUE(initTickTransactions(TEST_NUMBER_OF_TICKS));
+    EXPECT_EQ(numberOfTickTransactionsChunks, NUMBER_OF_SPARE_TICK_TRANSACTIONS_CHUNKS + 1);
+    EXPECT_EQ(getTickTransaction(0, 0), nullptr);
+
+    // Fill more than one chunk, the BSP keeps allocating spare chunks
+    unsigned char transaction[1200];
+    for (unsigned int tickOffset = 0; tickOffset < TEST_NUMBER_OF_TICKS; tickOffset++)
+    {
+        for (unsigned int transactionIndex = 0; transactionIndex < NUMBER_OF_TRANSACTIONS_PER_TICK; transactionIndex += 1 + tickOffset % 3)
+        {
+            const unsigned int size = 144 + (tickOffset * 31 + transactionIndex) % 1024;
+            fillTransaction(transaction, size, tickOffset, transactionIndex);
+            EXPECT_TRUE(storeTickTransaction(tickOffset, transactionIndex, transaction, size));
+            EXPECT_FALSE(storeTickTransaction(tickOffset, transactionIndex, transaction, size));
+        }
+        ASSERT_TRUE(manageTickTransactionsChunks());
+    }
+    EXPECT_GT(currentTickTransactionsChunk, 0);
+    EXPECT_EQ(numberOfTickTransactionsChunks, currentTickTransactionsChunk + NUMBER_OF_SPARE_TICK_TRANSACTIONS_CHUNKS + 1);
+
+    for (unsigned int tickOffset = 0; tickOffset < TEST_NUMBER_OF_TICKS; tickOffset++)
+    {
+        for (unsigned int transactionIndex = 0; transactionIndex < NUMBER_OF_TRANSACTIONS_PER_TICK; transactionIndex++)
+        {
+            const unsigned char* storedTransaction = getTickTransaction(tickOffset, transactionIndex);
+            if (transactionIndex % (1 + tickOffset % 3))
+            {
+                EXPECT_EQ(storedTransaction, nullptr);
+            }
+            else
+            {
+                ASSERT_NE(storedTransaction, nullptr);
+                EXPECT_EQ((unsigned long long)storedTransaction % TICK_TRANSACTIONS_ALIGNMENT, 0);
+                const unsigned int size = 144 + (tickOffset * 31 + transactionIndex) % 1024;
+                fillTransaction(transaction, size, tickOffset, transactionIndex);
+                EXPECT_EQ(memcmp(storedTransaction, transaction, size), 0) << "tick " << tickOffset << ", transaction " << transactionIndex;
+            }
+        }
+    }
+
+    deinitTickTransactions();
+}
@@ -0,0 +1,124 @@
+#define NO_UEFI
+
+#include "gtest/gtest.h"
+
+#include "../src/tick_votes.h"
+
+
+#define TEST_NUMBER_OF_TICKS 4
+
+struct TestTick
+{
+    unsigned short epoch;
+    m256i transactionDigest;
+    m256i expectedNextTickTransactionDigest;
+};
+
+static TestTick ticks[TEST_NUMBER_OF_TICKS * NUMBER_OF_COMPUTORS];
+
+struct TestComputorTicks
+{
+    const TestTick* ticks;
+
+    const m256i& transactionDigest(unsigned int computorIndex) const
+    {
+        return ticks[computorIndex].transactionDigest;
+    }
+
+    const m256i& expectedNextTickTransactionDigest(unsigned int computorIndex) const
+    {
+        return ticks[computorIndex].expectedNextTickTransactionDigest;
+    }
+};
+
+// Quorum state of the stored ticks counted the way the tick processor used to count it
+static void countVotes(const TestTick* computorTicks, unsigned short epoch, m256i TestTick::* digest, unsigned int& numberOfVotes, unsigned int& mostPopularDigestVotes, unsigned int& numberOfEmptyDigestVotes)
+{
+    numberOfVotes = 0;
+    mostPopularDigestVotes = 0;
+    numberOfEmptyDigestVotes = 0;
+    for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+    {
+        if (computorTicks[i].epoch == epoch)
+        {
+            numberOfVotes++;
+            if (isZero(computorTicks[i].*digest))
+            {
+                numberOfEmptyDigestVotes++;
+            }
+            unsigned int votes = 0;
+            for (unsigned int j = 0; j < NUMBER_OF_COMPUTORS; j++)
+            {
+                if (computorTicks[j].epoch == epoch && computorTicks[j].*digest == computorTicks[i].*digest)
+                {
+                    votes++;
+                }
+            }
+            if (votes > mostPopularDigestVotes)
+            {
+                mostPopularDigestVotes = votes;
+            }
+        }
+    }
+}
+
+TEST(TestCoreTickVotes, TalliesMatchRecount) {
+    ASSERT_TRUE(initTickVotes(TEST_NUMBER_OF_TICKS));
+
+    unsigned long long x = 0x243F6A8885A308D3;
+    for (unsigned short epoch = 1; epoch <= 2; epoch++)
+    {
+        for (unsigned int tickOffset = 0; tickOffset < TEST_NUMBER_OF_TICKS; tickOffset++)
+        {
+            TestTick* computorTicks = &ticks[tickOffset * NUMBER_OF_COMPUTORS];
+            const TestComputorTicks votedTicks = { computorTicks };
+            TickVoteQuorum transactionDigestQuorum, expectedNextTickTransactionDigestQuorum;
+            getTickVoteQuorums(tickOffset, epoch, votedTicks, transactionDigestQuorum, expectedNextTickTransactionDigestQuorum);
+            EXPECT_EQ(transactionDigestQuorum.numberOfVotes, 0);
+            EXPECT_EQ(numberOfTickVotes(tickOffset, epoch), 0);
+
+            // Computors vote in a shuffled order for a few competing digests (one of them empty), later ticks have more distinct digests
+            unsigned short order[NUMBER_OF_COMPUTORS];
+            for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+            {
+                order[i] = i;
+            }
+            for (unsigned int i = NUMBER_OF_COMPUTORS - 1; i > 0; i--)
+            {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                const unsigned int j = x % (i + 1);
+                const unsigned short tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+            }
+            const unsigned int numberOfDistinctDigests = 2 + tickOffset * 60;
+            for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+            {
+                const unsigned int computorIndex = order[i];
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                const unsigned int choice = (x & 3) ? 1 : (unsigned int)((x >> 2) % numberOfDistinctDigests);
+                computorTicks[computorIndex].epoch = epoch;
+                computorTicks[computorIndex].transactionDigest = m256i(choice, 0, epoch, choice ? 1 : 0);
+                computorTicks[computorIndex].expectedNextTickTransactionDigest = choice ? m256i(computorIndex % numberOfDistinctDigests, epoch, 0, 1) : m256i(0, 0, 0, 0);
+                addTickVotes(tickOffset, epoch, votedTicks, computorIndex);
+                if (i % 16 && i != NUMBER_OF_COMPUTORS - 1)
+                {
+                    continue;
+                }
+
+                getTickVoteQuorums(tickOffset, epoch, votedTicks, transactionDigestQuorum, expectedNextTickTransactionDigestQuorum);
+                unsigned int numberOfVotes, mostPopularDigestVotes, numberOfEmptyDigestVotes;
+                countVotes(computorTicks, epoch, &TestTick::transactionDigest, numberOfVotes, mostPopularDigestVotes, numberOfEmptyDigestVotes);
+                EXPECT_EQ(transactionDigestQuorum.numberOfVotes, numberOfVotes);
+                EXPECT_EQ(transactionDigestQuorum.mostPopularDigestVotes, mostPopularDigestVotes);
+                EXPECT_EQ(transactionDigestQuorum.numberOfEmptyDigestVotes, numberOfEmptyDigestVotes);
+                countVotes(computorTicks, epoch, &TestTick::expectedNextTickTransactionDigest, numberOfVotes, mostPopularDigestVotes, numberOfEmptyDigestVotes);
+                EXPECT_EQ(expectedNextTickTransactionDigestQuorum.numberOfVotes, numberOfVotes);
+                EXPECT_EQ(expectedNextTickTransactionDigestQuorum.mostPopularDigestVotes, mostPopularDigestVotes);
+                EXPECT_EQ(expectedNextTickTransactionDigestQuorum.numberOfEmptyDigestVotes, numberOfEmptyDigestVotes);
+            }
+            EXPECT_EQ(numberOfTickVotes(tickOffset, epoch), NUMBER_OF_COMPUTORS);
+            EXPECT_TRUE(transactionDigestQuorum.mostPopularDigest == m256i(1, 0, epoch, 1));
+        }
+    }
+
+    deinitTickVotes();
+}
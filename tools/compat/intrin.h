@@ -0,0 +1,67 @@
+#pragma once
+
+// Replacement for MSVC's <intrin.h> that allows to compile the core headers with GCC/Clang on Linux.
+// Only the subset used by the host tools in this directory is provided.
+
+#include <x86intrin.h>
+
+#define __int8 char
+#define __int16 short
+#define __int32 int
+#define __int64 long long
+
+static inline char _InterlockedCompareExchange8(volatile char* destination, char exchange, char comparand)
+{
+    return __sync_val_compare_and_swap(destination, comparand, exchange);
+}
+
+static inline long long _InterlockedIncrement64(volatile long long* addend)
+{
+    return __sync_add_and_fetch(addend, 1);
+}
+
+static inline long long _InterlockedDecrement64(volatile long long* addend)
+{
+    return __sync_sub_and_fetch(addend, 1);
+}
+
+static inline long long _InterlockedExchangeAdd64(volatile long long* addend, long long value)
+{
+    return __sync_fetch_and_add(addend, value);
+}
+
+static inline unsigned long long __popcnt64(unsigned long long value)
+{
+    return __builtin_popcountll(value);
+}
+
+static inline unsigned long long _umul128(unsigned long long multiplier, unsigned long long multiplicand, unsigned long long* highProduct)
+{
+    const unsigned __int128 product = (unsigned __int128)multiplier * multiplicand;
+    *highProduct = (unsigned long long)(product >> 64);
+    return (unsigned long long)product;
+}
+
+static inline unsigned long long __shiftleft128(unsigned long long lowPart, unsigned long long highPart, unsigned char shift)
+{
+    shift &= 63;
+    return shift ? (highPart << shift) | (lowPart >> (64 - shift)) : highPart;
+}
+
+static inline unsigned long long __shiftright128(unsigned long long lowPart, unsigned long long highPart, unsigned char shift)
+{
+    shift &= 63;
+    return shift ? (lowPart >> shift) | (highPart << (64 - shift)) : lowPart;
+}
+
+#define _XCR_XFEATURE_ENABLED_MASK 0
+
+static inline void __cpuidex(int cpuInfo[4], int function, int subfunction)
+{
+    __asm__ __volatile__("cpuid" : "=a"(cpuInfo[0]), "=b"(cpuInfo[1]), "=c"(cpuInfo[2]), "=d"(cpuInfo[3]) : "a"(function), "c"(subfunction));
+}
+
+static inline void __cpuid(int cpuInfo[4], int function)
+{
+    __cpuidex(cpuInfo, function, 0);
+}
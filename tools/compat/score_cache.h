@@ -0,0 +1,31 @@
+#pragma once
+
+// Host-side replacement for the score cache of the node. The host tools and tests score every solution, so the cache never hits
+// and keeps nothing; saving and loading the cache file is only done by the node.
+
+#include "../../src/platform/m256.h"
+
+#ifndef SCORE_CACHE_COLLISION_RETRIES
+#define SCORE_CACHE_COLLISION_RETRIES 20
+#endif
+
+template <unsigned int scoreCacheSize, unsigned int collisionRetries>
+struct ScoreCache
+{
+    static constexpr int MIN_VALID_SCORE = 0;
+
+    unsigned int getCacheIndex(const m256i& publicKey, const m256i& nonce)
+    {
+        return 0;
+    }
+
+    // Returns a score below MIN_VALID_SCORE as nothing is cached
+    int tryFetching(const m256i& publicKey, const m256i& nonce, unsigned int scoreCacheIndex)
+    {
+        return MIN_VALID_SCORE - 1;
+    }
+
+    void addEntry(const m256i& publicKey, const m256i& nonce, unsigned int scoreCacheIndex, int score)
+    {
+    }
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+// Host-side replacement for the contract math library of the node, only the subset used by score.h is provided.
+
+namespace math_lib
+{
+    template <typename T>
+    constexpr T max(const T& a, const T& b)
+    {
+        return a > b ? a : b;
+    }
+
+    template <typename T>
+    constexpr T min(const T& a, const T& b)
+    {
+        return a < b ? a : b;
+    }
+}
@@ -0,0 +1,352 @@
+#define NO_UEFI
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+#include "../../src/network/common_def.h"
+#include "../../src/network/transactions.h"
+#include "../../src/kangaroo_twelve.h"
+#include "../../src/four_q.h"
+
+////////// Crypto benchmarks \\\\\\\\\\
+
+// Throughput of the cryptographic primitives used by the node, followed by an estimate of the crypto time per tick.
+// Run with --benchmark_out=crypto_bench.json --benchmark_out_format=json to keep results for regression checks.
+// --isa=generic|avx2|avx512 limits the kernels to the given instruction set (default: best supported), so the variants
+// can be compared on one machine.
+// Reported counters:
+// - items_per_second: operations per second
+// - bytes_per_second: hashed or generated bytes per second (KangarooTwelveDigest, RandomBytes)
+// - cycles_per_op: TSC cycles per operation
+
+#define NUMBER_OF_BENCH_KEYS 64
+
+// Per-tick workload of the budget report
+#define BUDGET_TICK_DURATION_MS 3000 // TARGET_TICK_DURATION of the node
+#define BUDGET_MERKLE_UPDATES_PER_TRANSACTION (2 * (SPECTRUM_DEPTH + 1)) // Source and destination leaf plus their paths to the root
+
+static void setCyclesPerOp(benchmark::State& state, unsigned long long cycles)
+{
+    state.counters["cycles_per_op"] = benchmark::Counter((double)cycles, benchmark::Counter::kAvgIterations);
+}
+
+struct SignedDigests
+{
+    unsigned char subseeds[NUMBER_OF_BENCH_KEYS][32];
+    unsigned char privateKeys[NUMBER_OF_BENCH_KEYS][32];
+    unsigned char publicKeys[NUMBER_OF_BENCH_KEYS][32];
+    unsigned char digests[NUMBER_OF_BENCH_KEYS][32];
+    unsigned char signatures[NUMBER_OF_BENCH_KEYS][64];
+
+    SignedDigests()
+    {
+        for (unsigned int i = 0; i < NUMBER_OF_BENCH_KEYS; i++)
+        {
+            unsigned char seed[56];
+            for (unsigned int j = 0; j < 55; j++)
+            {
+                seed[j] = 'a' + (i * 11 + j * 5) % 26;
+            }
+            seed[55] = 0;
+            getSubseed(seed, subseeds[i]);
+            getPrivateKey(subseeds[i], privateKeys[i]);
+            getPublicKey(privateKeys[i], publicKeys[i]);
+            KangarooTwelve(seed, 55, digests[i], 32);
+            sign(subseeds[i], publicKeys[i], digests[i], signatures[i]);
+        }
+    }
+
+    static const SignedDigests& instance()
+    {
+        static SignedDigests signedDigests;
+        return signedDigests;
+    }
+};
+
+// verify() decoding the public key and building its tables every time
+static void Verify(benchmark::State& state)
+{
+    const SignedDigests& set = SignedDigests::instance();
+    unsigned int i = 0;
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(verify(set.publicKeys[i], set.digests[i], set.signatures[i]));
+        i = (i + 1) % NUMBER_OF_BENCH_KEYS;
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Verify);
+
+// verifyWithCachedKey() with the keys prepared in advance, as for known computors and recent senders
+static void VerifyWithCachedKey(benchmark::State& state)
+{
+    const SignedDigests& set = SignedDigests::instance();
+    static VerificationKey keys[NUMBER_OF_BENCH_KEYS];
+    for (unsigned int i = 0; i < NUMBER_OF_BENCH_KEYS; i++)
+    {
+        prepareVerificationKey(set.publicKeys[i], keys[i]);
+    }
+    unsigned int i = 0;
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(verifyWithCachedKey(keys[i], set.digests[i], set.signatures[i]));
+        i = (i + 1) % NUMBER_OF_BENCH_KEYS;
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(VerifyWithCachedKey);
+
+// verifyBatch() over batches of Arg signatures, items are signatures
+static void VerifyBatch(benchmark::State& state)
+{
+    const SignedDigests& set = SignedDigests::instance();
+    const unsigned int batchSize = (unsigned int)state.range(0);
+    const unsigned char* publicKeys[NUMBER_OF_BENCH_KEYS];
+    const unsigned char* digests[NUMBER_OF_BENCH_KEYS];
+    const unsigned char* signatures[NUMBER_OF_BENCH_KEYS];
+    for (unsigned int i = 0; i < NUMBER_OF_BENCH_KEYS; i++)
+    {
+        publicKeys[i] = set.publicKeys[i];
+        digests[i] = set.digests[i];
+        signatures[i] = set.signatures[i];
+    }
+    bool results[NUMBER_OF_BENCH_KEYS];
+    unsigned int i = 0;
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(verifyBatch(&publicKeys[i], &digests[i], &signatures[i], batchSize, results));
+        i = (i + batchSize) % (NUMBER_OF_BENCH_KEYS - batchSize);
+    }
+    setCyclesPerOp(state, (__rdtsc() - start) / batchSize);
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(VerifyBatch)->Arg(1)->Arg(4)->Arg(8)->Arg(12)->Arg(VERIFY_BATCH_SIZE);
+
+// prepareVerificationKey() alone, paid once per epoch for every computor and on every sender cache miss
+static void PrepareVerificationKey(benchmark::State& state)
+{
+    const SignedDigests& set = SignedDigests::instance();
+    VerificationKey key;
+    unsigned int i = 0;
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        prepareVerificationKey(set.publicKeys[i], key);
+        benchmark::DoNotOptimize(key);
+        i = (i + 1) % NUMBER_OF_BENCH_KEYS;
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(PrepareVerificationKey);
+
+static void Sign(benchmark::State& state)
+{
+    const SignedDigests& set = SignedDigests::instance();
+    unsigned char signature[64];
+    unsigned int i = 0;
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        sign(set.subseeds[i], set.publicKeys[i], set.digests[i], signature);
+        benchmark::DoNotOptimize(signature);
+        i = (i + 1) % NUMBER_OF_BENCH_KEYS;
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Sign);
+
+// Shared key of BroadcastMessage decryption without the shared key cache
+static void GetSharedKey(benchmark::State& state)
+{
+    const SignedDigests& set = SignedDigests::instance();
+    unsigned char sharedKey[32];
+    unsigned int i = 0;
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getSharedKey(set.privateKeys[0], set.publicKeys[i], sharedKey));
+        i = (i + 1) % NUMBER_OF_BENCH_KEYS;
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(GetSharedKey);
+
+static unsigned char benchInput[1 << 20];
+
+// Argument: input length (unsigned and signed transaction without input, 1 KiB, 1 chunk, 8 chunks and 1 MiB)
+static void KangarooTwelveDigest(benchmark::State& state)
+{
+    const unsigned int length = (unsigned int)state.range(0);
+    unsigned char digest[32];
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        KangarooTwelve(benchInput, length, digest, sizeof(digest));
+        benchmark::DoNotOptimize(digest);
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(KangarooTwelveDigest)->Arg(sizeof(Transaction))->Arg(sizeof(Transaction) + SIGNATURE_SIZE)->Arg(1024)->Arg(8192)->Arg(65536)->Arg(1 << 20);
+
+// One Merkle tree node of the spectrum, universe and computer digests
+static void KangarooTwelve64To32Node(benchmark::State& state)
+{
+    unsigned char digests[64];
+    memcpy(digests, benchInput, sizeof(digests));
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        KangarooTwelve64To32(digests, digests);
+        benchmark::DoNotOptimize(digests);
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(KangarooTwelve64To32Node);
+
+// Argument: output length (one permutation and 64 KiB)
+static void RandomBytes(benchmark::State& state)
+{
+    const unsigned int length = (unsigned int)state.range(0);
+    const SignedDigests& set = SignedDigests::instance();
+    const unsigned long long start = __rdtsc();
+    for (auto _ : state)
+    {
+        random(set.publicKeys[0], set.digests[0], benchInput, length);
+        benchmark::ClobberMemory();
+    }
+    setCyclesPerOp(state, __rdtsc() - start);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(RandomBytes)->Arg(200)->Arg(65536);
+
+// Console output plus the real time per operation of every benchmark, for the budget report
+class BudgetReporter : public benchmark::ConsoleReporter
+{
+public:
+    std::map<std::string, double> nanosecondsPerOp;
+
+    void ReportRuns(const std::vector<Run>& reports) override
+    {
+        for (const Run& run : reports)
+        {
+            if (!run.error_occurred)
+            {
+                nanosecondsPerOp[run.benchmark_name()] = run.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+            }
+        }
+        ConsoleReporter::ReportRuns(reports);
+    }
+};
+
+// Estimated crypto time of a tick with NUMBER_OF_TRANSACTIONS_PER_TICK transactions, from the measured primitives
+static void printTickBudget(const BudgetReporter& reporter)
+{
+    struct Item
+    {
+        const char* description;
+        const char* benchmarkName;
+        unsigned long long count;
+    };
+    const std::string signedTransaction = "KangarooTwelveDigest/" + std::to_string(sizeof(Transaction) + SIGNATURE_SIZE);
+    const std::string unsignedTransaction = "KangarooTwelveDigest/" + std::to_string(sizeof(Transaction));
+    const Item items[] = {
+        { "Tick signatures (cached computor keys)", "VerifyWithCachedKey", NUMBER_OF_COMPUTORS },
+        { "Transaction signed digests", unsignedTransaction.c_str(), NUMBER_OF_TRANSACTIONS_PER_TICK },
+        { "Transaction signatures (uncached senders)", "Verify", NUMBER_OF_TRANSACTIONS_PER_TICK },
+        { "Transaction digests", signedTransaction.c_str(), NUMBER_OF_TRANSACTIONS_PER_TICK },
+        { "Spectrum Merkle updates", "KangarooTwelve64To32Node", (unsigned long long)NUMBER_OF_TRANSACTIONS_PER_TICK * BUDGET_MERKLE_UPDATES_PER_TRANSACTION },
+    };
+
+    printf("\nCrypto budget per tick (%d transactions, %d computors):\n", NUMBER_OF_TRANSACTIONS_PER_TICK, NUMBER_OF_COMPUTORS);
+    printf("%-44s %10s %12s %12s\n", "", "count", "ns/op", "ms/tick");
+    double totalMilliseconds = 0;
+    for (const Item& item : items)
+    {
+        const auto it = reporter.nanosecondsPerOp.find(item.benchmarkName);
+        if (it == reporter.nanosecondsPerOp.end())
+        {
+            printf("%-44s %10llu %12s %12s\n", item.description, item.count, "not run", "");
+            continue;
+        }
+        const double milliseconds = it->second * item.count / 1e6;
+        totalMilliseconds += milliseconds;
+        printf("%-44s %10llu %12.1f %12.3f\n", item.description, item.count, it->second, milliseconds);
+    }
+    printf("%-44s %10s %12s %12.3f (%.2f%% of a %d ms tick on one core)\n", "Total", "", "", totalMilliseconds, totalMilliseconds * 100 / BUDGET_TICK_DURATION_MS, BUDGET_TICK_DURATION_MS);
+}
+
+int main(int argc, char** argv)
+{
+    detectCpuFeatures();
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strncmp(argv[i], "--isa=", 6))
+        {
+            const char* isa = argv[i] + 6;
+            if (!strcmp(isa, "generic"))
+            {
+                cpuFeatures.avx2 = false;
+                cpuFeatures.avx512 = false;
+                cpuFeatures.avx512Vpopcntdq = false;
+                cpuFeatures.avx512Ifma = false;
+            }
+            else if (!strcmp(isa, "avx2"))
+            {
+                cpuFeatures.avx512 = false;
+                cpuFeatures.avx512Vpopcntdq = false;
+                cpuFeatures.avx512Ifma = false;
+            }
+            else if (strcmp(isa, "avx512") || !cpuFeatures.avx512)
+            {
+                printf("Unsupported instruction set %s!\n", isa);
+                return 1;
+            }
+            for (int j = i; j < argc - 1; j++)
+            {
+                argv[j] = argv[j + 1];
+            }
+            argc--;
+            i--;
+        }
+    }
+    selectKangarooTwelveKernels();
+    selectFourQKernels();
+    printf("Kernels: Keccak-p[1600,12] %s%s, FourQ decomposition %s%s\n",
+        KeccakP1600_Permute_12rounds == KeccakP1600_Permute_12rounds_AVX512 ? "AVX-512" : (KeccakP1600_Permute_12rounds == KeccakP1600_Permute_12rounds_AVX2 ? "AVX2" : "generic"),
+        KangarooTwelve_Leaves4x ? " (K12 leaves 4-way AVX2)" : "",
+        decompose == decompose_AVX512 ? "AVX-512" : "generic",
+        ecc_mul_double_tables_8x ? " (verifyBatch 8-way AVX-512 IFMA)" : "");
+
+    for (unsigned int i = 0; i < sizeof(benchInput); i++)
+    {
+        benchInput[i] = (unsigned char)(i * 13 + (i >> 8));
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    BudgetReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    printTickBudget(reporter);
+    benchmark::Shutdown();
+
+    return 0;
+}
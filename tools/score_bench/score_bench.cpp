@@ -0,0 +1,200 @@
+#define NO_UEFI
+
+#include <cstdlib>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+
+#include "../../src/score.h"
+
+////////// Score benchmarks \\\\\\\\\\
+
+// Throughput of ScoreFunction for the production parameters and some scaled variants.
+// Run with --benchmark_out=score_bench.json --benchmark_out_format=json to keep results for regression checks.
+// Reported counters:
+// - items_per_second: scores per second (summed over all threads)
+// ScoreBatch/* runs scoreBatch() with the batch size given as argument.
+// - cycles_per_neuron_update: TSC cycles per single neuron update (per thread)
+// - bytes_per_second: estimated memory traffic of synapse generation, bit plane conversion and neuron updates
+
+template<
+    unsigned int dataLength,
+    unsigned int infoLength,
+    unsigned int numberOfInputNeurons,
+    unsigned int numberOfOutputNeurons,
+    unsigned int maxInputDuration,
+    unsigned int maxOutputDuration
+>
+struct ScoreBench
+{
+    typedef ScoreFunction<
+        dataLength, infoLength,
+        numberOfInputNeurons, numberOfOutputNeurons,
+        maxInputDuration, maxOutputDuration,
+        MAX_NUMBER_OF_PROCESSORS
+    > ScoreFunc;
+
+    static constexpr unsigned long long neuronUpdatesPerScore = (unsigned long long)maxInputDuration * (numberOfInputNeurons + infoLength)
+        + (unsigned long long)maxOutputDuration * (numberOfOutputNeurons + dataLength);
+
+    static constexpr unsigned long long bytesPerScore =
+        // the synapses are streamed from the random generator into the bit planes
+        sizeof(ScoreFunc::SolutionBuffer::synapses1Bit)
+        // every neuron update scans the positive and negative bit plane row of the neuron
+        + 2ULL * maxInputDuration * (numberOfInputNeurons + infoLength) * ScoreFunc::PADDED_SYNAPSE_CHUNK_SIZE_INPUT_BIT
+        + 2ULL * maxOutputDuration * (numberOfOutputNeurons + dataLength) * ScoreFunc::PADDED_SYNAPSE_CHUNK_SIZE_OUTPUT_BIT;
+
+    // One instance shared by all benchmark threads, each thread uses its own solution buffer
+    static ScoreFunc* instance()
+    {
+        static ScoreFunc* score = nullptr;
+        static volatile char lock = 0;
+        ACQUIRE(lock);
+        if (!score)
+        {
+            score = (ScoreFunc*)calloc(1, sizeof(ScoreFunc));
+            score->initMemory();
+            m256i randomSeed(0, 0, 0, 0);
+            randomSeed.m256i_u8[0] = RANDOM_SEED0;
+            randomSeed.m256i_u8[1] = RANDOM_SEED1;
+            randomSeed.m256i_u8[2] = RANDOM_SEED2;
+            randomSeed.m256i_u8[3] = RANDOM_SEED3;
+            randomSeed.m256i_u8[4] = RANDOM_SEED4;
+            randomSeed.m256i_u8[5] = RANDOM_SEED5;
+            randomSeed.m256i_u8[6] = RANDOM_SEED6;
+            randomSeed.m256i_u8[7] = RANDOM_SEED7;
+            score->initMiningData(randomSeed);
+        }
+        RELEASE(lock);
+        return score;
+    }
+
+    static void run(benchmark::State& state)
+    {
+        ScoreFunc* score = instance();
+        const unsigned long long processorNumber = state.thread_index();
+        const m256i publicKey(0x0123456789ABCDEFULL, processorNumber, 0, 0);
+
+        // Distinct nonces in every iteration so that the score cache never hits
+        m256i nonce(0, processorNumber, (unsigned long long)state.threads(), 0x5C0BE5C0BE5C0BEULL);
+        unsigned long long cycles = 0;
+        for (auto _ : state)
+        {
+            nonce.m256i_u64[0]++;
+            const unsigned long long start = __rdtsc();
+            benchmark::DoNotOptimize((*score)(processorNumber, publicKey, nonce));
+            cycles += __rdtsc() - start;
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * bytesPerScore);
+        state.counters["cycles_per_neuron_update"] = benchmark::Counter(double(cycles) / double(state.iterations() * neuronUpdatesPerScore), benchmark::Counter::kAvgThreads);
+    }
+
+    // Same as run() but scoring state.range(0) nonces per iteration with scoreBatch()
+    static void runBatch(benchmark::State& state)
+    {
+        ScoreFunc* score = instance();
+        const unsigned long long processorNumber = state.thread_index();
+        const unsigned int batchSize = (unsigned int)state.range(0);
+        m256i publicKeys[MAX_SCORE_BATCH_SIZE];
+        m256i nonces[MAX_SCORE_BATCH_SIZE];
+        unsigned int scores[MAX_SCORE_BATCH_SIZE];
+        for (unsigned int i = 0; i < batchSize; i++)
+        {
+            publicKeys[i] = m256i(0x0123456789ABCDEFULL, processorNumber, 0, 0);
+            nonces[i] = m256i(0, processorNumber, (unsigned long long)state.threads(), 0xBA7C4BA7C4BA7C4ULL + i);
+        }
+        unsigned long long cycles = 0;
+        for (auto _ : state)
+        {
+            for (unsigned int i = 0; i < batchSize; i++)
+            {
+                nonces[i].m256i_u64[0]++;
+            }
+            const unsigned long long start = __rdtsc();
+            score->scoreBatch(processorNumber, publicKeys, nonces, batchSize, scores);
+            cycles += __rdtsc() - start;
+            benchmark::DoNotOptimize(scores);
+        }
+
+        state.SetItemsProcessed(state.iterations() * batchSize);
+        state.SetBytesProcessed(state.iterations() * batchSize * bytesPerScore);
+        state.counters["cycles_per_neuron_update"] = benchmark::Counter(double(cycles) / double(state.iterations() * batchSize * neuronUpdatesPerScore), benchmark::Counter::kAvgThreads);
+    }
+};
+
+// Single-threaded and 2, 4, ... threads up to the number of cores (limited by the number of solution buffers)
+static void threadCounts(benchmark::internal::Benchmark* benchmark)
+{
+    unsigned int maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads > MAX_NUMBER_OF_PROCESSORS)
+    {
+        maxThreads = MAX_NUMBER_OF_PROCESSORS;
+    }
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+    {
+        benchmark->Threads(threads);
+    }
+    benchmark->Threads(maxThreads ? maxThreads : 1);
+    benchmark->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+// Production parameters
+BENCHMARK(ScoreBench<
+    DATA_LENGTH, INFO_LENGTH,
+    NUMBER_OF_INPUT_NEURONS, NUMBER_OF_OUTPUT_NEURONS,
+    MAX_INPUT_DURATION, MAX_OUTPUT_DURATION
+>::run)->Name("Score/Production")->Apply(threadCounts);
+
+// Production parameters with 1 to MAX_SCORE_BATCH_SIZE interleaved solutions per processor
+BENCHMARK(ScoreBench<
+    DATA_LENGTH, INFO_LENGTH,
+    NUMBER_OF_INPUT_NEURONS, NUMBER_OF_OUTPUT_NEURONS,
+    MAX_INPUT_DURATION, MAX_OUTPUT_DURATION
+>::runBatch)->Name("ScoreBatch/Production")->DenseRange(1, MAX_SCORE_BATCH_SIZE)->Apply(threadCounts);
+
+// Scaled variants
+BENCHMARK(ScoreBench<
+    1000, // DATA_LENGTH
+    1000, // INFO_LENGTH
+    1000, // NUMBER_OF_INPUT_NEURONS
+    1000, // NUMBER_OF_OUTPUT_NEURONS
+    200,  // MAX_INPUT_DURATION
+    200   // MAX_OUTPUT_DURATION
+>::run)->Name("Score/LengthNeurons1000Duration200")->Apply(threadCounts);
+
+BENCHMARK(ScoreBench<
+    512, // DATA_LENGTH
+    512, // INFO_LENGTH
+    512, // NUMBER_OF_INPUT_NEURONS
+    512, // NUMBER_OF_OUTPUT_NEURONS
+    100, // MAX_INPUT_DURATION
+    100  // MAX_OUTPUT_DURATION
+>::run)->Name("Score/LengthNeurons512Duration100")->Apply(threadCounts);
+
+BENCHMARK(ScoreBench<
+    2048, // DATA_LENGTH
+    2048, // INFO_LENGTH
+    2048, // NUMBER_OF_INPUT_NEURONS
+    2048, // NUMBER_OF_OUTPUT_NEURONS
+    200,  // MAX_INPUT_DURATION
+    200   // MAX_OUTPUT_DURATION
+>::run)->Name("Score/LengthNeurons2048Duration200")->Apply(threadCounts);
+
+int main(int argc, char** argv)
+{
+    detectCpuFeatures();
+    selectKangarooTwelveKernels();
+    selectScoreKernels();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,306 @@
+#define NO_UEFI
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../../src/network/common_def.h"
+#include "../../src/network/header.h"
+#include "../../src/network/broadcast_message.h"
+
+#include "../../src/kangaroo_twelve.h"
+#include "../../src/four_q.h"
+#include "../../src/score.h"
+
+////////// Score miner \\\\\\\\\\
+
+// Host-side nonce search using the same ScoreFunction as the node, so miner and verifier always agree.
+// Every search thread owns the solution buffers of one processor of the score function (thread index = processor number)
+// and scores batchSize (at most MAX_SCORE_BATCH_SIZE) nonces at a time with scoreBatch(). Whether interleaving pays off
+// depends on the caches and page size of the host, run ScoreBatch/Production of score_bench to pick the batch size.
+
+#define NONCE_BATCH_SIZE 64
+#define REPORT_PERIOD_MILLISECONDS 5000
+
+typedef ScoreFunction<
+    DATA_LENGTH, INFO_LENGTH,
+    NUMBER_OF_INPUT_NEURONS, NUMBER_OF_OUTPUT_NEURONS,
+    MAX_INPUT_DURATION, MAX_OUTPUT_DURATION,
+    MAX_NUMBER_OF_PROCESSORS
+> MinerScoreFunction;
+
+// Ready-to-send solution message: header, BroadcastMessage, gammed nonce and signature
+#pragma pack(push, 1)
+struct SolutionMessage
+{
+    RequestResponseHeader header;
+    BroadcastMessage message;
+    m256i gammedNonce;
+    unsigned char signature[SIGNATURE_SIZE];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SolutionMessage) == sizeof(RequestResponseHeader) + sizeof(BroadcastMessage) + 32 + SIGNATURE_SIZE, "Something is wrong with the struct size.");
+
+static MinerScoreFunction* score = nullptr;
+
+static m256i computorPublicKey;
+static unsigned int batchSize = 1;
+static bool hasMinerSeed = false;
+static unsigned char minerSubseed[32], minerPrivateKey[32], minerPublicKey[32];
+
+static std::atomic<bool> stopMining(false);
+static std::atomic<unsigned long long> numberOfScoredNonces(0);
+static std::atomic<unsigned long long> numberOfFoundSolutions(0);
+static volatile char outputLock = 0;
+
+static void printHex(const void* data, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++)
+    {
+        printf("%02x", ((const unsigned char*)data)[i]);
+    }
+}
+
+// Build a BroadcastMessage carrying the solution nonce for computorPublicKey, as processed by processBroadcastMessage()
+static bool buildSolutionMessage(const m256i& nonce, SolutionMessage& solutionMessage)
+{
+    setMem(&solutionMessage, sizeof(solutionMessage), 0);
+    solutionMessage.header.checkAndSetSize(sizeof(SolutionMessage));
+    solutionMessage.header.setType(BroadcastMessage::type);
+    solutionMessage.header.setDejavu(0);
+
+    unsigned char sharedKeyAndGammingNonce[64];
+    setMem(sharedKeyAndGammingNonce, 32, 0);
+    if (hasMinerSeed)
+    {
+        solutionMessage.message.sourcePublicKey = m256i(minerPublicKey);
+        if (!getSharedKey(minerPrivateKey, computorPublicKey.m256i_u8, sharedKeyAndGammingNonce))
+        {
+            return false;
+        }
+    }
+    solutionMessage.message.destinationPublicKey = computorPublicKey;
+
+    // The first byte of the gamming key selects the message type, so search for a gamming nonce yielding MESSAGE_TYPE_SOLUTION
+    unsigned char gammingKey[32];
+    do
+    {
+        solutionMessage.message.gammingNonce.setRandomValue();
+        copyMem(&sharedKeyAndGammingNonce[32], &solutionMessage.message.gammingNonce, 32);
+        KangarooTwelve64To32(sharedKeyAndGammingNonce, gammingKey);
+    } while (gammingKey[0] != MESSAGE_TYPE_SOLUTION);
+    setMem(sharedKeyAndGammingNonce, 32, 0);
+
+    unsigned char gamma[32];
+    KangarooTwelve(gammingKey, sizeof(gammingKey), gamma, sizeof(gamma));
+    for (unsigned int i = 0; i < 32; i++)
+    {
+        solutionMessage.gammedNonce.m256i_u8[i] = nonce.m256i_u8[i] ^ gamma[i];
+    }
+
+    if (hasMinerSeed)
+    {
+        m256i digest;
+        KangarooTwelve(&solutionMessage.message, sizeof(BroadcastMessage) + 32, &digest, sizeof(digest));
+        sign(minerSubseed, minerPublicKey, digest.m256i_u8, solutionMessage.signature);
+    }
+
+    return true;
+}
+
+static void reportSolution(const m256i& nonce, unsigned int solutionScore)
+{
+    SolutionMessage solutionMessage;
+    const bool ok = buildSolutionMessage(nonce, solutionMessage);
+
+    ACQUIRE(outputLock);
+    printf("Solution: score = %u, nonce = ", solutionScore);
+    printHex(&nonce, sizeof(nonce));
+    if (ok)
+    {
+        printf(", message = ");
+        printHex(&solutionMessage, sizeof(solutionMessage));
+        printf("\n");
+    }
+    else
+    {
+        printf(", cannot derive shared key with the computor!\n");
+    }
+    fflush(stdout);
+    RELEASE(outputLock);
+}
+
+static void searchThread(unsigned int threadIndex)
+{
+    m256i nonces[NONCE_BATCH_SIZE];
+    m256i publicKeys[MAX_SCORE_BATCH_SIZE];
+    unsigned int solutionScores[MAX_SCORE_BATCH_SIZE];
+    for (unsigned int i = 0; i < MAX_SCORE_BATCH_SIZE; i++)
+    {
+        publicKeys[i] = computorPublicKey;
+    }
+    m256i baseNonce;
+    baseNonce.setRandomValue();
+    unsigned long long counter = 0;
+
+    while (!stopMining)
+    {
+        for (unsigned int i = 0; i < NONCE_BATCH_SIZE; i++)
+        {
+            nonces[i] = baseNonce;
+            nonces[i].m256i_u64[0] += counter++;
+        }
+
+        for (unsigned int i = 0; i < NONCE_BATCH_SIZE; i += batchSize)
+        {
+            const unsigned int n = NONCE_BATCH_SIZE - i < batchSize ? NONCE_BATCH_SIZE - i : batchSize;
+            score->scoreBatch(threadIndex, publicKeys, &nonces[i], n, solutionScores);
+            for (unsigned int j = 0; j < n; j++)
+            {
+                if (solutionScores[j] >= SOLUTION_THRESHOLD)
+                {
+                    numberOfFoundSolutions++;
+                    reportSolution(nonces[i + j], solutionScores[j]);
+                }
+            }
+            numberOfScoredNonces += n;
+        }
+    }
+}
+
+static void printUsage(const char* programName)
+{
+    printf("Usage: %s <COMPUTOR_IDENTITY> [-t threads] [-b batch_size] [-d seconds] [-s miner_seed]\n", programName);
+    printf("  -t  number of search threads (default: number of cores, max %d)\n", MAX_NUMBER_OF_PROCESSORS);
+    printf("  -b  number of nonces interleaved by each thread (default: 1, max %d)\n", MAX_SCORE_BATCH_SIZE);
+    printf("  -d  stop after this many seconds (default: run until killed)\n");
+    printf("  -s  55-char seed used to sign the solution messages (default: anonymous zero source key)\n");
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (strlen(argv[1]) < 60 || !getPublicKeyFromIdentity((const unsigned char*)argv[1], computorPublicKey.m256i_u8))
+    {
+        printf("Invalid computor identity!\n");
+        return 1;
+    }
+
+    unsigned int numberOfThreads = std::thread::hardware_concurrency();
+    unsigned long long durationSeconds = 0;
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "-t"))
+        {
+            numberOfThreads = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "-b"))
+        {
+            batchSize = atoi(argv[i + 1]);
+            if (batchSize < 1 || batchSize > MAX_SCORE_BATCH_SIZE)
+            {
+                printf("Invalid batch size!\n");
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "-d"))
+        {
+            durationSeconds = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "-s"))
+        {
+            if (strlen(argv[i + 1]) != 55 || !getSubseed((const unsigned char*)argv[i + 1], minerSubseed))
+            {
+                printf("Invalid miner seed!\n");
+                return 1;
+            }
+            getPrivateKey(minerSubseed, minerPrivateKey);
+            getPublicKey(minerPrivateKey, minerPublicKey);
+            hasMinerSeed = true;
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (!numberOfThreads)
+    {
+        numberOfThreads = 1;
+    }
+    if (numberOfThreads > MAX_NUMBER_OF_PROCESSORS)
+    {
+        numberOfThreads = MAX_NUMBER_OF_PROCESSORS;
+    }
+
+    detectCpuFeatures();
+    selectKangarooTwelveKernels();
+    selectFourQKernels();
+    selectScoreKernels();
+
+    // calloc() zeroes the score cache, solution buffers are allocated by the first scoreBatch() call of each thread
+    score = (MinerScoreFunction*)calloc(1, sizeof(MinerScoreFunction));
+    if (!score)
+    {
+        printf("Cannot allocate %llu bytes for the score function!\n", (unsigned long long)sizeof(MinerScoreFunction));
+        return 1;
+    }
+    score->initMemory();
+    m256i randomSeed(0, 0, 0, 0);
+    randomSeed.m256i_u8[0] = RANDOM_SEED0;
+    randomSeed.m256i_u8[1] = RANDOM_SEED1;
+    randomSeed.m256i_u8[2] = RANDOM_SEED2;
+    randomSeed.m256i_u8[3] = RANDOM_SEED3;
+    randomSeed.m256i_u8[4] = RANDOM_SEED4;
+    randomSeed.m256i_u8[5] = RANDOM_SEED5;
+    randomSeed.m256i_u8[6] = RANDOM_SEED6;
+    randomSeed.m256i_u8[7] = RANDOM_SEED7;
+    score->initMiningData(randomSeed);
+
+    printf("Mining for %s with %u threads, batch size %u (solution threshold %d, %s source key)\n", argv[1], numberOfThreads, batchSize, SOLUTION_THRESHOLD, hasMinerSeed ? "signed" : "anonymous");
+    fflush(stdout);
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < numberOfThreads; i++)
+    {
+        threads.emplace_back(searchThread, i);
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    auto prevReportTime = startTime;
+    unsigned long long prevNumberOfScoredNonces = 0;
+    while (!durationSeconds || std::chrono::steady_clock::now() - startTime < std::chrono::seconds(durationSeconds))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(REPORT_PERIOD_MILLISECONDS));
+
+        const auto now = std::chrono::steady_clock::now();
+        const unsigned long long scoredNonces = numberOfScoredNonces;
+        const double seconds = std::chrono::duration<double>(now - prevReportTime).count();
+        ACQUIRE(outputLock);
+        printf("%.1f hashes/sec, %llu hashes total, %llu solutions\n", (scoredNonces - prevNumberOfScoredNonces) / seconds, scoredNonces, (unsigned long long)numberOfFoundSolutions);
+        fflush(stdout);
+        RELEASE(outputLock);
+        prevReportTime = now;
+        prevNumberOfScoredNonces = scoredNonces;
+    }
+
+    stopMining = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    score->freeMemory();
+    free(score);
+
+    return 0;
+}